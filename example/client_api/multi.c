@@ -276,6 +276,12 @@ int main(int argc, char* argv[])
                     goto error;
             }
             else if (hresult == 0) {
+                // Searches may converge without client involvement,
+                // e.g., through cache hits.
+                if (ah_converged(sinfo->htask)) {
+                    sinfo->state = TASK_STATE_CONVERGED;
+                    continue;
+                }
                 fprintf(stderr, "Waiting for point on #%d.\n", sinfo->id);
                 sleep(1);
                 --i;
@@ -287,7 +293,7 @@ int main(int argc, char* argv[])
         shuffle(order);
         for (int i = 0; i < MAX_RUNNING_TASKS; ++i) {
             int idx = order[i];
-            if (!slist[idx].htask)
+            if (!slist[idx].htask || slist[idx].state != TASK_STATE_RUNNING)
                 continue;
 
             sinfo_t* sinfo = &slist[idx];
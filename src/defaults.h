@@ -60,6 +60,30 @@
 #define CFGKEY_DIST_TOL           "DIST_TOL"
 #define CFGKEY_TOL_CNT            "TOL_CNT"
 #define CFGKEY_REJECT_METHOD      "REJECT_METHOD"
+#define CFGKEY_PRO_ASYNC          "PRO_ASYNC"
+#define CFGKEY_BAYES_INIT         "BAYES_INIT"
+#define CFGKEY_BAYES_ACQUISITION  "BAYES_ACQUISITION"
+#define CFGKEY_BAYES_KAPPA        "BAYES_KAPPA"
+#define CFGKEY_BAYES_LIAR         "BAYES_LIAR"
+#define CFGKEY_BAYES_SAMPLES      "BAYES_SAMPLES"
+#define CFGKEY_CMAES_LAMBDA       "CMAES_LAMBDA"
+#define CFGKEY_DE_POPULATION      "DE_POPULATION"
+#define CFGKEY_DE_F               "DE_F"
+#define CFGKEY_DE_CR              "DE_CR"
+#define CFGKEY_HYPERBAND_ETA      "HYPERBAND_ETA"
+#define CFGKEY_HYPERBAND_MIN_BUDGET "HYPERBAND_MIN_BUDGET"
+#define CFGKEY_HYPERBAND_BRACKETS "HYPERBAND_BRACKETS"
+#define CFGKEY_SAMPLE_METHOD      "SAMPLE_METHOD"
+#define CFGKEY_SAMPLE_SIZE        "SAMPLE_SIZE"
+#define CFGKEY_EXHAUSTIVE_STATE   "EXHAUSTIVE_STATE"
+#define CFGKEY_EXHAUSTIVE_BLOCK   "EXHAUSTIVE_BLOCK"
+#define CFGKEY_EXHAUSTIVE_TIMEOUT "EXHAUSTIVE_TIMEOUT"
+#define CFGKEY_PORTFOLIO_LIST     "PORTFOLIO_LIST"
+#define CFGKEY_PORTFOLIO_DISCOUNT "PORTFOLIO_DISCOUNT"
+#define CFGKEY_PORTFOLIO_EXPLORE  "PORTFOLIO_EXPLORE"
+#define CFGKEY_NM_STARTS          "NM_STARTS"
+#define CFGKEY_NM_RESTARTS        "NM_RESTARTS"
+#define CFGKEY_GPS_STEP           "GPS_STEP"
 #define CFGKEY_ANGEL_LOOSE        "ANGEL_LOOSE"
 #define CFGKEY_ANGEL_MULT         "ANGEL_MULT"
 #define CFGKEY_ANGEL_ANCHOR       "ANGEL_ANCHOR"
@@ -68,16 +92,23 @@
 #define CFGKEY_ANGEL_PHASE        "ANGEL_PHASE"
 
 // Plug-in layer configuration variables.
+#define CFGKEY_AGG_CONFIDENCE     "AGG_CONFIDENCE"
 #define CFGKEY_AGG_FUNC           "AGG_FUNC"
+#define CFGKEY_AGG_MIN_TIMES      "AGG_MIN_TIMES"
+#define CFGKEY_AGG_PRECISION      "AGG_PRECISION"
 #define CFGKEY_AGG_TIMES          "AGG_TIMES"
+#define CFGKEY_CACHE_DB           "CACHE_DB"
 #define CFGKEY_CACHE_FILE         "CACHE_FILE"
+#define CFGKEY_CACHE_SHARED       "CACHE_SHARED"
 #define CFGKEY_GROUP_LIST         "GROUP_LIST"
 #define CFGKEY_LOG_FILE           "LOG_FILE"
+#define CFGKEY_LOG_FORMAT         "LOG_FORMAT"
 #define CFGKEY_LOG_MODE           "LOG_MODE"
 #define CFGKEY_OC_BIN             "OC_BIN"
 #define CFGKEY_OC_CONSTRAINTS     "OC_CONSTRAINTS"
 #define CFGKEY_OC_FILE            "OC_FILE"
 #define CFGKEY_OC_QUIET           "OC_QUIET"
+#define CFGKEY_OC_REPAIR          "OC_REPAIR"
 #define CFGKEY_TAUDB_NAME         "TAUDB_NAME"
 #define CFGKEY_TAUDB_STORE_METHOD "TAUDB_STORE_METHOD"
 #define CFGKEY_TAUDB_STORE_NUM    "TAUDB_STORE_NUM"
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const harena_t harena_zero = HARENA_INITIALIZER;
+
+#define BLOCK_SIZE 65536 // Default size of memory blocks.
+#define ALIGNMENT  16    // Alignment of all sized allocations.
+#define SLAB_MIN   16    // Size of the smallest slab size class.
+
+/*
+ * Header of each memory block managed by an arena.
+ */
+typedef union harena_block {
+    union harena_block* next;
+    char pad[ALIGNMENT];
+} harena_block_t;
+
+/*
+ * Internal helper function prototypes.
+ */
+static int      slab_class(size_t size);
+static void*    block_alloc(harena_t* arena, size_t size);
+static unsigned str_hash(const char* str);
+static int      str_slot(const harena_t* arena, const char* str,
+                         unsigned hash);
+static int      str_rehash(harena_t* arena, int len);
+
+/*
+ * Arena memory management implementation.
+ */
+void* harena_alloc(harena_t* arena, size_t size)
+{
+    int class = slab_class(size);
+
+    if (class < 0) {
+        // Allocations too large for a slab receive a dedicated block.
+        harena_block_t* block = malloc(sizeof(*block) + size);
+        if (!block)
+            return NULL;
+
+        block->next = arena->block;
+        arena->block = block;
+        return block + 1;
+    }
+
+    // Recycle previously freed memory of the same size class.
+    void* retval = arena->slab[class];
+    if (retval) {
+        arena->slab[class] = *(void**)retval;
+        return retval;
+    }
+
+    // Otherwise, carve aligned memory from the current block.
+    size_t pad = (size_t)arena->next % ALIGNMENT;
+    if (pad) {
+        pad = ALIGNMENT - pad;
+        if (arena->avail >= pad) {
+            arena->next  += pad;
+            arena->avail -= pad;
+        }
+        else {
+            arena->avail = 0;
+        }
+    }
+    return block_alloc(arena, (size_t)SLAB_MIN << class);
+}
+
+/*
+ * Return memory to the arena for reuse.  The size must match the
+ * size used to allocate it.  Memory too large for any slab size class
+ * is held until the arena is finalized.
+ */
+void harena_free(harena_t* arena, void* ptr, size_t size)
+{
+    int class = slab_class(size);
+
+    if (!ptr || class < 0)
+        return;
+
+    *(void**)ptr = arena->slab[class];
+    arena->slab[class] = ptr;
+}
+
+char* harena_strdup(harena_t* arena, const char* str)
+{
+    // Keep the hash set at most half full.
+    if (2 * (arena->str_len + 1) > arena->str_cap) {
+        if (str_rehash(arena, arena->str_len + 1) != 0)
+            return NULL;
+    }
+
+    int slot = str_slot(arena, str, str_hash(str));
+    if (arena->str[slot])
+        return arena->str[slot];
+
+    size_t len = strlen(str) + 1;
+    char*  retval;
+
+    if (len > BLOCK_SIZE / 4)
+        retval = harena_alloc(arena, len);
+    else
+        retval = block_alloc(arena, len);
+
+    if (retval) {
+        memcpy(retval, str, len);
+        arena->str[slot] = retval;
+        ++arena->str_len;
+    }
+    return retval;
+}
+
+void harena_fini(harena_t* arena)
+{
+    while (arena->block) {
+        harena_block_t* next = arena->block->next;
+        free(arena->block);
+        arena->block = next;
+    }
+    free(arena->str);
+    *arena = harena_zero;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+int slab_class(size_t size)
+{
+    int class = 0;
+    size_t class_size = SLAB_MIN;
+
+    while (class_size < size) {
+        class_size <<= 1;
+        ++class;
+    }
+    return (class < HARENA_SLAB_COUNT) ? class : -1;
+}
+
+void* block_alloc(harena_t* arena, size_t size)
+{
+    if (arena->avail < size) {
+        harena_block_t* block = malloc(sizeof(*block) + BLOCK_SIZE);
+        if (!block)
+            return NULL;
+
+        block->next  = arena->block;
+        arena->block = block;
+        arena->next  = (char*)(block + 1);
+        arena->avail = BLOCK_SIZE;
+    }
+
+    void* retval = arena->next;
+    arena->next  += size;
+    arena->avail -= size;
+    return retval;
+}
+
+unsigned str_hash(const char* str)
+{
+    unsigned hash = 2166136261u;
+
+    while (*str) {
+        hash ^= (unsigned char) *(str++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Return the hash set slot which holds the given string, or the empty
+ * slot where it would be inserted.
+ */
+int str_slot(const harena_t* arena, const char* str, unsigned hash)
+{
+    unsigned mask = arena->str_cap - 1;
+    unsigned slot = hash & mask;
+
+    while (arena->str[slot] && strcmp(arena->str[slot], str) != 0)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+/*
+ * Grow the hash set so that it may hold at least len strings.
+ */
+int str_rehash(harena_t* arena, int len)
+{
+    int cap = arena->str_cap ? arena->str_cap : 16;
+    while (cap < 2 * len)
+        cap *= 2;
+
+    if (cap == arena->str_cap)
+        return 0;
+
+    char** newbuf = calloc(cap, sizeof(*newbuf));
+    if (!newbuf)
+        return -1;
+
+    char** oldbuf = arena->str;
+    int oldcap = arena->str_cap;
+
+    arena->str = newbuf;
+    arena->str_cap = cap;
+    for (int i = 0; i < oldcap; ++i) {
+        if (oldbuf[i])
+            arena->str[ str_slot(arena, oldbuf[i], str_hash(oldbuf[i])) ]
+                = oldbuf[i];
+    }
+    free(oldbuf);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HARENA_H__
+#define __HARENA_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HARENA_SLAB_COUNT 10 // Size classes from 16 to 8192 bytes.
+
+/*
+ * Harmony structure that manages a region of memory whose contents
+ * share a common lifetime.
+ *
+ * Small allocations are carved from large blocks and recycled through
+ * per-size-class free lists.  Strings are interned, so each distinct
+ * string is stored once no matter how often it is copied into the
+ * arena.  All memory is returned to the system at once by
+ * harena_fini().
+ */
+typedef struct harena {
+    union harena_block* block;
+    char*  next;
+    size_t avail;
+    void*  slab[HARENA_SLAB_COUNT];
+
+    // Open-addressing hash set of interned strings.
+    char** str;
+    int    str_len, str_cap;
+} harena_t;
+
+#define HARENA_INITIALIZER {0}
+extern const harena_t harena_zero;
+
+/*
+ * Arena memory management interface.
+ */
+void* harena_alloc(harena_t* arena, size_t size);
+void  harena_free(harena_t* arena, void* ptr, size_t size);
+char* harena_strdup(harena_t* arena, const char* str);
+void  harena_fini(harena_t* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -32,6 +32,29 @@
 
 const hcfg_t hcfg_zero = HCFG_INITIALIZER;
 
+/*
+ * Structure that represents a single configuration key/value pair.
+ *
+ * Entries beyond the configuration length may hold an unused (but
+ * still allocated) buffer, which is recycled by the next insertion.
+ */
+typedef struct hcfg_entry {
+    char*    pair;   // Key/value string of the form "key=val".
+    int      cap;    // Allocated size of pair, or 0 if not owned.
+    int      keylen; // Length of the key portion of pair.
+    unsigned hash;   // Hash of the key portion of pair.
+
+    // Cache of parsed scalar values.
+    unsigned cached;
+    int      val_bool;
+    long     val_int;
+    double   val_real;
+} hcfg_entry_t;
+
+#define CACHED_BOOL 0x1
+#define CACHED_INT  0x2
+#define CACHED_REAL 0x4
+
 /*
  * Default values for configuration variables.
  */
@@ -65,23 +88,29 @@ const hcfg_info_t hcfg_global_keys[] = {
 /*
  * Internal helper function prototypes.
  */
-static void   free_data(hcfg_t* cfg);
-static int    key_find(const hcfg_t* cfg, const char* key, char** val);
-static char*  key_val(const hcfg_t* cfg, const char* key);
-static char*  key_val_index(const hcfg_t* cfg, const char* key, int idx);
-static int    key_add(hcfg_t* cfg, char* pair);
-static void   key_del(hcfg_t* cfg, const char* key);
-static int    copy_keyval(const char* buf, char** keyval, const char** errptr);
+static void          free_data(hcfg_t* cfg);
+static unsigned      key_hash(const char* key, int* keylen);
+static int           key_slot(const hcfg_t* cfg, const char* key,
+                              int keylen, unsigned hash);
+static hcfg_entry_t* key_find(const hcfg_t* cfg, const char* key);
+static char*         key_val(const hcfg_t* cfg, const char* key);
+static char*         key_val_index(const hcfg_t* cfg, const char* key,
+                                   int idx);
+static int           key_add(hcfg_t* cfg, const char* key, int keylen,
+                             const char* val);
+static int           key_add_pair(hcfg_t* cfg, const char* pair);
+static void          key_del(hcfg_t* cfg, const char* key);
+static int           index_build(hcfg_t* cfg, int len);
+static int           copy_keyval(const char* buf, char** keyval,
+                                 const char** errptr);
 
 /*
  * Basic structure management implementation.
  */
 int hcfg_init(hcfg_t* cfg)
 {
-    cfg->len = 0;
-    cfg->cap = 32;
-    cfg->env = malloc(cfg->cap * sizeof(*cfg->env));
-    if (!cfg->env)
+    *cfg = hcfg_zero;
+    if (index_build(cfg, 32) != 0)
         return -1;
 
     return hcfg_reginfo(cfg, hcfg_global_keys);
@@ -94,9 +123,7 @@ int hcfg_loadenv(hcfg_t* cfg)
     // Incorporate environment variables into current configuration.
     for (int i = 0; environ[i]; ++i) {
         if (valid_id(environ[i], strcspn(environ[i], "="))) {
-            char* pair = stralloc( environ[i] );
-
-            if (!pair || key_add(cfg, pair) != 0)
+            if (key_add_pair(cfg, environ[i]) != 0)
                 return -1;
         }
     }
@@ -120,21 +147,16 @@ int hcfg_reginfo(hcfg_t* cfg, const hcfg_info_t* info)
 
 int hcfg_copy(hcfg_t* dst, const hcfg_t* src)
 {
-    // Free heap data allocated by the destination structure.
-    free_data(dst);
-
-    if (dst->cap < src->cap) {
-        char** newbuf = realloc(dst->env, src->cap * sizeof(*dst->env));
-        if (!newbuf)
-            return -1;
+    // Existing destination buffers are recycled by key_add().
+    dst->len = 0;
+    if (index_build(dst, src->len) != 0)
+        return -1;
 
-        dst->env = newbuf;
-        dst->cap = src->cap;
-    }
+    for (int i = 0; i < src->len; ++i) {
+        const hcfg_entry_t* entry = &src->env[i];
 
-    for (dst->len = 0; dst->len < src->len; ++dst->len) {
-        dst->env[ dst->len ] = stralloc( src->env[ dst->len ] );
-        if (!dst->env[ dst->len ])
+        if (key_add(dst, entry->pair, entry->keylen,
+                    entry->pair + entry->keylen + 1) != 0)
             return -1;
     }
     return 0;
@@ -142,20 +164,11 @@ int hcfg_copy(hcfg_t* dst, const hcfg_t* src)
 
 int hcfg_merge(hcfg_t* dst, const hcfg_t* src)
 {
-    int newlen = dst->len + src->len;
-
-    if (dst->cap < newlen) {
-        char** newbuf = realloc(dst->env, newlen * sizeof(*dst->env));
-        if (!newbuf)
-            return -1;
-
-        dst->env = newbuf;
-        dst->cap = newlen;
-    }
-
     for (int i = 0; i < src->len; ++i) {
-        char* pair = stralloc(src->env[i]);
-        if (!pair || key_add(dst, pair) != 0)
+        const hcfg_entry_t* entry = &src->env[i];
+
+        if (key_add(dst, entry->pair, entry->keylen,
+                    entry->pair + entry->keylen + 1) != 0)
             return -1;
     }
     return 0;
@@ -165,11 +178,12 @@ void hcfg_fini(hcfg_t* cfg)
 {
     free_data(cfg);
     free(cfg->env);
+    free(cfg->index);
 }
 
 void hcfg_scrub(hcfg_t* cfg)
 {
-    free(cfg->env);
+    hcfg_fini(cfg);
 }
 
 /*
@@ -182,12 +196,12 @@ char* hcfg_get(const hcfg_t* cfg, const char* key)
 
 int hcfg_set(hcfg_t* cfg, const char* key, const char* val)
 {
-    if (!valid_id(key, strlen(key)))
+    int keylen = strlen(key);
+    if (!valid_id(key, keylen))
         return -1;
 
     if (val) {
-        char* pair = sprintf_alloc("%s=%s", key, val);
-        return key_add(cfg, pair);
+        return key_add(cfg, key, keylen, val);
     }
     else {
         key_del(cfg, key);
@@ -200,17 +214,41 @@ int hcfg_set(hcfg_t* cfg, const char* key, const char* val)
  */
 int hcfg_bool(const hcfg_t* cfg, const char* key)
 {
-    return hcfg_parse_bool( key_val(cfg, key) );
+    hcfg_entry_t* entry = key_find(cfg, key);
+    if (!entry)
+        return hcfg_parse_bool(NULL);
+
+    if (!(entry->cached & CACHED_BOOL)) {
+        entry->val_bool = hcfg_parse_bool(entry->pair + entry->keylen + 1);
+        entry->cached |= CACHED_BOOL;
+    }
+    return entry->val_bool;
 }
 
 long hcfg_int(const hcfg_t* cfg, const char* key)
 {
-    return hcfg_parse_int( key_val(cfg, key) );
+    hcfg_entry_t* entry = key_find(cfg, key);
+    if (!entry)
+        return hcfg_parse_int(NULL);
+
+    if (!(entry->cached & CACHED_INT)) {
+        entry->val_int = hcfg_parse_int(entry->pair + entry->keylen + 1);
+        entry->cached |= CACHED_INT;
+    }
+    return entry->val_int;
 }
 
 double hcfg_real(const hcfg_t* cfg, const char* key)
 {
-    return hcfg_parse_real( key_val(cfg, key) );
+    hcfg_entry_t* entry = key_find(cfg, key);
+    if (!entry)
+        return hcfg_parse_real(NULL);
+
+    if (!(entry->cached & CACHED_REAL)) {
+        entry->val_real = hcfg_parse_real(entry->pair + entry->keylen + 1);
+        entry->cached |= CACHED_REAL;
+    }
+    return entry->val_real;
 }
 
 /*
@@ -292,7 +330,7 @@ int hcfg_pack(char** buf, int* buflen, const hcfg_t* cfg)
     total = count;
 
     for (int i = 0; i < cfg->len; ++i) {
-        count = printstr_serial(buf, buflen, cfg->env[i]);
+        count = printstr_serial(buf, buflen, cfg->env[i].pair);
         if (count < 0) goto invalid;
         total += count;
     }
@@ -305,24 +343,44 @@ int hcfg_pack(char** buf, int* buflen, const hcfg_t* cfg)
 
 int hcfg_unpack(hcfg_t* cfg, char* buf)
 {
-    int total = 0;
-    sscanf(buf, " cfg:%d%n", &cfg->len, &total);
-    if (!total)
+    int len, total = 0;
+    sscanf(buf, " cfg:%d%n", &len, &total);
+    if (!total || len < 0)
         goto invalid;
 
-    if (cfg->cap < cfg->len) {
-        char** newbuf = realloc(cfg->env, cfg->len * sizeof(*cfg->env));
+    // Unpacked key/value strings point directly into the message
+    // buffer, so any buffers held from prior use are released.
+    //
+    free_data(cfg);
+    cfg->len = 0;
+    if (index_build(cfg, len) != 0)
+        return -1;
+
+    if (cfg->cap < len) {
+        hcfg_entry_t* newbuf = realloc(cfg->env, len * sizeof(*cfg->env));
         if (!newbuf)
             return -1;
 
         cfg->env = newbuf;
-        cfg->cap = cfg->len;
+        cfg->cap = len;
     }
+    memset(cfg->env, 0, cfg->cap * sizeof(*cfg->env));
 
-    for (int i = 0; i < cfg->len; ++i) {
-        int count = scanstr_serial((const char**)&cfg->env[i], buf + total);
+    for (int i = 0; i < len; ++i) {
+        const char* pair;
+        int count = scanstr_serial(&pair, buf + total);
         if (count < 0) goto invalid;
         total += count;
+
+        if (!pair || pair[strcspn(pair, "=")] != '=')
+            goto invalid;
+
+        hcfg_entry_t* entry = &cfg->env[i];
+        entry->pair = (char*) pair;
+        entry->hash = key_hash(pair, &entry->keylen);
+
+        cfg->index[ key_slot(cfg, pair, entry->keylen, entry->hash) ] = i;
+        cfg->len = i + 1;
     }
     return total;
 
@@ -354,10 +412,12 @@ int hcfg_parse(hcfg_t* cfg, const char* buf, const char** errptr)
     if (copy_keyval(buf, &keyval, errptr) != 0)
         return -1;
 
-    if (key_add(cfg, keyval)) {
+    if (key_add_pair(cfg, keyval) != 0) {
+        free(keyval);
         errstr = "Could not insert key/val pair";
         goto error;
     }
+    free(keyval);
     return 1;
 
   error:
@@ -378,12 +438,13 @@ int hcfg_write(const hcfg_t* cfg, const char* filename)
     }
 
     for (int i = 0; i < cfg->len; ++i) {
-        char* ptr = strchr(cfg->env[i], '=');
-        int   end = strlen(ptr) - 1;
-        char* quote = cfg->env[i] + strcspn(cfg->env[i], "#'\"\n\\");
+        char* pair  = cfg->env[i].pair;
+        char* ptr   = pair + cfg->env[i].keylen;
+        int   end   = strlen(ptr) - 1;
+        char* quote = pair + strcspn(pair, "#'\"\n\\");
 
         if (isspace(ptr[1]) || isspace(ptr[end]) || *quote) {
-            fprintf(fp, "%.*s=\"", (int)(ptr - cfg->env[i]), cfg->env[i]);
+            fprintf(fp, "%.*s=\"", cfg->env[i].keylen, pair);
             ++ptr;
             while (*ptr) {
                 int span = strcspn(ptr, "\"\\");
@@ -397,7 +458,7 @@ int hcfg_write(const hcfg_t* cfg, const char* filename)
             fprintf(fp, "\"\n");
         }
         else {
-            fprintf(fp, "%s\n", cfg->env[i]);
+            fprintf(fp, "%s\n", pair);
         }
     }
 
@@ -411,29 +472,69 @@ int hcfg_write(const hcfg_t* cfg, const char* filename)
 /*
  * Internal helper function implementation.
  */
-void free_data(hcfg_t* cfg) {
-    for (int i = 0; i < cfg->len; ++i)
-        free(cfg->env[i]);
+void free_data(hcfg_t* cfg)
+{
+    for (int i = 0; i < cfg->cap; ++i) {
+        if (cfg->env[i].cap)
+            free(cfg->env[i].pair);
+        cfg->env[i].pair = NULL;
+        cfg->env[i].cap  = 0;
+    }
 }
 
-int key_find(const hcfg_t* cfg, const char* key, char** val)
+/*
+ * FNV-1a hash of the key portion of a "key" or "key=val" string.
+ */
+unsigned key_hash(const char* key, int* keylen)
 {
+    unsigned hash = 2166136261u;
     int i;
-    for (i = 0; i < cfg->len; ++i) {
-        int n = strcspn(key, "=");
-        if (strncmp(key, cfg->env[i], n) == 0 && cfg->env[i][n] == '=') {
-            if (val) *val = cfg->env[i] + n + 1;
+
+    for (i = 0; key[i] && key[i] != '='; ++i) {
+        hash ^= (unsigned char) key[i];
+        hash *= 16777619u;
+    }
+    if (keylen) *keylen = i;
+    return hash;
+}
+
+/*
+ * Return the index slot which holds the given key, or the empty slot
+ * where it would be inserted.  The index must not be full.
+ */
+int key_slot(const hcfg_t* cfg, const char* key, int keylen, unsigned hash)
+{
+    unsigned mask = cfg->index_cap - 1;
+    unsigned slot = hash & mask;
+
+    while (cfg->index[slot] != -1) {
+        const hcfg_entry_t* entry = &cfg->env[ cfg->index[slot] ];
+
+        if (entry->hash == hash && entry->keylen == keylen &&
+            strncmp(entry->pair, key, keylen) == 0)
             break;
-        }
+
+        slot = (slot + 1) & mask;
     }
-    return i;
+    return slot;
+}
+
+hcfg_entry_t* key_find(const hcfg_t* cfg, const char* key)
+{
+    int keylen;
+    unsigned hash = key_hash(key, &keylen);
+
+    if (!cfg->index_cap)
+        return NULL;
+
+    int idx = cfg->index[ key_slot(cfg, key, keylen, hash) ];
+    return (idx != -1) ? &cfg->env[idx] : NULL;
 }
 
 char* key_val(const hcfg_t* cfg, const char* key)
 {
-    char* val = NULL;
-    key_find(cfg, key, &val);
-    return val;
+    hcfg_entry_t* entry = key_find(cfg, key);
+    return entry ? entry->pair + entry->keylen + 1 : NULL;
 }
 
 char* key_val_index(const hcfg_t* cfg, const char* key, int idx)
@@ -452,35 +553,143 @@ char* key_val_index(const hcfg_t* cfg, const char* key, int idx)
     return val;
 }
 
-int key_add(hcfg_t* cfg, char* pair)
+int key_add(hcfg_t* cfg, const char* key, int keylen, const char* val)
 {
-    int i = key_find(cfg, pair, NULL);
+    unsigned hash = key_hash(key, NULL);
+    int vallen = strlen(val);
+    int need = keylen + vallen + 2;
 
-    if (i < cfg->len) {
-        free(cfg->env[i]);
+    // Keep the index at most half full.
+    if (2 * (cfg->len + 1) > cfg->index_cap) {
+        if (index_build(cfg, cfg->len + 1) != 0)
+            return -1;
+    }
+
+    int slot = key_slot(cfg, key, keylen, hash);
+    int i = cfg->index[slot];
+
+    if (i == -1) {
+        i = cfg->len;
+        if (i == cfg->cap) {
+            if (array_grow(&cfg->env, &cfg->cap, sizeof(*cfg->env)) != 0)
+                return -1;
+        }
     }
-    else if (i == cfg->cap) {
-        if (array_grow(&cfg->env, &cfg->cap, sizeof(*cfg->env)) != 0)
+    else if (val == cfg->env[i].pair + keylen + 1) {
+        return 0; // Value is being set to itself.
+    }
+
+    // Reuse the existing buffer whenever possible.
+    hcfg_entry_t* entry = &cfg->env[i];
+    if (entry->cap < need) {
+        char* newbuf = malloc(need);
+        if (!newbuf)
             return -1;
+
+        memcpy(newbuf, key, keylen);
+        memcpy(newbuf + keylen + 1, val, vallen + 1);
+
+        if (entry->cap)
+            free(entry->pair);
+        entry->pair = newbuf;
+        entry->cap  = need;
+    }
+    else {
+        memmove(entry->pair + keylen + 1, val, vallen + 1);
+        memmove(entry->pair, key, keylen);
     }
+    entry->pair[keylen] = '=';
+    entry->keylen = keylen;
+    entry->hash   = hash;
+    entry->cached = 0;
 
-    cfg->env[i] = pair;
-    if (i == cfg->len)
+    if (i == cfg->len) {
+        cfg->index[slot] = i;
         ++cfg->len;
-
+    }
     return 0;
 }
 
+int key_add_pair(hcfg_t* cfg, const char* pair)
+{
+    int keylen = strcspn(pair, "=");
+    return key_add(cfg, pair, keylen, pair + keylen + 1);
+}
+
 void key_del(hcfg_t* cfg, const char* key)
 {
-    int i = key_find(cfg, key, NULL);
+    int keylen;
+    unsigned hash = key_hash(key, &keylen);
 
+    if (!cfg->index_cap)
+        return;
+
+    unsigned mask = cfg->index_cap - 1;
+    unsigned slot = key_slot(cfg, key, keylen, hash);
+    int i = cfg->index[slot];
+    if (i == -1)
+        return;
+
+    // Backward-shift deletion keeps probe sequences unbroken.
+    unsigned next = slot;
+    while (1) {
+        next = (next + 1) & mask;
+        if (cfg->index[next] == -1)
+            break;
+
+        unsigned home = cfg->env[ cfg->index[next] ].hash & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            cfg->index[slot] = cfg->index[next];
+            slot = next;
+        }
+    }
+    cfg->index[slot] = -1;
+
+    // Swap the last entry into the hole.  The removed entry's buffer
+    // is parked just beyond the new length for later reuse.
+    //
+    --cfg->len;
     if (i < cfg->len) {
-        free(cfg->env[i]);
-        cfg->env[i] = cfg->env[ --cfg->len ];
+        hcfg_entry_t* last = &cfg->env[ cfg->len ];
+        hcfg_entry_t  tmp  = cfg->env[i];
+
+        slot = key_slot(cfg, last->pair, last->keylen, last->hash);
+        cfg->index[slot] = i;
+
+        cfg->env[i] = *last;
+        *last = tmp;
     }
 }
 
+/*
+ * (Re)build the hash index so that it may hold at least len entries.
+ */
+int index_build(hcfg_t* cfg, int len)
+{
+    int cap = cfg->index_cap ? cfg->index_cap : 16;
+    while (cap < 2 * len)
+        cap *= 2;
+
+    if (cap != cfg->index_cap) {
+        int* newbuf = realloc(cfg->index, cap * sizeof(*cfg->index));
+        if (!newbuf)
+            return -1;
+
+        cfg->index = newbuf;
+        cfg->index_cap = cap;
+    }
+
+    for (int i = 0; i < cfg->index_cap; ++i)
+        cfg->index[i] = -1;
+
+    for (int i = 0; i < cfg->len; ++i) {
+        hcfg_entry_t* entry = &cfg->env[i];
+        cfg->index[ key_slot(cfg, entry->pair, entry->keylen,
+                             entry->hash) ] = i;
+    }
+    return 0;
+}
+
 int copy_keyval(const char* buf, char** keyval, const char** errptr)
 {
     const char* errstr;
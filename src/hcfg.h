@@ -27,11 +27,18 @@ extern "C" {
 
 /*
  * Harmony structure that represents configuration key/value pairs.
+ *
+ * Entries are stored in insertion order, and located through an
+ * open-addressing hash index.  Each entry also caches the parsed
+ * scalar forms of its value.
  */
 typedef struct hcfg {
-    char** env;
-    int    len;
-    int    cap;
+    struct hcfg_entry* env;
+    int  len;
+    int  cap;
+
+    int* index;
+    int  index_cap;
 } hcfg_t;
 #define HCFG_INITIALIZER {0}
 extern const hcfg_t hcfg_zero;
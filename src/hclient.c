@@ -1283,6 +1283,27 @@ const char* ah_get_enum(htask_t* htask, const char* name)
         return htask->curr->term[idx].value.s;
 }
 
+/**
+ * \brief Return the evaluation budget of the current point.
+ *
+ * Multi-fidelity search strategies (such as
+ * [Hyperband](\ref hyperband)) evaluate most points with only a
+ * fraction of the full evaluation budget.  Clients should scale their
+ * problem size, iteration count, or time limit by this fraction
+ * before measuring the current point.
+ *
+ * \param htask Task descriptor returned from ah_start() or ah_join().
+ *
+ * \return Returns a value in the range (0.0, 1.0].  A value of 1.0
+ *         indicates that the point should be fully evaluated.
+ */
+double ah_get_budget(htask_t* htask)
+{
+    if (htask->curr && htask->curr->budget > 0.0)
+        return htask->curr->budget;
+    return 1.0;
+}
+
 /**
  * \brief Get a key value from the search's configuration.
  *
@@ -87,6 +87,7 @@ int         ah_bind_enum(htask_t* htask, const char* name, const char** ptr);
 long        ah_get_int(htask_t* htask, const char* name);
 double      ah_get_real(htask_t* htask, const char* name);
 const char* ah_get_enum(htask_t* htask, const char* name);
+double      ah_get_budget(htask_t* htask);
 const char* ah_get_cfg(htask_t* htask, const char* key);
 const char* ah_set_cfg(htask_t* htask, const char* key, const char* val);
 int         ah_fetch(htask_t* htask);
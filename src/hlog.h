@@ -0,0 +1,83 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HLOG_H__
+#define __HLOG_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary point/performance log format, shared by the Point Logger
+ * (log.so) and the hlogcat conversion utility.
+ *
+ * A binary log begins with a header, followed by the search space
+ * definition (as serialized by hspace_pack(), including its
+ * terminating NUL byte).  The remainder of the file is an array of
+ * fixed-width records, each made of 64-bit columns:
+ *
+ *   - The point ID.
+ *   - One column per search space dimension.  Integer and real
+ *     values are stored directly.  Enumerated values are stored as
+ *     an index into the dimension's value set.
+ *   - One column per performance objective.
+ *
+ * Records with a point ID of zero mark logger events instead of
+ * points.  The two columns following the ID hold the event type and
+ * a time_t timestamp.
+ *
+ * A new header may appear wherever a record is expected, such as when
+ * a log is appended to or the search space changes.  Readers detect
+ * it by its magic string, which is never a valid point ID.
+ *
+ * All values use the host's native byte order.
+ */
+#define HLOG_MAGIC "HLOGBIN1"
+
+typedef struct hlog_header {
+    char     magic[8];
+    uint32_t dim_count;
+    uint32_t obj_count;
+    uint32_t space_len; // Length of the serialized search space.
+    uint32_t reserved;
+} hlog_header_t;
+
+typedef union hlog_col {
+    int64_t  i;
+    uint64_t u;
+    double   r;
+} hlog_col_t;
+
+typedef enum hlog_event {
+    HLOG_EVENT_UNKNOWN = 0,
+    HLOG_EVENT_BEGIN,
+    HLOG_EVENT_REINIT,
+    HLOG_EVENT_END,
+
+    HLOG_EVENT_MAX
+} hlog_event_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page app_hlogcat Binary Log Conversion Utility
+ *
+ * Hlogcat converts a binary log produced by the
+ * [Point Logger](\ref logger) (with `LOG_FORMAT=binary`) into the
+ * text log format.  The output is identical to the log the Point
+ * Logger would have produced in text mode, and can be used anywhere
+ * a text log is accepted (such as the `CACHE_FILE` configuration key
+ * of the [Point Cache](\ref cache) layer).
+ *
+ * **Usage Syntax**
+ *
+ *     hlogcat <binary_log> [text_log]
+ *
+ * If no text log file is given, the converted log is written to
+ * standard output.  A partially written record at the end of the
+ * binary log is reported and ignored.
+ */
+
+#include "hlog.h"
+#include "hspace.h"
+#include "hrange.h"
+#include "hperf.h"
+#include "hval.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/*
+ * Internal helper function prototypes.
+ */
+static int read_header(FILE* in);
+static int print_record(FILE* out, const hlog_col_t* col);
+static int print_event(FILE* out, const hlog_col_t* col);
+
+// Global Variables.
+const char* infile;
+hspace_t    space = HSPACE_INITIALIZER;
+char*       space_buf;
+int         obj_count;
+int         cols;
+hlog_col_t* record;
+double*     obj;
+
+void usage(const char* prog)
+{
+    fprintf(stderr, "Usage: %s <binary_log> [text_log]\n", prog);
+    fprintf(stderr, "Convert a binary point/performance log to text.\n");
+}
+
+int main(int argc, char* argv[])
+{
+    FILE* in  = NULL;
+    FILE* out = stdout;
+    int retval = 0;
+
+    if (argc < 2 || argc > 3) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    infile = argv[1];
+    in = fopen(infile, "rb");
+    if (!in) {
+        fprintf(stderr, "Could not open %s: %s\n", infile, strerror(errno));
+        goto error;
+    }
+
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (!out) {
+            fprintf(stderr, "Could not open %s: %s\n",
+                    argv[2], strerror(errno));
+            goto error;
+        }
+    }
+
+    while (1) {
+        hlog_col_t id;
+        size_t count = fread(&id, sizeof(id), 1, in);
+        if (count < 1)
+            break;
+
+        // A header may appear wherever a record is expected.
+        if (memcmp(&id, HLOG_MAGIC, sizeof(id)) == 0) {
+            if (read_header(in) != 0)
+                goto error;
+            continue;
+        }
+
+        if (!record) {
+            fprintf(stderr, "%s: Not a binary log file.\n", infile);
+            goto error;
+        }
+
+        record[0] = id;
+        count = fread(record + 1, sizeof(*record), cols - 1, in);
+        if (count < (size_t)(cols - 1)) {
+            if (ferror(in))
+                break;
+
+            fprintf(stderr, "%s: Ignoring truncated trailing record.\n",
+                    infile);
+            break;
+        }
+
+        if (id.i == 0)
+            retval = print_event(out, record);
+        else
+            retval = print_record(out, record);
+
+        if (retval != 0)
+            goto error;
+    }
+
+    if (ferror(in)) {
+        fprintf(stderr, "Error reading %s: %s\n", infile, strerror(errno));
+        goto error;
+    }
+    goto cleanup;
+
+  error:
+    retval = -1;
+
+  cleanup:
+    if (out && out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "Error closing %s: %s\n", argv[2], strerror(errno));
+        retval = -1;
+    }
+    if (in)
+        fclose(in);
+
+    hspace_scrub(&space);
+    free(space_buf);
+    free(record);
+    free(obj);
+    return retval;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+/*
+ * Read the remainder of a header whose magic string has already been
+ * consumed, and prepare for the record layout it describes.
+ */
+int read_header(FILE* in)
+{
+    hlog_header_t head;
+    char* buf;
+    const size_t rest = sizeof(head) - sizeof(head.magic);
+
+    if (fread(head.magic + sizeof(head.magic), 1, rest, in) < rest) {
+        fprintf(stderr, "%s: Truncated log header.\n", infile);
+        return -1;
+    }
+
+    if (head.space_len < 1 || head.dim_count + head.obj_count < 2) {
+        fprintf(stderr, "%s: Invalid log header.\n", infile);
+        return -1;
+    }
+
+    buf = malloc(head.space_len);
+    if (!buf) {
+        perror("Could not allocate search space buffer");
+        return -1;
+    }
+
+    if (fread(buf, 1, head.space_len, in) < head.space_len ||
+        buf[head.space_len - 1] != '\0')
+    {
+        fprintf(stderr, "%s: Truncated search space definition.\n", infile);
+        goto error;
+    }
+
+    // The unpacked search space refers to strings within its buffer.
+    hspace_scrub(&space);
+    space = hspace_zero;
+    free(space_buf);
+    space_buf = buf;
+
+    if (hspace_unpack(&space, space_buf) < 0 ||
+        space.len != (int) head.dim_count)
+    {
+        fprintf(stderr, "%s: Invalid search space definition.\n", infile);
+        return -1;
+    }
+
+    obj_count = head.obj_count;
+    cols = 1 + head.dim_count + head.obj_count;
+
+    free(record);
+    free(obj);
+    record = malloc(cols * sizeof(*record));
+    obj = malloc(obj_count * sizeof(*obj));
+    if (!record || (obj_count && !obj)) {
+        perror("Could not allocate log record buffers");
+        return -1;
+    }
+    return 0;
+
+  error:
+    free(buf);
+    return -1;
+}
+
+int print_record(FILE* out, const hlog_col_t* col)
+{
+    hperf_t perf = HPERF_INITIALIZER;
+
+    fprintf(out, "Point #%d: (", (int) (col++)->i);
+    for (int i = 0; i < space.len; ++i, ++col) {
+        if (i > 0) fprintf(out, ",");
+
+        const hrange_t* range = &space.dim[i];
+        switch (range->type) {
+        case HVAL_INT:  fprintf(out, "%ld", (long) col->i); break;
+        case HVAL_REAL: fprintf(out, "%lf[%la]", col->r, col->r); break;
+        case HVAL_STR:
+            if (col->u >= (uint64_t) range->bounds.e.len) {
+                fprintf(stderr, "%s: Invalid enumerated value index.\n",
+                        infile);
+                return -1;
+            }
+            fprintf(out, "\"%s\"", range->bounds.e.set[col->u]);
+            break;
+        default:
+            fprintf(stderr, "%s: Invalid search space dimension type.\n",
+                    infile);
+            return -1;
+        }
+    }
+    fprintf(out, ") ");
+
+    fprintf(out, "=> (");
+    for (int i = 0; i < obj_count; ++i, ++col) {
+        if (i > 0) fprintf(out, ",");
+        fprintf(out, "%lf[%la]", col->r, col->r);
+        obj[i] = col->r;
+    }
+    fprintf(out, ") ");
+
+    perf.obj = obj;
+    perf.len = obj_count;
+    fprintf(out, "=> %lf\n", hperf_unify(&perf));
+    return 0;
+}
+
+int print_event(FILE* out, const hlog_col_t* col)
+{
+    time_t tm = (time_t) col[2].i;
+
+    switch (col[1].i) {
+    case HLOG_EVENT_BEGIN:
+        fprintf(out, "* Begin tuning session log.\n");
+        fprintf(out, "* Timestamp: %s", asctime( localtime(&tm) ));
+        break;
+
+    case HLOG_EVENT_REINIT:
+        fprintf(out, "* Logger re-initialized.\n");
+        fprintf(out, "* Timestamp: %s", asctime( localtime(&tm) ));
+        break;
+
+    case HLOG_EVENT_END:
+        fprintf(out, "*\n");
+        fprintf(out, "* End tuning session.\n");
+        fprintf(out, "* Timestamp: %s", asctime( localtime(&tm) ));
+        fprintf(out, "*\n");
+        break;
+
+    default:
+        fprintf(stderr, "%s: Ignoring unknown log event %ld.\n",
+                infile, (long) col[1].i);
+    }
+    return 0;
+}
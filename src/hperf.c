@@ -35,9 +35,22 @@ const hperf_t hperf_zero = HPERF_INITIALIZER;
 int hperf_init(hperf_t* perf, int newcap)
 {
     if (perf->cap < newcap) {
-        double* newbuf = realloc(perf->obj, newcap * sizeof(*perf->obj));
-        if (!newbuf)
-            return -1;
+        double* newbuf;
+
+        if (perf->arena) {
+            newbuf = harena_alloc(perf->arena, newcap * sizeof(*newbuf));
+            if (!newbuf)
+                return -1;
+
+            memcpy(newbuf, perf->obj, perf->cap * sizeof(*newbuf));
+            harena_free(perf->arena, perf->obj,
+                        perf->cap * sizeof(*perf->obj));
+        }
+        else {
+            newbuf = realloc(perf->obj, newcap * sizeof(*perf->obj));
+            if (!newbuf)
+                return -1;
+        }
 
         perf->obj = newbuf;
         perf->cap = newcap;
@@ -65,7 +78,10 @@ int hperf_copy(hperf_t* dst, const hperf_t* src)
 
 void hperf_fini(hperf_t* perf)
 {
-    free(perf->obj);
+    if (perf->arena)
+        harena_free(perf->arena, perf->obj, perf->cap * sizeof(*perf->obj));
+    else
+        free(perf->obj);
 }
 
 /*
@@ -20,6 +20,8 @@
 #ifndef __HPERF_H__
 #define __HPERF_H__
 
+#include "harena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,9 +31,10 @@ extern "C" {
  * performance value.
  */
 typedef struct hperf {
-    double* obj;
-    int     len;
-    int     cap;
+    double*   obj;
+    int       len;
+    int       cap;
+    harena_t* arena; // Allocate from this arena instead of the heap.
 } hperf_t;
 #define HPERF_INITIALIZER {0}
 extern const hperf_t hperf_zero;
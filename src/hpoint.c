@@ -23,7 +23,7 @@
 #include "hutil.h"
 
 #include <stdlib.h> // For realloc().
-#include <string.h> // For memcpy() and memcmp().
+#include <string.h> // For memcpy() and strcmp().
 #include <assert.h> // For assert().
 #include <ctype.h>  // For isspace().
 
@@ -35,6 +35,7 @@ const hpoint_t hpoint_zero = HPOINT_INITIALIZER;
 static int align_int(hval_t* val, const hrange_t* range);
 static int align_real(hval_t* val, const hrange_t* range);
 static int align_str(hval_t* val, const hrange_t* range);
+static int cmp_val(const hval_t* a, const hval_t* b);
 
 /*
  * Base structure management implementation.
@@ -42,9 +43,22 @@ static int align_str(hval_t* val, const hrange_t* range);
 int hpoint_init(hpoint_t* point, int newcap)
 {
     if (point->cap < newcap) {
-        hval_t* newbuf = realloc(point->term, newcap * sizeof(*point->term));
-        if (!newbuf)
-            return -1;
+        hval_t* newbuf;
+
+        if (point->arena) {
+            newbuf = harena_alloc(point->arena, newcap * sizeof(*newbuf));
+            if (!newbuf)
+                return -1;
+
+            memcpy(newbuf, point->term, point->cap * sizeof(*newbuf));
+            harena_free(point->arena, point->term,
+                        point->cap * sizeof(*point->term));
+        }
+        else {
+            newbuf = realloc(point->term, newcap * sizeof(*point->term));
+            if (!newbuf)
+                return -1;
+        }
 
         // Initialize any newly created hval_t structures.
         memset(newbuf + point->cap, 0,
@@ -64,11 +78,30 @@ int hpoint_copy(hpoint_t* dst, const hpoint_t* src)
     }
 
     for (int i = 0; i < src->len; ++i) {
-        if (hval_copy(&dst->term[i], &src->term[i]) != 0)
+        hval_t* val = &dst->term[i];
+
+        if (dst->arena && src->term[i].buf) {
+            // Strings owned by arena-backed points are interned in
+            // the arena, and released along with it.  Repeated copies
+            // of a value share its storage, so overwriting terms does
+            // not grow the arena.
+            //
+            char* str = harena_strdup(dst->arena, src->term[i].buf);
+            if (!str)
+                return -1;
+
+            hval_fini(val);
+            *val = src->term[i];
+            val->value.s = str;
+            val->buf = NULL;
+        }
+        else if (hval_copy(val, &src->term[i]) != 0) {
             return -1;
+        }
     }
-    dst->len = src->len;
-    dst->id  = src->id;
+    dst->len    = src->len;
+    dst->id     = src->id;
+    dst->budget = src->budget;
 
     return 0;
 }
@@ -77,12 +110,16 @@ void hpoint_fini(hpoint_t* point)
 {
     for (int i = 0; i < point->cap; ++i)
         hval_fini(&point->term[i]);
-    free(point->term);
+    hpoint_scrub(point);
 }
 
 void hpoint_scrub(hpoint_t* point)
 {
-    free(point->term);
+    if (point->arena)
+        harena_free(point->arena, point->term,
+                    point->cap * sizeof(*point->term));
+    else
+        free(point->term);
 }
 
 /*
@@ -111,18 +148,25 @@ int hpoint_align(hpoint_t* point, const hspace_t* space)
 
 int hpoint_eq(const hpoint_t* a, const hpoint_t* b)
 {
-    if (a->len != b->len)
-        return 0;
-    else
-        return memcmp(a->term, b->term, a->len * sizeof(*a->term)) == 0;
+    return hpoint_cmp(a, b) == 0;
 }
 
 int hpoint_cmp(const hpoint_t* a, const hpoint_t* b)
 {
     if (a->len != b->len)
         return a->len - b->len;
-    else
-        return memcmp(a->term, b->term, a->len * sizeof(*a->term));
+
+    for (int i = 0; i < a->len; ++i) {
+        int retval = cmp_val(&a->term[i], &b->term[i]);
+        if (retval)
+            return retval;
+    }
+
+    // Evaluations of a point with different budgets are distinct.
+    if (a->budget != b->budget)
+        return (a->budget < b->budget) ? -1 : 1;
+
+    return 0;
 }
 
 /*
@@ -134,7 +178,8 @@ int hpoint_pack(char** buf, int* buflen, const hpoint_t* point)
     if (total < 0) return -1;
 
     if (point->id) {
-        int count = snprintf_serial(buf, buflen, " %d", point->len);
+        int count = snprintf_serial(buf, buflen, " %d %a",
+                                    point->len, point->budget);
         if (count < 0) return -1;
         total += count;
 
@@ -156,7 +201,8 @@ int hpoint_unpack(hpoint_t* point, char* buf)
     if (point->id) {
         int newlen, count;
 
-        if (sscanf(buf + total, " %d%n", &newlen, &count) < 1)
+        if (sscanf(buf + total, " %d %la%n",
+                   &newlen, &point->budget, &count) < 2)
             return -1;
         total += count;
 
@@ -244,19 +290,45 @@ int align_real(hval_t* val, const hrange_t* range)
 
 int align_str(hval_t* val, const hrange_t* range)
 {
-    // First pass compare by address.
-    for (int i = 0; i < range->bounds.e.len; ++i)
-        if (val->value.s == range->bounds.e.set[i])
-            return 0;
-
-    // Second pass compare by value.
-    for (int i = 0; i < range->bounds.e.len; ++i) {
-        if (strcmp(val->value.s, range->bounds.e.set[i]) == 0) {
-            val->value.s = range->bounds.e.set[i];
-            free(val->buf);
-            val->buf = NULL;
-            return 0;
-        }
+    const range_enum_t* bounds = &range->bounds.e;
+
+    // Values already interned in this range need no further work.
+    if (val->idx >= 0 && val->idx < bounds->len &&
+        bounds->set[ val->idx ] == val->value.s)
+        return 0;
+
+    // Otherwise, find the interned string via the range's hash map.
+    int idx = range_enum_index(bounds, val->value.s);
+    if (idx < 0)
+        return -1;
+
+    val->idx     = idx;
+    val->value.s = bounds->set[idx];
+    free(val->buf);
+    val->buf = NULL;
+    return 0;
+}
+
+/*
+ * Order values by type, then by value.  String values interned in the
+ * same range compare by address before falling back to strcmp().
+ */
+int cmp_val(const hval_t* a, const hval_t* b)
+{
+    if (a->type != b->type)
+        return a->type - b->type;
+
+    switch (a->type) {
+    case HVAL_INT:
+        return (a->value.i > b->value.i) - (a->value.i < b->value.i);
+    case HVAL_REAL:
+        return (a->value.r > b->value.r) - (a->value.r < b->value.r);
+    case HVAL_STR:
+        if (a->value.s == b->value.s) return 0;
+        if (!a->value.s) return -1;
+        if (!b->value.s) return  1;
+        return strcmp(a->value.s, b->value.s);
+    default:
+        return 0;
     }
-    return -1;
 }
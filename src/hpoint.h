@@ -22,6 +22,7 @@
 
 #include "hspace.h"
 #include "hval.h"
+#include "harena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,12 +30,19 @@ extern "C" {
 
 /*
  * Harmony structure that represents a point within a search space.
+ *
+ * Multi-fidelity strategies may ask for a point to be evaluated with
+ * only a fraction of the full evaluation budget (e.g., fewer
+ * iterations or a smaller input).  A budget of 0.0 means that no
+ * budget was specified, and the point should be fully evaluated.
  */
 typedef struct hpoint {
-    unsigned id;
-    hval_t*  term;
-    int      len;
-    int      cap;
+    unsigned  id;
+    hval_t*   term;
+    int       len;
+    int       cap;
+    double    budget; // Fraction of the full evaluation budget.
+    harena_t* arena;  // Allocate from this arena instead of the heap.
 } hpoint_t;
 
 #define HPOINT_INITIALIZER {0}
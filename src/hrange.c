@@ -33,6 +33,10 @@ const hrange_t hrange_zero = HRANGE_INITIALIZER;
  * Internal helper function prototypes.
  */
 static int copy_enum(range_enum_t* dst, const range_enum_t* src);
+static unsigned enum_hash(const char* str);
+static int enum_slot(const range_enum_t* bounds, const char* str,
+                     unsigned hash);
+static int enum_rehash(range_enum_t* bounds, int len);
 static int parse_int(range_int_t* bounds, const char* buf,
                      const char** errptr);
 static int parse_real(range_real_t* bounds, const char* buf,
@@ -42,7 +46,7 @@ static int parse_enum(range_enum_t* bounds, const char* buf,
 static unsigned long index_of_int(const range_int_t* bounds, long val);
 static unsigned long index_of_real(const range_real_t* bounds, double val);
 static unsigned long index_of_enum(const range_enum_t* bounds,
-                                   const char* val);
+                                   const hval_t* val);
 static unsigned long limit_of_int(const range_int_t* bounds);
 static unsigned long limit_of_real(const range_real_t* bounds);
 static unsigned long limit_of_enum(const range_enum_t* bounds);
@@ -58,13 +62,20 @@ static hval_t value_of_enum(const range_enum_t* bounds, unsigned long idx);
  */
 int range_enum_add_value(range_enum_t* bounds, char* str, const char** errptr)
 {
-    for (int i = 0; i < bounds->len; ++i) {
-        if (strcmp(bounds->set[i], str) == 0) {
-            *errptr = "Cannot add duplicate value to enumerated domain";
+    // Keep the hash map at most half full.
+    if (2 * (bounds->len + 1) > bounds->hash_cap) {
+        if (enum_rehash(bounds, bounds->len + 1) != 0) {
+            *errptr = "Could not extend enumerated domain's hash map";
             return -1;
         }
     }
 
+    int slot = enum_slot(bounds, str, enum_hash(str));
+    if (bounds->hash[slot] != -1) {
+        *errptr = "Cannot add duplicate value to enumerated domain";
+        return -1;
+    }
+
     if (bounds->len == bounds->cap) {
         if (array_grow(&bounds->set, &bounds->cap,
                        sizeof(*bounds->set)) != 0)
@@ -74,10 +85,23 @@ int range_enum_add_value(range_enum_t* bounds, char* str, const char** errptr)
         }
     }
 
+    bounds->hash[slot] = bounds->len;
     bounds->set[ bounds->len++ ] = str;
     return 0;
 }
 
+/*
+ * Return the index of a string within an enumerated domain, or -1 if
+ * the string is not a member of the domain.
+ */
+int range_enum_index(const range_enum_t* bounds, const char* str)
+{
+    if (!bounds->hash_cap || !str)
+        return -1;
+
+    return bounds->hash[ enum_slot(bounds, str, enum_hash(str)) ];
+}
+
 /*
  * Base structure management implementation.
  */
@@ -106,14 +130,17 @@ void hrange_fini(hrange_t* range)
         for (int i = 0; i < range->bounds.e.len; ++i)
             free(range->bounds.e.set[i]);
         free(range->bounds.e.set);
+        free(range->bounds.e.hash);
     }
     free(range->name);
 }
 
 void hrange_scrub(hrange_t* range)
 {
-    if (range->type == HVAL_STR)
+    if (range->type == HVAL_STR) {
         free(range->bounds.e.set);
+        free(range->bounds.e.hash);
+    }
 }
 
 /*
@@ -129,7 +156,7 @@ unsigned long hrange_index(const hrange_t* range, const hval_t* val)
     switch (range->type) {
     case HVAL_INT:  return index_of_int(&range->bounds.i, val->value.i);
     case HVAL_REAL: return index_of_real(&range->bounds.r, val->value.r);
-    case HVAL_STR:  return index_of_enum(&range->bounds.e, val->value.s);
+    case HVAL_STR:  return index_of_enum(&range->bounds.e, val);
     default:        return 0;
     }
 }
@@ -291,6 +318,10 @@ int hrange_unpack(hrange_t* range, char* buf)
 
             range->bounds.e.set = newbuf;
             range->bounds.e.cap = range->bounds.e.len;
+            range->bounds.e.hash = NULL;
+            range->bounds.e.hash_cap = 0;
+            if (enum_rehash(&range->bounds.e, range->bounds.e.len) != 0)
+                return -1;
             break;
         }
 
@@ -372,6 +403,8 @@ int hrange_parse(hrange_t* range, const char* buf, const char** errptr)
  */
 int copy_enum(range_enum_t* dst, const range_enum_t* src)
 {
+    dst->hash = NULL;
+    dst->hash_cap = 0;
     dst->set = malloc(src->cap * sizeof(*dst->set));
     if (!dst->set)
         return -1;
@@ -382,6 +415,66 @@ int copy_enum(range_enum_t* dst, const range_enum_t* src)
         if (!dst->set[ dst->len ])
             return -1;
     }
+    return enum_rehash(dst, dst->len);
+}
+
+/*
+ * FNV-1a hash of an enumerated domain string value.
+ */
+unsigned enum_hash(const char* str)
+{
+    unsigned hash = 2166136261u;
+
+    while (*str) {
+        hash ^= (unsigned char) *(str++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Return the hash map slot which holds the given string, or the
+ * empty slot where it would be inserted.
+ */
+int enum_slot(const range_enum_t* bounds, const char* str, unsigned hash)
+{
+    unsigned mask = bounds->hash_cap - 1;
+    unsigned slot = hash & mask;
+
+    while (bounds->hash[slot] != -1) {
+        const char* member = bounds->set[ bounds->hash[slot] ];
+
+        if (member == str || strcmp(member, str) == 0)
+            break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * (Re)build the hash map so that it may hold at least len strings.
+ */
+int enum_rehash(range_enum_t* bounds, int len)
+{
+    int cap = bounds->hash_cap ? bounds->hash_cap : 16;
+    while (cap < 2 * len)
+        cap *= 2;
+
+    if (cap != bounds->hash_cap) {
+        int* newbuf = realloc(bounds->hash, cap * sizeof(*newbuf));
+        if (!newbuf)
+            return -1;
+
+        bounds->hash = newbuf;
+        bounds->hash_cap = cap;
+    }
+
+    for (int i = 0; i < bounds->hash_cap; ++i)
+        bounds->hash[i] = -1;
+
+    for (int i = 0; i < bounds->len; ++i)
+        bounds->hash[ enum_slot(bounds, bounds->set[i],
+                                enum_hash(bounds->set[i])) ] = i;
     return 0;
 }
 
@@ -432,7 +525,7 @@ int parse_real(range_real_t* bounds, const char* buf, const char** errptr)
 
 int parse_enum(range_enum_t* bounds, const char* buf, const char** errptr)
 {
-    *bounds = (range_enum_t){NULL, 0, 0};
+    *bounds = (range_enum_t){NULL, 0, 0, NULL, 0};
 
     int tail = 0;
     while (buf[tail]) {
@@ -489,14 +582,16 @@ unsigned long index_of_real(const range_real_t* bounds, double val)
     return 0;
 }
 
-unsigned long index_of_enum(const range_enum_t* bounds, const char* val)
+unsigned long index_of_enum(const range_enum_t* bounds, const hval_t* val)
 {
-    int index;
-
-    for (index = 0; index < bounds->len; ++index) {
-        if (bounds->set[index] == val)
-            break;
-    }
+    // Trust the carried index if it refers to this exact string.
+    if (val->idx >= 0 && val->idx < bounds->len &&
+        bounds->set[ val->idx ] == val->value.s)
+        return (unsigned long) val->idx;
+
+    int index = range_enum_index(bounds, val->value.s);
+    if (index < 0)
+        index = bounds->len;
     return (unsigned long) index;
 }
 
@@ -606,6 +701,7 @@ hval_t value_of_enum(const range_enum_t* bounds, unsigned long idx)
         hval_t val = hval_zero;
 
         val.type    = HVAL_STR;
+        val.idx     = (int) idx;
         val.value.s = bounds->set[ idx ];
         val.buf     = NULL;
 
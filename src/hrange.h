@@ -51,9 +51,14 @@ typedef struct range_enum {
     char** set;
     int    len;
     int    cap;
+
+    // Open-addressing hash map from string values to set indexes.
+    int*   hash;
+    int    hash_cap;
 } range_enum_t;
 
 int range_enum_add_value(range_enum_t* bounds, char* str, const char** errptr);
+int range_enum_index(const range_enum_t* bounds, const char* str);
 
 /*
  * Range type to represent a single dimension of the tuning search space.
@@ -635,6 +635,7 @@ int handle_session_socket(void)
                 }
             }
 
+            sinfo->fetched[sinfo->fetched_len].arena = sinfo->arena;
             if (hpoint_copy(&sinfo->fetched[sinfo->fetched_len],
                             mesg.data.point) != 0)
             {
@@ -766,6 +767,7 @@ int update_state(sinfo_t* sinfo)
         if (i < 0)
             sinfo->best_perf = NAN;
 
+        sinfo->best.arena = sinfo->arena;
         if (hpoint_copy(&sinfo->best, mesg.state.best) != 0) {
             perror("Internal error copying hpoint to best");
             return -1;
@@ -795,6 +797,7 @@ int append_http_log(sinfo_t* sinfo, const hpoint_t* pt, double perf)
     }
     entry = &sinfo->log[sinfo->log_len];
 
+    entry->pt.arena = sinfo->arena;
     if (hpoint_copy(&entry->pt, pt) != 0) {
         perror("Internal error copying point into HTTP log");
         return -1;
@@ -949,6 +952,17 @@ sinfo_t* open_search(int fd)
         return NULL;
     }
 
+    // Points recorded by this search are allocated from an arena that
+    // persists with the slot, so reused slots recycle their memory.
+    //
+    if (!sinfo->arena) {
+        sinfo->arena = calloc(1, sizeof(*sinfo->arena));
+        if (!sinfo->arena) {
+            mesg.data.string = "Server error: Could not allocate search arena";
+            return NULL;
+        }
+    }
+
 
     // Initialize HTTP server fields.
     if (gettimeofday(&sinfo->start, NULL) != 0) {
@@ -1051,6 +1065,11 @@ void fini_search(sinfo_t* sinfo)
     free(sinfo->client.slot);
     free(sinfo->request.slot);
     hpoint_fini(&sinfo->best);
+
+    if (sinfo->arena) {
+        harena_fini(sinfo->arena);
+        free(sinfo->arena);
+    }
 }
 
 /*
@@ -47,6 +47,9 @@ typedef struct http_log {
 typedef struct sinfo {
     int id;
 
+    // Memory for points recorded by this search.
+    harena_t* arena;
+
     // Best known search point and performance.
     hpoint_t best;
     double best_perf;
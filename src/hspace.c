@@ -32,6 +32,8 @@ const hspace_t hspace_zero = HSPACE_INITIALIZER;
  */
 static int       add_dim(hspace_t* sig, hrange_t* dim, const char** errptr);
 static hrange_t* find_dim(hspace_t* sig, const char* name);
+static int       update_strides(hspace_t* space);
+static uint64_t  hash_bytes(uint64_t hash, const void* buf, size_t len);
 
 /*
  * Base structure management implementation.
@@ -64,7 +66,7 @@ int hspace_copy(hspace_t* dst, const hspace_t* src)
     }
 
     dst->id = src->id;
-    return 0;
+    return update_strides(dst);
 }
 
 void hspace_fini(hspace_t* space)
@@ -73,6 +75,7 @@ void hspace_fini(hspace_t* space)
     for (int i = 0; i < space->cap; ++i)
         hrange_fini(&space->dim[i]);
     free(space->dim);
+    free(space->stride);
 }
 
 void hspace_scrub(hspace_t* space)
@@ -80,6 +83,7 @@ void hspace_scrub(hspace_t* space)
     for (int i = 0; i < space->len; ++i)
         hrange_scrub(&space->dim[i]);
     free(space->dim);
+    free(space->stride);
 }
 
 /*
@@ -131,7 +135,7 @@ int hspace_int(hspace_t* space, const char* name,
     }
 
     ++space->id;
-    return 0;
+    return update_strides(space);
 }
 
 int hspace_real(hspace_t* space, const char* name,
@@ -176,7 +180,7 @@ int hspace_real(hspace_t* space, const char* name,
     }
 
     ++space->id;
-    return 0;
+    return update_strides(space);
 }
 
 int hspace_enum(hspace_t* space, const char* name,
@@ -193,6 +197,8 @@ int hspace_enum(hspace_t* space, const char* name,
         range.bounds.e.set = NULL;
         range.bounds.e.len = 0;
         range.bounds.e.cap = 0;
+        range.bounds.e.hash = NULL;
+        range.bounds.e.hash_cap = 0;
         range.name = stralloc(name);
         if (!range.name) {
             *errptr = "Could not allocate search variable (dimension) name";
@@ -220,7 +226,7 @@ int hspace_enum(hspace_t* space, const char* name,
     }
 
     ++space->id;
-    return 0;
+    return update_strides(space);
 }
 
 /*
@@ -272,6 +278,78 @@ int hspace_equal(const hspace_t* a, const hspace_t* b)
     return 1;
 }
 
+/*
+ * Fingerprint the dimensions of a search space.  Spaces which satisfy
+ * hspace_equal() produce identical hashes.  The space name is not
+ * included, so identically defined spaces of different searches also
+ * produce identical hashes.
+ */
+uint64_t hspace_hash(const hspace_t* space)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < space->len; ++i) {
+        const hrange_t* dim = &space->dim[i];
+
+        hash = hash_bytes(hash, dim->name, strlen(dim->name) + 1);
+        hash = hash_bytes(hash, &dim->type, sizeof(dim->type));
+        switch (dim->type) {
+        case HVAL_INT:
+            hash = hash_bytes(hash, &dim->bounds.i, sizeof(dim->bounds.i));
+            break;
+        case HVAL_REAL:
+            hash = hash_bytes(hash, &dim->bounds.r, sizeof(dim->bounds.r));
+            break;
+        case HVAL_STR:
+            for (int j = 0; j < dim->bounds.e.len; ++j)
+                hash = hash_bytes(hash, dim->bounds.e.set[j],
+                                  strlen(dim->bounds.e.set[j]) + 1);
+            break;
+        default:
+            break;
+        }
+    }
+    return hash;
+}
+
+/*
+ * Linear indexing implementation.
+ */
+int hspace_rank(const hspace_t* space, const hpoint_t* point, uint64_t* rank)
+{
+    if (!space->size || point->len != space->len)
+        return -1;
+
+    uint64_t retval = 0;
+    for (int i = 0; i < space->len; ++i) {
+        unsigned long idx = hrange_index(&space->dim[i], &point->term[i]);
+        if (idx >= hrange_limit(&space->dim[i]))
+            return -1;
+
+        retval += idx * space->stride[i];
+    }
+    *rank = retval;
+    return 0;
+}
+
+int hspace_unrank(const hspace_t* space, uint64_t rank, hpoint_t* point)
+{
+    if (!space->size || rank >= space->size)
+        return -1;
+
+    if (hpoint_init(point, space->len) != 0)
+        return -1;
+
+    for (int i = space->len - 1; i >= 0; --i) {
+        hval_fini(&point->term[i]);
+        point->term[i] = hrange_value(&space->dim[i],
+                                      rank / space->stride[i]);
+        rank %= space->stride[i];
+    }
+    point->len = space->len;
+    return 0;
+}
+
 /*
  * Data transmission implementation.
  */
@@ -334,6 +412,9 @@ int hspace_unpack(hspace_t* space, char* buf)
             if (count < 0) return -1;
             total += count;
         }
+
+        if (update_strides(space) != 0)
+            return -1;
     }
     return total;
 }
@@ -355,6 +436,10 @@ int hspace_parse(hspace_t* space, const char* buf, const char** errptr)
     }
 
     ++space->id;
+    if (update_strides(space) != 0) {
+        errstr = "Could not compute search space strides";
+        goto error;
+    }
     return 1;
 
   error:
@@ -384,6 +469,42 @@ int add_dim(hspace_t* space, hrange_t* dim, const char** errptr)
     return 0;
 }
 
+/*
+ * Recompute the mixed-radix strides of the search space.  The total
+ * size is left at 0 if any dimension is not finite, or if the number
+ * of points would overflow 64 bits.
+ */
+int update_strides(hspace_t* space)
+{
+    if (space->len) {
+        uint64_t* newbuf = realloc(space->stride,
+                                   space->len * sizeof(*newbuf));
+        if (!newbuf)
+            return -1;
+        space->stride = newbuf;
+    }
+
+    space->size = 1;
+    for (int i = 0; i < space->len; ++i) {
+        uint64_t limit = 0;
+
+        if (hrange_finite(&space->dim[i]))
+            limit = hrange_limit(&space->dim[i]);
+
+        if (!space->size || !limit || space->size > UINT64_MAX / limit) {
+            space->size = 0;
+            space->stride[i] = 0;
+            continue;
+        }
+        space->stride[i] = space->size;
+        space->size *= limit;
+    }
+
+    if (!space->len)
+        space->size = 0;
+    return 0;
+}
+
 hrange_t* find_dim(hspace_t* space, const char* name)
 {
     for (int i = 0; i < space->len; ++i)
@@ -392,3 +513,17 @@ hrange_t* find_dim(hspace_t* space, const char* name)
 
     return NULL;
 }
+
+/*
+ * Continue a 64-bit FNV-1a hash over a block of memory.
+ */
+uint64_t hash_bytes(uint64_t hash, const void* buf, size_t len)
+{
+    const unsigned char* ptr = buf;
+
+    while (len--) {
+        hash ^= *(ptr++);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -22,10 +22,14 @@
 
 #include "hrange.h"
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct hpoint;
+
 /*
  * Harmony structure representing the search space.
  *
@@ -39,6 +43,13 @@ typedef struct hspace {
     hrange_t* dim;
     int       len;
     int       cap;
+
+    // Mixed-radix strides for linear indexing.  Dimension 0 varies
+    // fastest.  The size is 0 unless every dimension is finite and
+    // the total point count fits within 64 bits.
+    //
+    uint64_t* stride;
+    uint64_t  size;
 } hspace_t;
 #define HSPACE_INITIALIZER {0}
 extern const hspace_t hspace_zero;
@@ -64,7 +75,16 @@ int hspace_enum(hspace_t* space, const char* name,
 /*
  * Search space comparison interface.
  */
-int hspace_equal(const hspace_t* a, const hspace_t* b);
+int      hspace_equal(const hspace_t* a, const hspace_t* b);
+uint64_t hspace_hash(const hspace_t* space);
+
+/*
+ * Linear indexing interface for finite search spaces.
+ */
+int hspace_rank(const hspace_t* space, const struct hpoint* point,
+                uint64_t* rank);
+int hspace_unrank(const hspace_t* space, uint64_t rank,
+                  struct hpoint* point);
 
 /*
  * Data transmission interface.
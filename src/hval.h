@@ -44,6 +44,7 @@ typedef union hval_value {
 
 typedef struct hval {
     hval_type_t  type;
+    int          idx;   // Enumerated set index hint for HVAL_STR values.
     hval_value_t value;
     char*        buf;
 } hval_t;
@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
  */
+#define _XOPEN_SOURCE 500 // Needed for M_PI.
 
 /**
  * \page agg Aggregator (agg.so)
@@ -25,6 +26,24 @@
  * [feedback loop](\ref intro_feedback).  When the requisite number of
  * evaluations has been reached, an aggregating function is applied to
  * consolidate the set performance values.
+ *
+ * Performance values are consolidated as they arrive, so memory use
+ * per point does not depend on the number of evaluations.  The min
+ * and max functions select the performance report with the smallest
+ * or largest unified value.  The mean and median functions operate on
+ * each objective individually.  Medians are exact for up to five
+ * evaluations, and are estimated with the P-square algorithm beyond
+ * that.
+ *
+ * **Adaptive Repetition**
+ *
+ * When the AGG_PRECISION configuration key is set, the number of
+ * evaluations per point adapts to the measured noise.  After
+ * AGG_MIN_TIMES evaluations, a confidence interval is computed for
+ * the mean unified performance of the point.  Evaluation stops early
+ * if the interval is narrow enough, relative to the mean, or if the
+ * entire interval lies above the best aggregated performance seen so
+ * far.  No point is evaluated more than AGG_TIMES times.
  */
 
 #include "hlayer.h"
@@ -36,7 +55,9 @@
 #include "hcfg.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
+#include <math.h>
 
 /*
  * Name used to identify this plugin layer.
@@ -54,14 +75,45 @@ const hcfg_info_t hplugin_keyinfo[] = {
       "and median." },
     { CFGKEY_AGG_TIMES, NULL,
       "Number of performance values to collect before performing the "
-      "aggregation function." },
+      "aggregation function.  This is the maximum number of values "
+      "collected when " CFGKEY_AGG_PRECISION " is set." },
+    { CFGKEY_AGG_PRECISION, NULL,
+      "Enable adaptive repetition.  Stop collecting performance values "
+      "for a point once the confidence interval half-width of its mean "
+      "is at most this fraction of the mean." },
+    { CFGKEY_AGG_MIN_TIMES, "3",
+      "Minimum number of performance values to collect per point when "
+      "adaptive repetition is enabled." },
+    { CFGKEY_AGG_CONFIDENCE, "0.95",
+      "Confidence level of the intervals used for adaptive "
+      "repetition." },
     { NULL }
 };
 
+/*
+ * Streaming statistics for a single objective.  The running mean and
+ * sum of squared differences are maintained with Welford's method.
+ * The median is tracked by the five markers of the P-square
+ * algorithm, which hold the sorted samples until five have arrived.
+ */
+typedef struct objstat {
+    double mean;
+    double m2;
+    double q[5]; // Marker heights.
+    int    n[5]; // Marker positions.
+} objstat_t;
+
 typedef struct store {
-    int id;
-    int count;
-    hperf_t* trial;
+    int        id;
+    int        count;
+    int        next;     // Free list link.
+    double     u_mean;   // Running statistics of the unified value.
+    double     u_m2;
+    double     min_sum;
+    double     max_sum;
+    double*    min;      // Report with the smallest unified value.
+    double*    max;      // Report with the largest unified value.
+    objstat_t* stat;
 } store_t;
 
 typedef enum aggfunc {
@@ -82,18 +134,41 @@ typedef enum aggfunc {
 struct hplugin_data {
     aggfunc_t agg_type;
     int       trial_per_point;
+    int       obj_count;
+    double    best;
     store_t*  slist;
     int       slist_len;
+    int       free_head;
+
+    // Open-addressing hash map from point IDs to slist indexes.
+    int*      index;
+    int       index_cap;
+    int       index_len;
+
+    // Adaptive repetition settings.
+    int       adaptive;
+    int       min_times;
+    double    precision;
+    double*   tval;   // Student's t quantile, indexed by sample size.
 };
 
 /*
  * Internal helper function prototypes.
  */
-static void perf_mean(hplugin_data_t* data, hperf_t* dst, hperf_t* src,
-                      int count);
-static int  perf_sort(const void* _a, const void* _b);
-static int  add_storage(hplugin_data_t* data);
-static void free_storage(hplugin_data_t* data);
+static store_t* find_store(hplugin_data_t* data, int id);
+static store_t* open_store(hplugin_data_t* data, int id);
+static void     close_store(hplugin_data_t* data, store_t* store);
+static void     accumulate(hplugin_data_t* data, store_t* store,
+                           const hperf_t* perf);
+static int      is_settled(hplugin_data_t* data, const store_t* store);
+static int      calc_tval(hplugin_data_t* data, double confidence);
+static double   t_quantile(double p, int df);
+static void     psquare_add(objstat_t* stat, int count, double x);
+static double   psquare_median(const objstat_t* stat, int count);
+static unsigned index_slot(hplugin_data_t* data, int id);
+static int      index_grow(hplugin_data_t* data);
+static int      add_storage(hplugin_data_t* data);
+static void     free_storage(hplugin_data_t* data);
 
 /*
  * Allocate memory for a new search task.
@@ -104,6 +179,7 @@ hplugin_data_t* agg_alloc(void)
     if (!retval)
         return NULL;
 
+    retval->free_head = -1;
     return retval;
 }
 
@@ -132,72 +208,97 @@ int agg_init(hplugin_data_t* data, hspace_t* space)
         return -1;
     }
 
-    if (data->trial_per_point != new_trial_count) {
+    int new_obj_count = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
+    if (data->trial_per_point != new_trial_count ||
+        data->obj_count != new_obj_count)
+    {
         data->trial_per_point = new_trial_count;
+        data->obj_count = new_obj_count;
 
         free_storage(data);
 
         data->slist = NULL;
         data->slist_len = 0;
-        if (add_storage(data))
+        data->free_head = -1;
+        data->index = NULL;
+        data->index_cap = 0;
+        data->index_len = 0;
+        if (add_storage(data) != 0 || index_grow(data) != 0)
+            return -1;
+    }
+
+    data->adaptive = (hcfg_get(search_cfg, CFGKEY_AGG_PRECISION) != NULL);
+    if (data->adaptive) {
+        data->precision = hcfg_real(search_cfg, CFGKEY_AGG_PRECISION);
+        if (isnan(data->precision) || data->precision < 0.0) {
+            search_error("Configuration key " CFGKEY_AGG_PRECISION
+                         " must be non-negative");
+            return -1;
+        }
+
+        data->min_times = hcfg_int(search_cfg, CFGKEY_AGG_MIN_TIMES);
+        if (data->min_times < 2) {
+            search_error("Configuration key " CFGKEY_AGG_MIN_TIMES
+                         " must be at least 2");
+            return -1;
+        }
+        if (data->min_times > data->trial_per_point)
+            data->min_times = data->trial_per_point;
+
+        double confidence = hcfg_real(search_cfg, CFGKEY_AGG_CONFIDENCE);
+        if (isnan(confidence) || confidence <= 0.0 || confidence >= 1.0) {
+            search_error("Configuration key " CFGKEY_AGG_CONFIDENCE
+                         " must be between 0.0 and 1.0 (exclusive)");
+            return -1;
+        }
+        if (calc_tval(data, confidence) != 0)
             return -1;
     }
+
+    data->best = HUGE_VAL;
     return 0;
 }
 
 int agg_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
 {
-    int i;
-    store_t* store;
-
-    for (i = 0; i < data->slist_len; ++i) {
-        if (data->slist[i].id == trial->point.id || data->slist[i].id == -1)
-            break;
-    }
-    if (i == data->slist_len && add_storage(data) != 0)
+    if (trial->perf.len != data->obj_count) {
+        search_error("Invalid performance objective count");
         return -1;
-
-    store = &data->slist[i];
-    if (store->id == -1) {
-        store->id = trial->point.id;
-        store->count = 0;
     }
 
-    if (hperf_copy(&store->trial[ store->count ], &trial->perf) != 0)
-        return -1;
-
-    ++store->count;
+    store_t* store = find_store(data, trial->point.id);
+    if (!store) {
+        store = open_store(data, trial->point.id);
+        if (!store)
+            return -1;
+    }
 
-    if (store->count < data->trial_per_point) {
+    accumulate(data, store, &trial->perf);
+    if (store->count < data->trial_per_point &&
+        !(data->adaptive && is_settled(data, store)))
+    {
         flow->status = HFLOW_RETRY;
         return 0;
     }
 
+    double* obj = trial->perf.obj;
     switch (data->agg_type) {
     case AGG_MIN:
-        for (i = 0; i < data->trial_per_point; ++i)
-            if (hperf_cmp(&trial->perf, &store->trial[i]) > 0)
-                hperf_copy(&trial->perf, &store->trial[i]);
+        memcpy(obj, store->min, data->obj_count * sizeof(*obj));
         break;
 
     case AGG_MAX:
-        for (i = 0; i < data->trial_per_point; ++i)
-            if (hperf_cmp(&trial->perf, &store->trial[i]) < 0)
-                hperf_copy(&trial->perf, &store->trial[i]);
+        memcpy(obj, store->max, data->obj_count * sizeof(*obj));
         break;
 
     case AGG_MEAN:
-        perf_mean(data, &trial->perf, store->trial, data->trial_per_point);
+        for (int i = 0; i < data->obj_count; ++i)
+            obj[i] = store->stat[i].mean;
         break;
 
     case AGG_MEDIAN:
-        qsort(store->trial, data->trial_per_point, sizeof(hperf_t), perf_sort);
-
-        i = (data->trial_per_point - 1) / 2;
-        if (i % 2)
-            hperf_copy(&trial->perf, &store->trial[i]);
-        else
-            perf_mean(data, &trial->perf, &store->trial[i], 2);
+        for (int i = 0; i < data->obj_count; ++i)
+            obj[i] = psquare_median(&store->stat[i], store->count);
         break;
 
     default:
@@ -205,8 +306,11 @@ int agg_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
         return -1;
     }
 
-    store->id = -1;
-    store->count = 0;
+    double unified = hperf_unify(&trial->perf);
+    if (data->best > unified)
+        data->best = unified;
+
+    close_store(data, store);
     flow->status = HFLOW_ACCEPT;
     return 0;
 }
@@ -217,6 +321,7 @@ int agg_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
 int agg_fini(hplugin_data_t* data)
 {
     free_storage(data);
+    free(data->tval);
     free(data);
     return 0;
 }
@@ -225,29 +330,295 @@ int agg_fini(hplugin_data_t* data)
  * Internal helper function implementation.
  */
 
-void perf_mean(hplugin_data_t* data, hperf_t* dst, hperf_t* src, int count)
+store_t* find_store(hplugin_data_t* data, int id)
+{
+    int idx = data->index[ index_slot(data, id) ];
+
+    return idx ? &data->slist[idx - 1] : NULL;
+}
+
+/*
+ * Take a store from the free list, and link it into the index.
+ */
+store_t* open_store(hplugin_data_t* data, int id)
+{
+    if (data->free_head < 0 && add_storage(data) != 0)
+        return NULL;
+
+    if (2 * (data->index_len + 1) > data->index_cap &&
+        index_grow(data) != 0)
+        return NULL;
+
+    int idx = data->free_head;
+    store_t* store = &data->slist[idx];
+    data->free_head = store->next;
+
+    store->id = id;
+    store->count = 0;
+    data->index[ index_slot(data, id) ] = idx + 1;
+    ++data->index_len;
+
+    return store;
+}
+
+/*
+ * Unlink a store from the index, and return it to the free list.
+ * Entries following it in the probe sequence are shifted back, so no
+ * deletion markers are needed.
+ */
+void close_store(hplugin_data_t* data, store_t* store)
+{
+    unsigned mask = data->index_cap - 1;
+    unsigned hole = index_slot(data, store->id);
+    unsigned slot = hole;
+
+    while (1) {
+        slot = (slot + 1) & mask;
+        if (!data->index[slot])
+            break;
+
+        int id = data->slist[ data->index[slot] - 1 ].id;
+        unsigned home = ((unsigned) id * 2654435761U) & mask;
+
+        // Move the entry if its home slot is not between hole and slot.
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            data->index[hole] = data->index[slot];
+            hole = slot;
+        }
+    }
+    data->index[hole] = 0;
+    --data->index_len;
+
+    store->id = -1;
+    store->next = data->free_head;
+    data->free_head = store - data->slist;
+}
+
+void accumulate(hplugin_data_t* data, store_t* store, const hperf_t* perf)
+{
+    double sum = hperf_unify(perf);
+    size_t size = data->obj_count * sizeof(double);
+
+    if (store->count == 0) {
+        store->u_mean = sum;
+        store->u_m2 = 0.0;
+    }
+    else {
+        double delta = sum - store->u_mean;
+        store->u_mean += delta / (store->count + 1);
+        store->u_m2 += delta * (sum - store->u_mean);
+    }
+
+    if (store->count == 0 || sum < store->min_sum) {
+        store->min_sum = sum;
+        memcpy(store->min, perf->obj, size);
+    }
+    if (store->count == 0 || sum > store->max_sum) {
+        store->max_sum = sum;
+        memcpy(store->max, perf->obj, size);
+    }
+
+    for (int i = 0; i < data->obj_count; ++i) {
+        objstat_t* stat = &store->stat[i];
+        double x = perf->obj[i];
+
+        if (store->count == 0) {
+            stat->mean = x;
+            stat->m2 = 0.0;
+        }
+        else {
+            double delta = x - stat->mean;
+            stat->mean += delta / (store->count + 1);
+            stat->m2 += delta * (x - stat->mean);
+        }
+        psquare_add(stat, store->count, x);
+    }
+    ++store->count;
+}
+
+/*
+ * Decide whether a point has been evaluated enough times, based on a
+ * confidence interval for the mean of its unified performance.
+ */
+int is_settled(hplugin_data_t* data, const store_t* store)
+{
+    int n = store->count;
+    if (n < data->min_times)
+        return 0;
+
+    double stddev = sqrt(store->u_m2 / (n - 1));
+    double half = data->tval[n] * stddev / sqrt(n);
+
+    // The interval is narrow enough.
+    if (half <= data->precision * fabs(store->u_mean))
+        return 1;
+
+    // The point is worse than the best point with high confidence.
+    if (store->u_mean - half > data->best)
+        return 1;
+
+    return 0;
+}
+
+/*
+ * Tabulate two-sided Student's t quantiles for each sample size up
+ * to the maximum number of evaluations per point.
+ */
+int calc_tval(hplugin_data_t* data, double confidence)
+{
+    double* newbuf = realloc(data->tval, (data->trial_per_point + 1) *
+                                         sizeof(*newbuf));
+    if (!newbuf) {
+        search_error("Could not allocate t quantile table");
+        return -1;
+    }
+    data->tval = newbuf;
+
+    data->tval[0] = data->tval[1] = HUGE_VAL;
+    for (int n = 2; n <= data->trial_per_point; ++n)
+        data->tval[n] = t_quantile((1.0 + confidence) / 2, n - 1);
+
+    return 0;
+}
+
+/*
+ * Approximate the p-quantile of Student's t distribution.  Closed
+ * forms exist for one and two degrees of freedom.  Otherwise, a
+ * normal quantile (Abramowitz and Stegun 26.2.23) is refined by a
+ * Cornish-Fisher expansion in the degrees of freedom.
+ */
+double t_quantile(double p, int df)
+{
+    if (df == 1)
+        return tan(M_PI * (p - 0.5));
+    if (df == 2)
+        return (2 * p - 1) / sqrt(2 * p * (1 - p));
+
+    double q = (p < 0.5) ? p : 1.0 - p;
+    double t = sqrt(-2.0 * log(q));
+    double z = t - (2.515517 + t * (0.802853 + t * 0.010328)) /
+                   (1.0 + t * (1.432788 + t * (0.189269 + t * 0.001308)));
+    if (p < 0.5)
+        z = -z;
+
+    double z2 = z * z;
+    double v = df;
+    return z + z * (z2 + 1) / (4 * v)
+             + z * ((5 * z2 + 16) * z2 + 3) / (96 * v * v)
+             + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * v * v * v);
+}
+
+/*
+ * Add a sample to the P-square median markers, given the number of
+ * samples already observed.
+ */
+void psquare_add(objstat_t* stat, int count, double x)
+{
+    double* q = stat->q;
+    int* n = stat->n;
+    int k;
+
+    if (count < 5) {
+        // Insertion sort while the markers are being initialized.
+        for (k = count; k > 0 && q[k - 1] > x; --k)
+            q[k] = q[k - 1];
+        q[k] = x;
+
+        for (k = 0; k < 5; ++k)
+            n[k] = k + 1;
+        return;
+    }
+
+    // Find the cell containing x, and extend the extreme markers.
+    if (x < q[0]) {
+        q[0] = x;
+        k = 0;
+    }
+    else if (x >= q[4]) {
+        q[4] = x;
+        k = 3;
+    }
+    else {
+        for (k = 0; k < 3 && x >= q[k + 1]; ++k)
+            continue;
+    }
+
+    for (int i = k + 1; i < 5; ++i)
+        ++n[i];
+
+    // Adjust the middle markers toward their desired positions.
+    for (int i = 1; i < 4; ++i) {
+        double want = 1.0 + count * (i / 4.0);
+        double d = want - n[i];
+
+        if ((d >=  1.0 && n[i + 1] - n[i] >  1) ||
+            (d <= -1.0 && n[i - 1] - n[i] < -1))
+        {
+            int s = (d > 0) ? 1 : -1;
+
+            // Piecewise-parabolic prediction.
+            double qp = q[i] + (double) s / (n[i + 1] - n[i - 1]) *
+                ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) /
+                 (n[i + 1] - n[i]) +
+                 (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) /
+                 (n[i] - n[i - 1]));
+
+            if (q[i - 1] < qp && qp < q[i + 1])
+                q[i] = qp;
+            else
+                q[i] += s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+
+            n[i] += s;
+        }
+    }
+}
+
+double psquare_median(const objstat_t* stat, int count)
 {
-    int i, j;
+    if (count > 5)
+        return stat->q[2];
 
-    // Initialize the destination hperf_t.
-    for (i = 0; i < dst->len; ++i)
-        dst->obj[i] = 0.0;
+    if (count % 2)
+        return stat->q[count / 2];
+    else
+        return (stat->q[count / 2 - 1] + stat->q[count / 2]) / 2;
+}
 
-    // Calculate the mean of each objective individually.
-    for (j = 0; j < count; ++j)
-        for (i = 0; i < dst->len; ++i)
-            dst->obj[i] += src[j].obj[i];
+/*
+ * Return the index slot which holds the given point ID, or the empty
+ * slot where it belongs.
+ */
+unsigned index_slot(hplugin_data_t* data, int id)
+{
+    unsigned mask = data->index_cap - 1;
+    unsigned slot = ((unsigned) id * 2654435761U) & mask;
 
-    for (i = 0; i < dst->len; ++i)
-        dst->obj[i] /= data->trial_per_point;
+    while (data->index[slot]) {
+        if (data->slist[ data->index[slot] - 1 ].id == id)
+            break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
 }
 
-int perf_sort(const void* _a, const void* _b)
+int index_grow(hplugin_data_t* data)
 {
-    double a = hperf_unify((const hperf_t*)_a);
-    double b = hperf_unify((const hperf_t*)_b);
+    int cap = data->index_cap ? data->index_cap << 1 : 64;
+
+    int* newbuf = calloc(cap, sizeof(*newbuf));
+    if (!newbuf) {
+        search_error("Could not allocate aggregator index");
+        return -1;
+    }
+    free(data->index);
+    data->index = newbuf;
+    data->index_cap = cap;
 
-    return (a > b) - (a < b);
+    for (int i = 0; i < data->slist_len; ++i) {
+        if (data->slist[i].id != -1)
+            data->index[ index_slot(data, data->slist[i].id) ] = i + 1;
+    }
+    return 0;
 }
 
 int add_storage(hplugin_data_t* data)
@@ -261,15 +632,19 @@ int add_storage(hplugin_data_t* data)
         return -1;
     }
 
-    while (prev_len < data->slist_len) {
-        data->slist[prev_len].id = -1;
-        data->slist[prev_len].trial = calloc(data->trial_per_point,
-                                             sizeof(hperf_t));
-        if (!data->slist[prev_len].trial) {
-            search_error("Could not allocate memory for trial list");
+    for (int i = data->slist_len - 1; i >= prev_len; --i) {
+        store_t* store = &data->slist[i];
+
+        store->id = -1;
+        store->min = malloc(data->obj_count * sizeof(*store->min));
+        store->max = malloc(data->obj_count * sizeof(*store->max));
+        store->stat = malloc(data->obj_count * sizeof(*store->stat));
+        if (!store->min || !store->max || !store->stat) {
+            search_error("Could not allocate memory for aggregator store");
             return -1;
         }
-        ++prev_len;
+        store->next = data->free_head;
+        data->free_head = i;
     }
     return 0;
 }
@@ -277,9 +652,10 @@ int add_storage(hplugin_data_t* data)
 void free_storage(hplugin_data_t* data)
 {
     for (int i = 0; i < data->slist_len; ++i) {
-        for (int j = 0; j < data->trial_per_point; ++j)
-            hperf_fini(&data->slist[i].trial[j]);
-        free(data->slist[i].trial);
+        free(data->slist[i].min);
+        free(data->slist[i].max);
+        free(data->slist[i].stat);
     }
     free(data->slist);
+    free(data->index);
 }
@@ -17,6 +17,8 @@
  * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _XOPEN_SOURCE 600 // Needed for ftruncate().
+
 /**
  * \page cache Point Caching/Replay layer (cache.so)
  *
@@ -29,6 +31,21 @@
  *
  * The cache may optionally be initialized by a log file generated
  * from the [Point Logger](\ref logger).
+ *
+ * The cache may also be persisted to a binary database file.  New
+ * measurements are appended to the file as they arrive, and an
+ * existing file is memory-mapped upon initialization so that its
+ * records are served in place, without a parsing step.  Database
+ * files are tied to the search space that created them, and use the
+ * host's native byte order.
+ *
+ * Searches within the same process may share a single cache by
+ * enabling CACHE_SHARED.  Shared caches are keyed by a fingerprint of
+ * the search space definition (not its name), so a point measured by
+ * one search becomes a cache hit for every other search over an
+ * identical space.  Searches only share a cache if they also name the
+ * same CACHE_DB file, or none at all.  The log file and database of a
+ * shared cache are loaded by the first search to use it.
  */
 
 #include "hlayer.h"
@@ -36,13 +53,18 @@
 #include "hspace.h"
 #include "hpoint.h"
 #include "hperf.h"
+#include "harena.h"
 #include "hutil.h"
 #include "hcfg.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
  * Name used to identify this plugin layer.
@@ -56,17 +78,78 @@ const char hplugin_name[] = "cache";
  */
 const hcfg_info_t hplugin_keyinfo[] = {
     { CFGKEY_CACHE_FILE, NULL, "Log file generated by the Point Logger." },
+    { CFGKEY_CACHE_DB, NULL,
+      "Binary cache database file.  Created if it does not exist, "
+      "and extended with each new measurement." },
+    { CFGKEY_CACHE_SHARED, "False",
+      "Share the cache with all other searches in this process that "
+      "use an identical search space." },
     { NULL }
 };
 
+/*
+ * Cache records consist of one 64-bit word per point term (integer
+ * value, real value, or enumerated set index), followed by one word
+ * per performance objective.  Binary database files hold a header
+ * followed by an array of these records.
+ */
+typedef union {
+    int64_t  i;
+    uint64_t u;
+    double   r;
+} cache_word_t;
+
+#define CACHE_DB_MAGIC "HCACHE01"
+
 typedef struct {
-    hpoint_t point;
-    hperf_t* perf;
-    int      idx;
-    int      plen;
-    int      pcap;
+    char     magic[8];
+    uint32_t i_cnt;
+    uint32_t o_cnt;
+    uint64_t space_id;
+} cache_hdr_t;
+
+typedef struct {
+    const cache_word_t*  point;
+    uint64_t             key;
+    const cache_word_t** perf;
+    int                  idx;
+    int                  plen;
+    int                  pcap;
 } cache_t;
 
+/*
+ * Cached records and their index.  A store is either private to one
+ * search, or shared by all searches of an identical search space.
+ */
+typedef struct {
+    uint64_t space_id;
+    hspace_t space;
+    char*    db_path;
+    int      i_cnt;
+    int      o_cnt;
+    int      shared;
+    int      refs;
+    cache_t* cache;
+    int      cache_len, cache_cap;
+    int*     index;
+    int      index_cap;
+    harena_t arena;
+    int      db_fd;
+    void*    db_map;
+    size_t   db_maplen;
+} cache_store_t;
+
+// Flags for cache_insert().
+#define CACHE_COPY 0x1 // Copy the record into the cache arena.
+#define CACHE_SAVE 0x2 // Append the record to the cache database.
+
+/*
+ * Shared cache stores.  Plug-in layers are loaded once per process,
+ * so this list is visible to every search instance of this layer.
+ */
+static cache_store_t** shared_list;
+static int             shared_len, shared_cap;
+
 /*
  * Structure to hold all data needed by an individual search instance.
  *
@@ -75,22 +158,37 @@ typedef struct {
  * instead be defined as a part of this structure.
  */
 struct hplugin_data {
-    hrange_t* dim;
-    cache_t*  cache;
-    int       cache_len, cache_cap;
-    int       hit;
-    int       i_cnt;
-    int       o_cnt;
-    char*     buf;
-    int       buflen;
+    const hspace_t* space;
+    hrange_t*      dim;
+    cache_store_t* store;
+    cache_word_t*  rec;
+    int            hit;
+    int            i_cnt;
+    int            o_cnt;
+    char*          buf;
+    int            buflen;
 };
 
 /*
  * Internal helper function prototypes.
  */
-static cache_t* cache_find(hplugin_data_t* data, htrial_t* trial);
-static int      cache_insert(hplugin_data_t* data, htrial_t* trial);
+static int      cache_encode(hplugin_data_t* data, const hpoint_t* point,
+                             const hperf_t* perf);
+static uint64_t cache_key(hplugin_data_t* data, const cache_word_t* rec);
+static int      cache_slot(cache_store_t* store, const cache_word_t* rec,
+                           uint64_t key);
+static int      cache_rehash(cache_store_t* store, int len);
+static int      cache_insert(hplugin_data_t* data, const cache_word_t* rec,
+                             int flags);
 static int      cache_lookup(hplugin_data_t* data, htrial_t* trial);
+static int      store_open(hplugin_data_t* data, int* created);
+static int      store_match(const cache_store_t* store,
+                            hplugin_data_t* data, uint64_t space_id,
+                            const char* db_path);
+static void     store_close(cache_store_t* store);
+static int      db_open(hplugin_data_t* data, const char* filename);
+static int      db_append(cache_store_t* store, const cache_word_t* rec);
+static void     db_close(cache_store_t* store);
 static int      find_max_strlen(hplugin_data_t* data);
 static int      load_logger_file(hplugin_data_t* data, const char* logger);
 static int      safe_scanstr(hplugin_data_t* data, FILE* fd, int bounds_idx,
@@ -112,11 +210,13 @@ hplugin_data_t* cache_alloc(void)
  * Initialize (or re-initialize) data for this search task.
  *
  * Also loads data into cache from a log file if configuration
- * variable CACHE_FILE is defined.
+ * variable CACHE_FILE is defined, and from a binary database if
+ * configuration variable CACHE_DB is defined.
  */
 int cache_init(hplugin_data_t* data, hspace_t* space)
 {
     const char* filename;
+    int created;
 
     data->i_cnt = space->len;
     data->o_cnt = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
@@ -125,17 +225,34 @@ int cache_init(hplugin_data_t* data, hspace_t* space)
                      " configuration key");
         return -1;
     }
+    data->space = space;
     data->dim = space->dim;
+    data->hit = 0;
 
-    for (int i = 0; i < data->cache_cap; ++i) {
-        hpoint_fini(&data->cache[i].point);
+    cache_word_t* newbuf = realloc(data->rec, (data->i_cnt + data->o_cnt) *
+                                              sizeof(*data->rec));
+    if (!newbuf) {
+        search_error("Could not allocate cache record buffer");
+        return -1;
+    }
+    data->rec = newbuf;
 
-        for (int j = 0; j < data->cache[i].pcap; ++j)
-            hperf_fini(&data->cache[i].perf[j]);
-        free(data->cache[i].perf);
+    if (data->store) {
+        store_close(data->store);
+        data->store = NULL;
+    }
+
+    if (store_open(data, &created) != 0)
+        return -1;
+
+    if (!created)
+        return 0; // Shared store already loaded by another search.
+
+    filename = hcfg_get(search_cfg, CFGKEY_CACHE_DB);
+    if (filename) {
+        if (db_open(data, filename) != 0)
+            return -1;
     }
-    memset(data->cache, 0, data->cache_cap * sizeof(*data->cache));
-    data->cache_len = 0;
 
     filename = hcfg_get(search_cfg, CFGKEY_CACHE_FILE);
     if (filename) {
@@ -193,8 +310,10 @@ int cache_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
 {
     if (!data->hit) {
         // Insert the performance into the cache.
-        if (cache_insert(data, trial) != 0)
-            return -1;
+        if (cache_encode(data, &trial->point, &trial->perf) == 0) {
+            if (cache_insert(data, data->rec, CACHE_COPY | CACHE_SAVE) != 0)
+                return -1;
+        }
     }
     else {
         data->hit = 0; // Clear the cache hit flag.
@@ -209,14 +328,9 @@ int cache_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
  */
 int cache_fini(hplugin_data_t* data)
 {
-    for (int i = 0; i < data->cache_cap; ++i) {
-        hpoint_fini(&data->cache[i].point);
-
-        for (int j = 0; j < data->cache[i].pcap; ++j)
-            hperf_fini(&data->cache[i].perf[j]);
-        free(data->cache[i].perf);
-    }
-    free(data->cache);
+    if (data->store)
+        store_close(data->store);
+    free(data->rec);
 
     free(data);
     return 0;
@@ -226,55 +340,218 @@ int cache_fini(hplugin_data_t* data)
  * Internal helper function implementation.
  */
 
-cache_t* cache_find(hplugin_data_t* data, htrial_t* trial)
+/*
+ * Encode a point (and optionally, its performance) into the scratch
+ * cache record.  Real values are normalized so that records may be
+ * compared bitwise.
+ *
+ * Returns -1 if the point cannot be represented in this search space.
+ * Points evaluated with only part of the full budget are never
+ * cached, since their performance is not comparable.
+ */
+int cache_encode(hplugin_data_t* data, const hpoint_t* point,
+                 const hperf_t* perf)
 {
-    int head = 0;
-    int tail = data->cache_len - 1;
+    cache_word_t* rec = data->rec;
+
+    if (point->len != data->i_cnt)
+        return -1;
+
+    if (point->budget > 0.0 && point->budget < 1.0)
+        return -1;
+
+    for (int i = 0; i < data->i_cnt; ++i) {
+        const hval_t* val = &point->term[i];
+        unsigned long idx;
+
+        if (val->type != data->dim[i].type)
+            return -1;
 
-    while (head <= tail) {
-        int mid    = (head + tail) / 2;
-        int retval = hpoint_cmp(&trial->point, &data->cache[ mid ].point);
+        switch (val->type) {
+        case HVAL_INT:
+            rec[i].i = val->value.i;
+            break;
+        case HVAL_REAL:
+            rec[i].r = (val->value.r == 0.0) ? 0.0 : val->value.r;
+            break;
+        case HVAL_STR:
+            idx = hrange_index(&data->dim[i], val);
+            if (idx >= (unsigned long) data->dim[i].bounds.e.len)
+                return -1;
+            rec[i].u = idx;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (perf) {
+        if (perf->len != data->o_cnt)
+            return -1;
 
-        if      (retval < 0) tail = mid - 1;
-        else if (retval > 0) head = mid + 1;
-        else return &data->cache[mid];
+        for (int i = 0; i < data->o_cnt; ++i)
+            rec[data->i_cnt + i].r = perf->obj[i];
     }
-    return NULL;
+    return 0;
 }
 
-int cache_insert(hplugin_data_t* data, htrial_t* trial)
+/*
+ * Compute the hash key of a cache record.  Points in a finite search
+ * space are keyed by their mixed-radix rank, which is unique per
+ * point.  Otherwise, the encoded point words are hashed (FNV-1a).
+ */
+uint64_t cache_key(hplugin_data_t* data, const cache_word_t* rec)
 {
-    cache_t* hit = cache_find(data, trial);
-    if (!hit) {
+    const hspace_t* space = data->space;
+    uint64_t key = 0;
+    int i;
+
+    for (i = 0; space->size && i < data->i_cnt; ++i) {
+        hval_t val = HVAL_INITIALIZER;
+        unsigned long idx;
+
+        switch (space->dim[i].type) {
+        case HVAL_INT:
+            val.type = HVAL_INT;
+            val.value.i = rec[i].i;
+            idx = hrange_index(&space->dim[i], &val);
+            break;
+        case HVAL_REAL:
+            val.type = HVAL_REAL;
+            val.value.r = rec[i].r;
+            idx = hrange_index(&space->dim[i], &val);
+            break;
+        default:
+            idx = rec[i].u;
+        }
+
+        if (idx >= hrange_limit(&space->dim[i]))
+            break;
+        key += idx * space->stride[i];
+    }
+    if (space->size && i == data->i_cnt)
+        return key;
+
+    const unsigned char* ptr = (const unsigned char*) rec;
+    key = 14695981039346656037ULL;
+    for (size_t n = data->i_cnt * sizeof(*rec); n; --n) {
+        key ^= *(ptr++);
+        key *= 1099511628211ULL;
+    }
+    return key;
+}
+
+/*
+ * Return the index slot which holds the given point, or the empty
+ * slot where it would be inserted.  Index slots hold cache offsets
+ * plus one, so that zero marks an empty slot.
+ *
+ * Keys are only a filter; matching entries are confirmed by value.
+ */
+int cache_slot(cache_store_t* store, const cache_word_t* rec, uint64_t key)
+{
+    uint64_t mix = key;
+    mix ^= mix >> 33;
+    mix *= 0xff51afd7ed558ccdULL;
+    mix ^= mix >> 33;
+
+    unsigned mask = store->index_cap - 1;
+    unsigned slot = (unsigned) mix & mask;
+
+    while (store->index[slot]) {
+        cache_t* entry = &store->cache[ store->index[slot] - 1 ];
+
+        if (entry->key == key &&
+            memcmp(entry->point, rec, store->i_cnt * sizeof(*rec)) == 0)
+            break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * (Re)build the cache index so that it may hold at least len points
+ * while remaining no more than half full.
+ */
+int cache_rehash(cache_store_t* store, int len)
+{
+    int cap = store->index_cap ? store->index_cap : 64;
+    while (cap < 2 * len)
+        cap *= 2;
+
+    if (cap != store->index_cap) {
+        int* newbuf = realloc(store->index, cap * sizeof(*newbuf));
+        if (!newbuf)
+            return -1;
+
+        store->index = newbuf;
+        store->index_cap = cap;
+    }
+
+    memset(store->index, 0, store->index_cap * sizeof(*store->index));
+    for (int i = 0; i < store->cache_len; ++i) {
+        cache_t* entry = &store->cache[i];
+        store->index[ cache_slot(store, entry->point, entry->key) ] = i + 1;
+    }
+    return 0;
+}
+
+/*
+ * Add a record to the cache.  Records are referenced in place unless
+ * CACHE_COPY is given, so they must outlive the cache contents.
+ */
+int cache_insert(hplugin_data_t* data, const cache_word_t* rec, int flags)
+{
+    cache_store_t* store = data->store;
+    int reclen = store->i_cnt + store->o_cnt;
+    uint64_t key = cache_key(data, rec);
+    int slot = cache_slot(store, rec, key);
+    cache_t* hit;
+
+    if (flags & CACHE_COPY) {
+        cache_word_t* copy = harena_alloc(&store->arena,
+                                          reclen * sizeof(*copy));
+        if (!copy) {
+            search_error("Could not copy record into cache");
+            return -1;
+        }
+        memcpy(copy, rec, reclen * sizeof(*copy));
+        rec = copy;
+    }
+
+    if ((flags & CACHE_SAVE) && store->db_fd != -1) {
+        if (db_append(store, rec) != 0)
+            return -1;
+    }
+
+    if (store->index[slot]) {
+        hit = &store->cache[ store->index[slot] - 1 ];
+    }
+    else {
         // Extend the cache, if necessary.
-        if (data->cache_len == data->cache_cap) {
-            if (array_grow(&data->cache, &data->cache_cap,
-                           sizeof(*data->cache)) != 0)
+        if (store->cache_len == store->cache_cap) {
+            if (array_grow(&store->cache, &store->cache_cap,
+                           sizeof(*store->cache)) != 0)
             {
                 search_error("Could not extend cache");
                 return -1;
             }
         }
 
-        // Find the appropriate cache slot.
-        hit = &data->cache[ data->cache_len ];
-        while (data->cache < hit) {
-            cache_t* prev = hit - 1;
-            if (hpoint_cmp(&trial->point, &prev->point) >= 0)
-                break;
-
-            *hit = *prev;
-            hit = prev;
-        }
-
-        // Initialize the cache slot.
+        // Initialize the new cache entry at the end of the list.
+        hit = &store->cache[ store->cache_len ];
         memset(hit, 0, sizeof(*hit));
-        if (hpoint_copy(&hit->point, &trial->point) != 0) {
-            search_error("Could not copy trial point into cache");
-            return -1;
+        hit->point = rec;
+        hit->key = key;
+
+        // Link the new entry into the index, growing it if necessary.
+        store->index[slot] = ++store->cache_len;
+        if (2 * store->cache_len > store->index_cap) {
+            if (cache_rehash(store, store->cache_len) != 0) {
+                search_error("Could not extend cache index");
+                return -1;
+            }
         }
-
-        ++data->cache_len;
     }
 
     // Extend the cache slot's performance list, if necessary.
@@ -285,11 +562,8 @@ int cache_insert(hplugin_data_t* data, htrial_t* trial)
         }
     }
 
-    // Add the performance to the end of the list.
-    if (hperf_copy(&hit->perf[hit->plen], &trial->perf) != 0) {
-        search_error("Could not copy performance into cache");
-        return -1;
-    }
+    // Add the record to the end of the list.
+    hit->perf[hit->plen] = rec;
     ++hit->plen;
 
     return 0;
@@ -297,12 +571,23 @@ int cache_insert(hplugin_data_t* data, htrial_t* trial)
 
 int cache_lookup(hplugin_data_t* data, htrial_t* trial)
 {
-    cache_t* hit = cache_find(data, trial);
-    if (hit) {
-        if (hperf_copy(&trial->perf, &hit->perf[hit->idx]) != 0) {
+    cache_store_t* store = data->store;
+
+    if (cache_encode(data, &trial->point, NULL) != 0)
+        return 0; // Points outside the search space are never cached.
+
+    int slot = cache_slot(store, data->rec, cache_key(data, data->rec));
+    if (store->index[slot]) {
+        cache_t* hit = &store->cache[ store->index[slot] - 1 ];
+        const cache_word_t* rec = hit->perf[hit->idx];
+
+        if (hperf_init(&trial->perf, data->o_cnt) != 0) {
             search_error("Could not copy performance on cache hit");
             return -1;
         }
+        for (int i = 0; i < data->o_cnt; ++i)
+            trial->perf.obj[i] = rec[data->i_cnt + i].r;
+        trial->perf.len = data->o_cnt;
 
         // Increment/wrap the return index.
         hit->idx = (hit->idx + 1) % hit->plen;
@@ -311,6 +596,236 @@ int cache_lookup(hplugin_data_t* data, htrial_t* trial)
     return 0;
 }
 
+/*
+ * Attach this search to a cache store.  If CACHE_SHARED is enabled
+ * and a shared store for an identical search space exists, it is
+ * reused.  Otherwise, a new (empty) store is created, and the created
+ * flag is set.
+ */
+int store_open(hplugin_data_t* data, int* created)
+{
+    uint64_t space_id = hspace_hash(data->space);
+    const char* db_path = hcfg_get(search_cfg, CFGKEY_CACHE_DB);
+    int shared = hcfg_bool(search_cfg, CFGKEY_CACHE_SHARED);
+    cache_store_t* store;
+
+    *created = 0;
+    for (int i = 0; shared && i < shared_len; ++i) {
+        store = shared_list[i];
+        if (store_match(store, data, space_id, db_path)) {
+            ++store->refs;
+            data->store = store;
+            return 0;
+        }
+    }
+
+    store = calloc(1, sizeof(*store));
+    if (!store) {
+        search_error("Could not allocate cache store");
+        return -1;
+    }
+    store->space_id = space_id;
+    store->i_cnt = data->i_cnt;
+    store->o_cnt = data->o_cnt;
+    store->refs = 1;
+    store->db_fd = -1;
+
+    if (hspace_copy(&store->space, data->space) != 0) {
+        search_error("Could not copy search space into cache store");
+        goto error;
+    }
+
+    if (db_path) {
+        store->db_path = stralloc(db_path);
+        if (!store->db_path) {
+            search_error("Could not copy cache database filename");
+            goto error;
+        }
+    }
+
+    if (cache_rehash(store, 0) != 0) {
+        search_error("Could not allocate cache index");
+        goto error;
+    }
+
+    if (shared) {
+        if (shared_len == shared_cap) {
+            if (array_grow(&shared_list, &shared_cap,
+                           sizeof(*shared_list)) != 0)
+            {
+                search_error("Could not extend shared cache list");
+                goto error;
+            }
+        }
+        shared_list[shared_len++] = store;
+        store->shared = 1;
+    }
+
+    data->store = store;
+    *created = 1;
+    return 0;
+
+  error:
+    store_close(store);
+    return -1;
+}
+
+/*
+ * Determine whether a shared store may serve this search.  The search
+ * spaces must be identical apart from their names, which the 64-bit
+ * fingerprint alone cannot guarantee, and both searches must use the
+ * same database file (or none at all).
+ */
+int store_match(const cache_store_t* store, hplugin_data_t* data,
+                uint64_t space_id, const char* db_path)
+{
+    if (store->space_id != space_id ||
+        store->i_cnt != data->i_cnt || store->o_cnt != data->o_cnt)
+        return 0;
+
+    hspace_t space = store->space;
+    space.name = data->space->name;
+    if (!hspace_equal(&space, data->space))
+        return 0;
+
+    if (!store->db_path || !db_path)
+        return store->db_path == db_path;
+
+    return strcmp(store->db_path, db_path) == 0;
+}
+
+/*
+ * Detach from a cache store, and release it if no other search
+ * instances remain attached.
+ */
+void store_close(cache_store_t* store)
+{
+    if (--store->refs > 0)
+        return;
+
+    if (store->shared) {
+        for (int i = 0; i < shared_len; ++i) {
+            if (shared_list[i] == store) {
+                shared_list[i] = shared_list[--shared_len];
+                break;
+            }
+        }
+    }
+
+    // Cache records are released in bulk.
+    for (int i = 0; i < store->cache_len; ++i)
+        free(store->cache[i].perf);
+    free(store->cache);
+    free(store->index);
+    harena_fini(&store->arena);
+    db_close(store);
+
+    free(store->db_path);
+    hspace_fini(&store->space);
+    free(store);
+}
+
+/*
+ * Open (or create) a binary cache database, and index any records it
+ * holds directly from a read-only memory mapping of the file.
+ */
+int db_open(hplugin_data_t* data, const char* filename)
+{
+    cache_store_t* store = data->store;
+    size_t reclen = (store->i_cnt + store->o_cnt) * sizeof(cache_word_t);
+    cache_hdr_t hdr;
+    struct stat sb;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CACHE_DB_MAGIC, sizeof(hdr.magic));
+    hdr.i_cnt = store->i_cnt;
+    hdr.o_cnt = store->o_cnt;
+    hdr.space_id = store->space_id;
+
+    store->db_fd = open(filename, O_RDWR | O_CREAT | O_APPEND, 0666);
+    if (store->db_fd == -1) {
+        search_error("Could not open cache database");
+        return -1;
+    }
+
+    if (fstat(store->db_fd, &sb) != 0) {
+        search_error("Could not query cache database size");
+        return -1;
+    }
+
+    if (sb.st_size == 0) {
+        if (write(store->db_fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+            search_error("Could not write cache database header");
+            return -1;
+        }
+        return 0;
+    }
+
+    if ((size_t) sb.st_size < sizeof(hdr)) {
+        search_error("Invalid cache database file");
+        return -1;
+    }
+
+    store->db_map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED,
+                         store->db_fd, 0);
+    if (store->db_map == MAP_FAILED) {
+        store->db_map = NULL;
+        search_error("Could not map cache database");
+        return -1;
+    }
+    store->db_maplen = sb.st_size;
+
+    if (memcmp(store->db_map, &hdr, sizeof(hdr)) != 0) {
+        search_error("Cache database does not match search space");
+        return -1;
+    }
+
+    // Index the mapped records in place.
+    size_t count = (sb.st_size - sizeof(hdr)) / reclen;
+    const cache_word_t* rec = (const cache_word_t*)
+        ((const char*) store->db_map + sizeof(hdr));
+
+    for (size_t i = 0; i < count; ++i) {
+        if (cache_insert(data, rec, 0) != 0)
+            return -1;
+        rec += store->i_cnt + store->o_cnt;
+    }
+
+    // Discard any partial record left by an interrupted write.
+    if (sizeof(hdr) + count * reclen != (size_t) sb.st_size) {
+        if (ftruncate(store->db_fd, sizeof(hdr) + count * reclen) != 0) {
+            search_error("Could not truncate partial cache database record");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int db_append(cache_store_t* store, const cache_word_t* rec)
+{
+    size_t reclen = (store->i_cnt + store->o_cnt) * sizeof(*rec);
+
+    if (write(store->db_fd, rec, reclen) != (ssize_t) reclen) {
+        search_error("Could not append record to cache database");
+        return -1;
+    }
+    return 0;
+}
+
+void db_close(cache_store_t* store)
+{
+    if (store->db_map) {
+        munmap(store->db_map, store->db_maplen);
+        store->db_map = NULL;
+        store->db_maplen = 0;
+    }
+
+    if (store->db_fd != -1) {
+        close(store->db_fd);
+        store->db_fd = -1;
+    }
+}
+
 /*
  * Search the parameter space for any HVAL_STR dimensions, and return
  * the length of the largest possible string.
@@ -415,7 +930,9 @@ int load_logger_file(hplugin_data_t* data, const char* filename)
             goto error;
         }
 
-        if (cache_insert(data, &trial) != 0) {
+        if (cache_encode(data, &trial.point, &trial.perf) != 0 ||
+            cache_insert(data, data->rec, CACHE_COPY) != 0)
+        {
             search_error("Could insert log data into cache");
             goto error;
         }
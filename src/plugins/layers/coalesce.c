@@ -0,0 +1,385 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page coalesce In-Flight Duplicate Coalescer (coalesce.so)
+ *
+ * This processing layer prevents clients from evaluating the same
+ * point more than once at a time.  If the strategy generates a point
+ * identical to one that is already being evaluated, the duplicate is
+ * held in this layer instead of being sent to a client.  When the
+ * performance of the original point is reported, it is copied to
+ * every held duplicate, and the duplicates continue through the
+ * analysis workflow as if they had been evaluated independently.
+ *
+ * Layers listed after this one in LAYERS (closer to the client) only
+ * observe the original point.  Layers listed before it (closer to
+ * the strategy) observe the original and each duplicate.  If a layer
+ * after this one rejects a point, and the strategy regenerates it
+ * under the same point ID, one held duplicate (if any) is promoted to
+ * take its place.
+ */
+
+#include "hlayer.h"
+#include "session-core.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+#include "hcfg.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/*
+ * Name used to identify this plugin layer.
+ * All Harmony plugin layers must define this variable.
+ */
+const char hplugin_name[] = "coalesce";
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { NULL }
+};
+
+/*
+ * A point currently under evaluation, and the duplicates which await
+ * its result.
+ */
+typedef struct inflight {
+    hpoint_t point;
+    hperf_t  perf;
+    int      leader;  // Point ID of the evaluated trial (0 if orphaned).
+    int      done;    // Performance of the leader has been reported.
+    int      parked;  // Duplicates held in the generate wait list.
+    int      refs;    // Duplicates not yet analyzed by this layer.
+} inflight_t;
+
+/*
+ * Structure to hold all data needed by an individual search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    inflight_t* list;
+    int         len, cap;
+    int         notify[2];
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int  coalesce_callback(int fd, void* data_ptr,
+                              hflow_t* flow, int n, htrial_t** trial);
+static int  find_point(hplugin_data_t* data, const hpoint_t* point);
+static int  find_leader(hplugin_data_t* data, int id);
+static int  add_point(hplugin_data_t* data, const hpoint_t* point);
+static void remove_point(hplugin_data_t* data, int idx);
+static int  notify(hplugin_data_t* data, int count);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* coalesce_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->notify[0] = -1;
+    retval->notify[1] = -1;
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ *
+ * Held duplicates are released through a generate-side callback,
+ * which is triggered by writing one byte per release into a pipe.
+ */
+int coalesce_init(hplugin_data_t* data, hspace_t* space)
+{
+    if (data->notify[0] == -1) {
+        if (pipe(data->notify) != 0) {
+            search_error("Could not create coalesce notification pipe");
+            return -1;
+        }
+
+        int flags = fcntl(data->notify[0], F_GETFL);
+        if (flags == -1 ||
+            fcntl(data->notify[0], F_SETFL, flags | O_NONBLOCK) != 0)
+        {
+            search_error("Could not configure coalesce notification pipe");
+            return -1;
+        }
+
+        if (search_callback_generate(data->notify[0], data,
+                                     coalesce_callback) != 0)
+        {
+            search_error("Could not register coalesce callback");
+            return -1;
+        }
+    }
+
+    // Forget all in-flight points, except those with held duplicates.
+    // Session-core keeps held trials in its wait list across a
+    // restart, so they must still be released.  Orphan each original
+    // point still under evaluation, so one duplicate is promoted to
+    // take its place and the others follow its result.
+    //
+    for (int i = data->len - 1; i >= 0; --i) {
+        inflight_t* entry = &data->list[i];
+
+        if (!entry->parked) {
+            remove_point(data, i);
+        }
+        else if (!entry->done && entry->leader) {
+            entry->leader = 0;
+            if (notify(data, 1) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Hold any point that is identical to a point already under
+ * evaluation.  If the original's performance is already known, it
+ * is returned immediately instead.
+ */
+int coalesce_generate(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
+{
+    // A regenerated point replaces its previous incarnation.
+    int idx = find_leader(data, trial->point.id);
+    if (idx >= 0 && !data->list[idx].done) {
+        inflight_t* entry = &data->list[idx];
+
+        if (entry->parked) {
+            entry->leader = 0;
+            if (notify(data, 1) != 0)
+                return -1;
+        }
+        else {
+            remove_point(data, idx);
+        }
+    }
+
+    idx = find_point(data, &trial->point);
+    if (idx < 0) {
+        if (add_point(data, &trial->point) != 0)
+            return -1;
+
+        flow->status = HFLOW_ACCEPT;
+        return 0;
+    }
+
+    inflight_t* entry = &data->list[idx];
+    ++entry->refs;
+    if (entry->done) {
+        if (hperf_copy(&trial->perf, &entry->perf) != 0) {
+            search_error("Could not copy coalesced performance");
+            return -1;
+        }
+        flow->status = HFLOW_RETURN;
+    }
+    else {
+        ++entry->parked;
+        flow->status = HFLOW_WAIT;
+    }
+    return 0;
+}
+
+/*
+ * Record the performance of an original point, and schedule the
+ * release of its duplicates.
+ */
+int coalesce_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
+{
+    flow->status = HFLOW_ACCEPT;
+
+    int idx = find_point(data, &trial->point);
+    if (idx < 0)
+        return 0;
+
+    inflight_t* entry = &data->list[idx];
+    if (entry->leader == trial->point.id && !entry->done) {
+        if (hperf_copy(&entry->perf, &trial->perf) != 0) {
+            search_error("Could not store coalesced performance");
+            return -1;
+        }
+        entry->done = 1;
+
+        if (notify(data, entry->parked) != 0)
+            return -1;
+    }
+    else if (entry->refs > entry->parked) {
+        // Only a released duplicate may be counted here.  An orphaned
+        // original that completes late is ignored.
+        --entry->refs;
+    }
+
+    if (entry->done && entry->refs == 0)
+        remove_point(data, idx);
+
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int coalesce_fini(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->cap; ++i) {
+        hpoint_fini(&data->list[i].point);
+        hperf_fini(&data->list[i].perf);
+    }
+    free(data->list);
+
+    if (data->notify[0] != -1) close(data->notify[0]);
+    if (data->notify[1] != -1) close(data->notify[1]);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+/*
+ * Release a single held duplicate.  Duplicates of a completed point
+ * are returned with its performance, while a duplicate of an orphaned
+ * point is promoted to be evaluated in its place.
+ */
+int coalesce_callback(int fd, void* data_ptr,
+                      hflow_t* flow, int n, htrial_t** trial)
+{
+    hplugin_data_t* data = (hplugin_data_t*) data_ptr;
+    char byte;
+
+    if (read(fd, &byte, sizeof(byte)) < 1)
+        return -1; // Spurious wakeup.
+
+    for (int i = 0; i < n; ++i) {
+        int idx = find_point(data, &trial[i]->point);
+        if (idx < 0)
+            continue;
+
+        inflight_t* entry = &data->list[idx];
+        if (!entry->parked)
+            continue;
+
+        if (entry->done) {
+            if (hperf_copy(&trial[i]->perf, &entry->perf) != 0) {
+                search_error("Could not copy coalesced performance");
+                return -1;
+            }
+            flow->status = HFLOW_RETURN;
+        }
+        else if (!entry->leader) {
+            entry->leader = trial[i]->point.id;
+            --entry->refs;
+            flow->status = HFLOW_ACCEPT;
+        }
+        else continue;
+
+        --entry->parked;
+        return i;
+    }
+
+    search_error("Could not find releasable point in coalesce waitlist");
+    return -1;
+}
+
+int find_point(hplugin_data_t* data, const hpoint_t* point)
+{
+    for (int i = 0; i < data->len; ++i) {
+        if (hpoint_eq(&data->list[i].point, point))
+            return i;
+    }
+    return -1;
+}
+
+int find_leader(hplugin_data_t* data, int id)
+{
+    for (int i = 0; i < data->len; ++i) {
+        if (data->list[i].leader == id)
+            return i;
+    }
+    return -1;
+}
+
+int add_point(hplugin_data_t* data, const hpoint_t* point)
+{
+    if (data->len == data->cap) {
+        if (array_grow(&data->list, &data->cap, sizeof(*data->list)) != 0) {
+            search_error("Could not extend coalesce list");
+            return -1;
+        }
+    }
+
+    inflight_t* entry = &data->list[data->len];
+    if (hpoint_copy(&entry->point, point) != 0) {
+        search_error("Could not copy point into coalesce list");
+        return -1;
+    }
+    entry->leader = point->id;
+    entry->done = 0;
+    entry->parked = 0;
+    entry->refs = 0;
+
+    ++data->len;
+    return 0;
+}
+
+/*
+ * Remove an entry by swapping it with the last entry.  Its buffers
+ * are parked past the end of the list for reuse.
+ */
+void remove_point(hplugin_data_t* data, int idx)
+{
+    inflight_t tmp = data->list[idx];
+
+    --data->len;
+    data->list[idx] = data->list[data->len];
+    data->list[data->len] = tmp;
+}
+
+int notify(hplugin_data_t* data, int count)
+{
+    char buf[64] = {0};
+
+    while (count > 0) {
+        int len = count < (int) sizeof(buf) ? count : (int) sizeof(buf);
+
+        if (write(data->notify[1], buf, len) != len) {
+            search_error("Could not signal coalesce callback");
+            return -1;
+        }
+        count -= len;
+    }
+    return 0;
+}
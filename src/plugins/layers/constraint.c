@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
  */
+#define _XOPEN_SOURCE 500 // Needed for M_PI.
 
 /**
  * \page omega Omega Constraint (constraint.so)
@@ -42,9 +43,41 @@
  * conjunction of the set is applied to the
  * [Search Space](\ref intro_space).
  *
- * \note This processing layer requires the Omega Calculator, which is
- * available at:<br>
+ * Linear constraints are compiled when the layer is initialized, and
+ * evaluated directly for each generated point.  Such statements may
+ * combine integer or real constants and tuning variables with `+`,
+ * `-`, `*` (where one operand is constant), and parentheses.
+ * Comparisons may be chained (as in `0 < x < y`), and combined with
+ * `&&`, `||`, `!`, or their `and`, `or`, and `not` equivalents.
+ *
+ * \note Statements outside of this linear subset are passed to the
+ * Omega Calculator, which is available at:<br>
  * <https://github.com/davewathaverford/the-omega-project/>.
+ * If it is installed, the Omega Calculator is also used to suggest
+ * tighter bounds for each tuning variable.
+ *
+ * When the Omega Calculator is needed for validity checks, a single
+ * calculator process is kept for the lifetime of the search.  Points
+ * are held in this layer as they are generated, and tested together
+ * in one batched query once the current round of generation ends.
+ *
+ * When a point violates constraints from the linear subset, this
+ * layer suggests a valid replacement point to the search strategy,
+ * which strategies generally adopt in place of their own rejection
+ * handling.  The replacement is chosen according to `OC_REPAIR`:
+ *
+ * - `project` finds a nearby valid point.  The point is projected
+ *   onto the region described by the constraints (each variable is
+ *   scaled by the width of its range), and then moved to the nearest
+ *   valid point on the grid of values permitted by the search space.
+ * - `sample` draws replacements from across the valid region, using a
+ *   hit-and-run random walk.  Over time, these replacements are
+ *   distributed uniformly within the region.
+ * - `none` rejects the point without suggesting a replacement.
+ *
+ * No replacement is suggested if the constraints require the Omega
+ * Calculator, or if no valid point can be found near the rejected
+ * point.
  *
  * \note Some search strategies provide a `REJECT_METHOD`
  * configuration variable that can be used to specify how to deal with
@@ -62,12 +95,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <ctype.h>
+#include <math.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 /*
  * Name used to identify this plugin layer.
@@ -92,11 +129,80 @@ const hcfg_info_t hplugin_keyinfo[] = {
     { CFGKEY_OC_QUIET, "False",
       "Bounds suggestion and rejection messages can be suppressed "
       "by setting this variable to true." },
+    { CFGKEY_OC_REPAIR, "project",
+      "How to suggest a valid replacement for a rejected point.  "
+      "Replacements are only available for linear constraints.\n"
+      "    project: Suggest a nearby valid point.\n"
+      "    sample: Suggest a valid point sampled uniformly from the "
+      "valid region.\n"
+      "    none: Do not suggest replacement points." },
     { NULL }
 };
 
 #define MAX_CMD_LEN  4096
 #define MAX_TEXT_LEN 1024
+#define BATCH_SIZE   32768 // Bytes of Omega input per round-trip.
+
+#define STRICT_EPS   1e-9  // Violation of a strict comparison at zero.
+#define PROJECT_MAX  4     // Branch selections per projection.
+#define SWEEP_MAX    200   // Dykstra sweeps per projection.
+#define SHRINK_MAX   64    // Hit-and-run shrinkage steps.
+#define SEARCH_MAX   256   // Grid moves per repair.
+
+/*
+ * Compiled form of the linear constraint subset.  Each comparison is
+ * reduced to an affine row (constant term followed by one coefficient
+ * per tuning variable) compared against zero.  The comparisons are
+ * combined by a postfix program of logical operations.
+ */
+typedef enum relop {
+    REL_LT,
+    REL_LE,
+    REL_GT,
+    REL_GE,
+    REL_EQ,
+    REL_NE
+} relop_t;
+
+typedef enum opcode {
+    OP_REL,
+    OP_AND,
+    OP_OR,
+    OP_NOT
+} opcode_t;
+
+typedef struct instr {
+    opcode_t op;
+    relop_t  rel;
+    int      row;
+} instr_t;
+
+typedef enum repair_method {
+    REPAIR_METHOD_UNKNOWN = 0,
+    REPAIR_METHOD_NONE,
+    REPAIR_METHOD_PROJECT,
+    REPAIR_METHOD_SAMPLE,
+
+    REPAIR_METHOD_MAX
+} repair_method_t;
+
+/*
+ * A comparison (row < 0, row <= 0, or row = 0, after applying sign)
+ * selected to be satisfied during projection.
+ */
+typedef struct halfspace {
+    int    row;
+    double sign;
+    int    eq;
+} halfspace_t;
+
+/*
+ * A generated point awaiting a verdict from the Omega Calculator.
+ */
+typedef struct pending {
+    hpoint_t point;
+    int      verdict; // Non-zero if valid, or -1 until tested.
+} pending_t;
 
 /*
  * Structure to hold all data needed by an individual search instance.
@@ -117,6 +223,45 @@ struct hplugin_data {
     char point_text[MAX_TEXT_LEN];
 
     int quiet;
+
+    // Native constraint evaluator.
+    int         native;
+    const char* cursor;
+    int         width;
+    instr_t*    prog;
+    int         prog_len, prog_cap;
+    double*     rows;
+    int         rows_len, rows_cap;
+    int*        stack;
+    double*     coord;
+
+    // Rejected point repair.
+    repair_method_t repair;
+    int*         start;   // First instruction of each subformula.
+    double*      cost_t;  // Distance to satisfying each subformula.
+    double*      cost_f;  // Distance to violating each subformula.
+    halfspace_t* hs;
+    int          hs_len;
+    double*      corr;    // Dykstra correction vectors.
+    double*      scale;
+    double*      work;
+    double*      chain;   // Hit-and-run state, if chain_ok.
+    int          chain_ok;
+
+    // Persistent Omega Calculator coprocess.
+    int         oc_fd;
+    pid_t       oc_pid;
+    unsigned    oc_sync;
+    char*       oc_buf;
+    int         oc_buf_cap;
+    char*       cmd;
+    int         cmd_len, cmd_cap;
+
+    // Points held for the next batched validity query.
+    pending_t*  queue;
+    int         queue_len, queue_cap;
+    int         timer;
+    int         notify[2];
 };
 
 /*
@@ -128,8 +273,52 @@ static int   build_bounds_text(hplugin_data_t* data, hspace_t* space);
 static int   build_user_text(hplugin_data_t* data);
 static int   build_point_text(hplugin_data_t* data, hpoint_t* point);
 static int   update_bounds(hplugin_data_t* data, hspace_t* space);
-static int   check_validity(hplugin_data_t* data, hpoint_t* point);
+static void  print_rejected(hplugin_data_t* data, const hpoint_t* point);
 static char* call_omega_calc(hplugin_data_t* data, const char* cmd);
+static int   stop_omega_calc(hplugin_data_t* data);
+
+static int   batch_init(hplugin_data_t* data);
+static int   enqueue(hplugin_data_t* data, const hpoint_t* point);
+static int   find_queued(hplugin_data_t* data, unsigned id);
+static int   check_batch(hplugin_data_t* data);
+static int   retest_queue(hplugin_data_t* data);
+static int   signal_release(hplugin_data_t* data, int count);
+static int   query_batch(hplugin_data_t* data);
+static int   parse_batch(hplugin_data_t* data, const char* reply,
+                         int first, int last);
+static int   append_cmd(hplugin_data_t* data, const char* str);
+static int   flush_callback(int fd, void* data_ptr,
+                            hflow_t* flow, int n, htrial_t** trial);
+static int   release_callback(int fd, void* data_ptr,
+                              hflow_t* flow, int n, htrial_t** trial);
+
+static int   compile_native(hplugin_data_t* data);
+static int   check_native(hplugin_data_t* data, const hpoint_t* point);
+static int   parse_or(hplugin_data_t* data);
+static int   parse_and(hplugin_data_t* data);
+static int   parse_not(hplugin_data_t* data);
+static int   parse_chain(hplugin_data_t* data);
+static int   parse_relop(hplugin_data_t* data, relop_t* rel);
+static int   parse_sum(hplugin_data_t* data, double* vec);
+static int   parse_product(hplugin_data_t* data, double* vec);
+static int   parse_factor(hplugin_data_t* data, double* vec);
+static int   match(hplugin_data_t* data, const char* token);
+static int   at_keyword(hplugin_data_t* data);
+static int   emit(hplugin_data_t* data, opcode_t op, relop_t rel, int row);
+static int   add_row(hplugin_data_t* data, const double* lhs,
+                     const double* rhs);
+
+static int   repair_init(hplugin_data_t* data);
+static int   repair_point(hplugin_data_t* data, const hpoint_t* point,
+                          hpoint_t* hint);
+static double violation(hplugin_data_t* data, const double* x);
+static void  select_atoms(hplugin_data_t* data, int i, int want);
+static void  project(hplugin_data_t* data, double* x);
+static void  dykstra(hplugin_data_t* data, double* x);
+static void  hit_and_run(hplugin_data_t* data);
+static double snap(const hrange_t* range, double val);
+static double grid_step(const hrange_t* range);
+static int   grid_search(hplugin_data_t* data, double* x);
 
 /*
  * Allocate memory for a new search task.
@@ -140,6 +329,9 @@ hplugin_data_t* constraint_alloc(void)
     if (!retval)
         return NULL;
 
+    retval->oc_fd = -1;
+    retval->notify[0] = -1;
+    retval->notify[1] = -1;
     return retval;
 }
 
@@ -148,6 +340,16 @@ hplugin_data_t* constraint_alloc(void)
  */
 int constraint_init(hplugin_data_t* data, hspace_t* space)
 {
+    // Stop the Omega Calculator session of a previous search space.
+    // Points it has not tested yet stay held, and are tested against
+    // the new constraints below.
+    if (data->timer) {
+        search_timer_cancel(data->timer);
+        data->timer = 0;
+    }
+    if (stop_omega_calc(data) != 0)
+        return -1;
+
     // Make a copy of the search space.
     hspace_copy(&data->local_space, space);
 
@@ -164,36 +366,66 @@ int constraint_init(hplugin_data_t* data, hspace_t* space)
     if (build_user_text(data) != 0)
         return -1;
 
+    // Compile the constraints for direct evaluation, if possible.
+    data->native = (compile_native(data) == 0);
+    if (!data->native) {
+        if (!data->omega_bin) {
+            search_error("Could not find Omega Calculator executable, "
+                         "which is needed for these constraints. "
+                         "Use " CFGKEY_OC_BIN " to specify its location");
+            return -1;
+        }
+        if (!data->quiet)
+            fprintf(stderr, "Constraints are outside the linear subset. "
+                    " Using Omega Calculator for validity checks.\n");
+
+        if (batch_init(data) != 0)
+            return -1;
+    }
+
     // Calculate the range for each tuning variable, given the constraints.
-    if (update_bounds(data, space) != 0)
+    if (data->omega_bin && update_bounds(data, space) != 0)
         return -1;
 
-    return 0;
+    return retest_queue(data);
 }
 
-int constraint_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+/*
+ * Test generated points against the constraints.  Points that must be
+ * tested by the Omega Calculator are held until the end of the current
+ * round of generation, so they may be tested in a single batch.
+ */
+int constraint_generate(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
 {
-    flow->status = HFLOW_ACCEPT;
-    if (!check_validity(data, point)) {
-        flow->status = HFLOW_REJECT;
-        flow->point.id = -1;
-
-        if (!data->quiet) {
-            fprintf(stderr, "Rejecting point: {");
-            for (int i = 0; i < point->len; ++i) {
-                const hval_t* val = &point->term[i];
-
-                switch (data->local_space.dim[i].type) {
-                case HVAL_INT:  fprintf(stderr, "%ld", val->value.i); break;
-                case HVAL_REAL: fprintf(stderr, "%g", val->value.r); break;
-                case HVAL_STR:  fprintf(stderr, "%s", val->value.s); break;
-                default:        fprintf(stderr, "<INV>");
-                }
-                if (i < point->len - 1)
-                    fprintf(stderr, ", ");
+    if (!data->native) {
+        if (enqueue(data, &trial->point) != 0)
+            return -1;
+
+        if (!data->timer) {
+            data->timer = search_timer(0, data, flush_callback);
+            if (data->timer < 0) {
+                data->timer = 0;
+                return -1;
             }
-            fprintf(stderr, "}\n");
         }
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    flow->status = HFLOW_ACCEPT;
+    if (!check_native(data, &trial->point)) {
+        flow->status = HFLOW_REJECT;
+        flow->point.id = 0; // No hint, unless a repair is found.
+        if (data->repair != REPAIR_METHOD_NONE &&
+            repair_point(data, &trial->point, &flow->point) != 0)
+            return -1;
+
+        print_rejected(data, &trial->point);
+    }
+    else if (data->repair == REPAIR_METHOD_SAMPLE && !data->chain_ok) {
+        // Begin the random walk from the first valid point seen.
+        memcpy(data->chain, data->coord, data->width * sizeof(double));
+        data->chain_ok = 1;
     }
     return 0;
 }
@@ -203,7 +435,29 @@ int constraint_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
  */
 int constraint_fini(hplugin_data_t* data)
 {
+    stop_omega_calc(data);
+    if (data->notify[0] != -1) close(data->notify[0]);
+    if (data->notify[1] != -1) close(data->notify[1]);
+
+    for (int i = 0; i < data->queue_cap; ++i)
+        hpoint_fini(&data->queue[i].point);
+    free(data->queue);
+    free(data->oc_buf);
+    free(data->cmd);
+
     hspace_fini(&data->local_space);
+    free(data->prog);
+    free(data->rows);
+    free(data->stack);
+    free(data->coord);
+    free(data->start);
+    free(data->cost_t);
+    free(data->cost_f);
+    free(data->hs);
+    free(data->corr);
+    free(data->scale);
+    free(data->work);
+    free(data->chain);
     free(data);
     return 0;
 }
@@ -216,18 +470,29 @@ int strategy_cfg(hplugin_data_t* data, hspace_t* space)
 {
     const char* cfgval;
 
+    // The Omega Calculator is optional for linear constraints.
     data->omega_bin = hcfg_get(search_cfg, CFGKEY_OC_BIN);
-    if (!file_exists(data->omega_bin)) {
+    if (!file_exists(data->omega_bin))
         data->omega_bin = search_path(data->omega_bin);
-        if (!data->omega_bin) {
-            search_error("Could not find Omega Calculator executable. "
-                         "Use " CFGKEY_OC_BIN " to specify its location");
-            return -1;
-        }
-    }
 
     data->quiet = hcfg_bool(search_cfg, CFGKEY_OC_QUIET);
 
+    cfgval = hcfg_get(search_cfg, CFGKEY_OC_REPAIR);
+    if (strcmp(cfgval, "none") == 0) {
+        data->repair = REPAIR_METHOD_NONE;
+    }
+    else if (strcmp(cfgval, "project") == 0) {
+        data->repair = REPAIR_METHOD_PROJECT;
+    }
+    else if (strcmp(cfgval, "sample") == 0) {
+        data->repair = REPAIR_METHOD_SAMPLE;
+    }
+    else {
+        search_error("Invalid value for "
+                     CFGKEY_OC_REPAIR " configuration key");
+        return -1;
+    }
+
     cfgval = hcfg_get(search_cfg, CFGKEY_OC_CONSTRAINTS);
     if (cfgval) {
         if (strlen(cfgval) >= sizeof(data->constraints)) {
@@ -399,9 +664,11 @@ int update_bounds(hplugin_data_t* data, hspace_t* space)
                  range->name, data->vars_text,
                  data->bounds_text, data->user_text);
 
-        // Call omega calculator.
+        // Call omega calculator.  Symbolic declarations persist for
+        // the life of a calculator session, so each range query is
+        // given a fresh one.
         retstr = call_omega_calc(data, cmd);
-        if (!retstr)
+        if (!retstr || stop_omega_calc(data) != 0)
             return -1;
 
         // Parse the result.
@@ -475,107 +742,1371 @@ int update_bounds(hplugin_data_t* data, hspace_t* space)
     return 0;
 }
 
-int check_validity(hplugin_data_t* data, hpoint_t* point)
+void print_rejected(hplugin_data_t* data, const hpoint_t* point)
+{
+    if (data->quiet)
+        return;
+
+    fprintf(stderr, "Rejecting point: {");
+    for (int i = 0; i < point->len; ++i) {
+        const hval_t* val = &point->term[i];
+
+        switch (data->local_space.dim[i].type) {
+        case HVAL_INT:  fprintf(stderr, "%ld", val->value.i); break;
+        case HVAL_REAL: fprintf(stderr, "%g", val->value.r); break;
+        case HVAL_STR:  fprintf(stderr, "%s", val->value.s); break;
+        default:        fprintf(stderr, "<INV>");
+        }
+        if (i < point->len - 1)
+            fprintf(stderr, ", ");
+    }
+    fprintf(stderr, "}\n");
+}
+
+/*
+ * Send a command to the Omega Calculator, launching it if necessary.
+ *
+ * The calculator echoes each input line prefixed with ">>>".  Since
+ * the session remains open, the end of the reply is found by
+ * appending a uniquely named declaration to the command, and reading
+ * until its echo arrives.  The returned reply remains valid until the
+ * next call.
+ */
+char* call_omega_calc(hplugin_data_t* data, const char* cmd)
+{
+    char marker[64];
+    char* end;
+    int len = 0;
+
+    if (data->oc_fd == -1) {
+        char* child_argv[2];
+
+        child_argv[0] = (char*) data->omega_bin;
+        child_argv[1] = NULL;
+        data->oc_fd = socket_launch(data->omega_bin, child_argv,
+                                    &data->oc_pid);
+        if (data->oc_fd < 0) {
+            data->oc_fd = -1;
+            search_error("Could not launch Omega Calculator");
+            return NULL;
+        }
+    }
+
+    snprintf(marker, sizeof(marker), "symbolic harmony_sync%u;",
+             ++data->oc_sync);
+
+    if (socket_write(data->oc_fd, cmd, strlen(cmd)) < 0 ||
+        socket_write(data->oc_fd, "\n", 1) < 0 ||
+        socket_write(data->oc_fd, marker, strlen(marker)) < 0 ||
+        socket_write(data->oc_fd, "\n", 1) < 0)
+    {
+        search_error("Could not send command to Omega Calculator");
+        goto error;
+    }
+
+    while (1) {
+        if (len + 1 >= data->oc_buf_cap) {
+            if (array_grow(&data->oc_buf, &data->oc_buf_cap,
+                           sizeof(char)) != 0)
+            {
+                search_error("Internal error: Could not grow buffer for"
+                             " Omega Calculator input");
+                goto error;
+            }
+        }
+
+        int count = read(data->oc_fd, data->oc_buf + len,
+                         data->oc_buf_cap - len - 1);
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count < 0) {
+            search_error("Could not read output from Omega Calculator");
+            goto error;
+        }
+        if (count == 0) {
+            search_error("Omega Calculator exited unexpectedly");
+            goto error;
+        }
+        len += count;
+        data->oc_buf[len] = '\0';
+
+        // Truncate the reply at the echoed marker line.
+        end = strstr(data->oc_buf, marker);
+        if (end && strchr(end, '\n')) {
+            while (end > data->oc_buf && end[-1] != '\n')
+                --end;
+            *end = '\0';
+            return data->oc_buf;
+        }
+    }
+
+  error:
+    stop_omega_calc(data);
+    return NULL;
+}
+
+/*
+ * Close the Omega Calculator session, if one is open.
+ */
+int stop_omega_calc(hplugin_data_t* data)
 {
-    char cmd[MAX_CMD_LEN];
-    char* retstr;
     int retval = 0;
 
-    if (build_point_text(data, point) != 0)
-        return -1;
+    if (data->oc_fd == -1)
+        return 0;
+
+    if (close(data->oc_fd) != 0) {
+        search_error("Internal error: Could not close Omega socket");
+        retval = -1;
+    }
+    data->oc_fd = -1;
+
+    if (waitpid(data->oc_pid, NULL, 0) != data->oc_pid) {
+        search_error("Internal error: Could not reap Omega process");
+        retval = -1;
+    }
+    return retval;
+}
+
+/*
+ * Held points are released through a generate-side callback, which
+ * is triggered by writing one byte per tested point into a pipe.
+ */
+int batch_init(hplugin_data_t* data)
+{
+    if (data->notify[0] == -1) {
+        if (pipe(data->notify) != 0) {
+            search_error("Could not create constraint notification pipe");
+            return -1;
+        }
+
+        int flags = fcntl(data->notify[0], F_GETFL);
+        if (flags == -1 ||
+            fcntl(data->notify[0], F_SETFL, flags | O_NONBLOCK) != 0)
+        {
+            search_error("Could not configure constraint notification pipe");
+            return -1;
+        }
+
+        if (search_callback_generate(data->notify[0], data,
+                                     release_callback) != 0)
+        {
+            search_error("Could not register constraint callback");
+            return -1;
+        }
+    }
+    return 0;
+}
 
-    snprintf(cmd, sizeof(cmd),
-             "D:={[%s]: %s && %s && %s};\n"
-             "D;",
-             data->vars_text, data->bounds_text,
-             data->user_text, data->point_text);
+int enqueue(hplugin_data_t* data, const hpoint_t* point)
+{
+    if (data->queue_len == data->queue_cap) {
+        if (array_grow(&data->queue, &data->queue_cap,
+                       sizeof(*data->queue)) != 0)
+        {
+            search_error("Could not extend constraint queue");
+            return -1;
+        }
+    }
 
-    // Call omega test.
-    retstr = call_omega_calc(data, cmd);
-    if (!retstr)
+    pending_t* entry = &data->queue[data->queue_len];
+    if (hpoint_copy(&entry->point, point) != 0) {
+        search_error("Could not copy point into constraint queue");
         return -1;
+    }
+    entry->verdict = -1;
 
-    // Parse result.
-    while (*retstr) {
-        char c;
-        if (strncmp(">>>", retstr, 3) == 0)
-            goto nextline; // Skip echo lines.
+    ++data->queue_len;
+    return 0;
+}
 
-        retval = sscanf(retstr, " { %*s : FALSE %c ", &c);
+int find_queued(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->queue_len; ++i) {
+        if (data->queue[i].point.id == id)
+            return i;
+    }
+    return -1;
+}
 
-        if (retval == 1)
-            break;
+/*
+ * Test every untested point in the queue, and schedule the release of
+ * each.  If the points cannot be tested, they are rejected so that the
+ * search does not wait on them forever, and -1 is returned.
+ */
+int check_batch(hplugin_data_t* data)
+{
+    int untested = 0, retval = 0;
+
+    for (int i = 0; i < data->queue_len; ++i) {
+        if (data->queue[i].verdict < 0)
+            ++untested;
+    }
 
-      nextline:
-        retstr += strcspn(retstr, "\n");
-        if (*retstr)
-            ++retstr;
+    if (query_batch(data) != 0) {
+        for (int i = 0; i < data->queue_len; ++i) {
+            if (data->queue[i].verdict < 0)
+                data->queue[i].verdict = 0;
+        }
+        retval = -1;
     }
 
-    // If sscanf ever succeeded, retval will be 1 and the point is invalid.
-    return (retval != 1);
+    // Schedule the release of each tested point.
+    if (signal_release(data, untested) != 0)
+        return -1;
+
+    return retval;
 }
 
-char* call_omega_calc(hplugin_data_t* data, const char* cmd)
+/*
+ * Points held when the layer is re-initialized (e.g., by a search
+ * restart) remain in session-core's wait list.  Test each untested
+ * point against the new constraints, so it is still released.
+ */
+int retest_queue(hplugin_data_t* data)
 {
-    static char* buf = NULL;
-    static int buf_cap = 4096;
-    char* child_argv[2];
-    char* ptr;
-    pid_t oc_pid;
-    int fd, count;
+    int untested = 0;
 
-    if (buf == NULL) {
-        buf = malloc(sizeof(char) * buf_cap);
-        if (!buf)
-            return NULL;
+    for (int i = 0; i < data->queue_len; ++i) {
+        pending_t* entry = &data->queue[i];
+
+        if (entry->verdict < 0) {
+            if (data->native)
+                entry->verdict = check_native(data, &entry->point);
+            ++untested;
+        }
     }
 
-    child_argv[0] = (char*) data->omega_bin;
-    child_argv[1] = NULL;
-    fd = socket_launch(data->omega_bin, child_argv, &oc_pid);
-    if (!fd) {
-        search_error("Could not launch Omega Calculator");
-        return NULL;
+    if (!untested)
+        return 0;
+
+    if (data->native)
+        return signal_release(data, untested);
+
+    data->timer = search_timer(0, data, flush_callback);
+    if (data->timer < 0) {
+        data->timer = 0;
+        return -1;
     }
+    return 0;
+}
 
-    if (socket_write(fd, cmd, strlen(cmd)) < 0) {
-        search_error("Could not send command to Omega Calculator");
-        return NULL;
+/*
+ * Schedule the release of count held points whose verdict is known.
+ */
+int signal_release(hplugin_data_t* data, int count)
+{
+    char buf[64] = {0};
+
+    while (count > 0) {
+        int len = count < (int) sizeof(buf) ? count : (int) sizeof(buf);
+
+        if (write(data->notify[1], buf, len) != len) {
+            search_error("Could not signal constraint callback");
+            return -1;
+        }
+        count -= len;
     }
+    return 0;
+}
 
-    if (shutdown(fd, SHUT_WR) != 0) {
-        search_error("Internal error: Could not shutdown write to Omega");
-        return NULL;
+/*
+ * Query the calculator for every untested point in the queue.  Each
+ * round-trip is limited to roughly BATCH_SIZE bytes of input, so that
+ * neither side of the connection can fill its socket buffer while the
+ * other is blocked writing.
+ */
+int query_batch(hplugin_data_t* data)
+{
+    char query[4 * MAX_TEXT_LEN + 32]; // Four text fields, plus syntax.
+    int first = 0;
+
+    while (first < data->queue_len) {
+        int last = first, count = 0;
+
+        data->cmd_len = 0;
+        while (last < data->queue_len && data->cmd_len < BATCH_SIZE) {
+            pending_t* entry = &data->queue[last++];
+            if (entry->verdict >= 0)
+                continue;
+
+            if (build_point_text(data, &entry->point) != 0) {
+                search_error("Could not build Omega point text");
+                return -1;
+            }
+
+            snprintf(query, sizeof(query),
+                     "D:={[%s]: %s && %s && %s};\n"
+                     "D;\n",
+                     data->vars_text, data->bounds_text,
+                     data->user_text, data->point_text);
+
+            if (append_cmd(data, query) != 0)
+                return -1;
+            ++count;
+        }
+
+        if (count) {
+            char* reply = call_omega_calc(data, data->cmd);
+            if (!reply)
+                return -1;
+
+            if (parse_batch(data, reply, first, last) != count) {
+                search_error("Error parsing Omega Calculator output");
+                return -1;
+            }
+        }
+        first = last;
     }
+    return 0;
+}
 
-    ptr = buf;
-    while ( (count = socket_read(fd, ptr, buf_cap - (buf - ptr))) > 0) {
-        ptr += count;
-        if (ptr == buf + buf_cap) {
-            if (array_grow(&buf, &buf_cap, sizeof(char)) != 0) {
-                search_error("Internal error: Could not grow buffer for"
-                             " Omega Calculator input");
-                return NULL;
+/*
+ * Assign verdicts to the untested points within a range of the queue,
+ * in the order their queries were sent.  The echo of each "D;" query
+ * begins the reply for the next point.  Returns the number of replies
+ * found.
+ */
+int parse_batch(hplugin_data_t* data, const char* reply, int first, int last)
+{
+    pending_t* entry = NULL;
+    int count = 0;
+
+    while (*reply) {
+        char c;
+
+        if (strncmp(">>>", reply, 3) == 0) {
+            const char* echo = reply + 3;
+            while (*echo == ' ' || *echo == '\t')
+                ++echo;
+
+            if (strncmp(echo, "D;", 2) == 0) {
+                entry = NULL;
+                while (first < last) {
+                    pending_t* next = &data->queue[first++];
+                    if (next->verdict < 0) {
+                        entry = next;
+                        entry->verdict = 1;
+                        ++count;
+                        break;
+                    }
+                }
             }
-            ptr = buf + strlen(buf);
         }
-        *ptr = '\0';
+        else if (entry && sscanf(reply, " { %*s : FALSE %c ", &c) == 1) {
+            entry->verdict = 0;
+        }
+
+        reply += strcspn(reply, "\n");
+        if (*reply)
+            ++reply;
     }
-    if (count < 0) {
-        search_error("Could not read output from Omega Calculator");
-        return NULL;
+    return count;
+}
+
+int append_cmd(hplugin_data_t* data, const char* str)
+{
+    int len = strlen(str);
+
+    while (data->cmd_len + len + 1 > data->cmd_cap) {
+        if (array_grow(&data->cmd, &data->cmd_cap, sizeof(char)) != 0) {
+            search_error("Could not grow Omega command buffer");
+            return -1;
+        }
     }
+    memcpy(data->cmd + data->cmd_len, str, len + 1);
+    data->cmd_len += len;
+    return 0;
+}
 
-    if (close(fd) != 0) {
-        search_error("Internal error: Could not close Omega socket");
-        return NULL;
+/*
+ * Test all held points once the current round of generation ends.
+ * No point is released here; the release callback does so instead.
+ */
+int flush_callback(int fd, void* data_ptr,
+                   hflow_t* flow, int n, htrial_t** trial)
+{
+    hplugin_data_t* data = (hplugin_data_t*) data_ptr;
+
+    data->timer = 0;
+    if (check_batch(data) != 0) {
+        // Session-core does not report errors from callbacks, so
+        // announce that the held points are being rejected.
+        //
+        fprintf(stderr, "Could not test points against constraints.  "
+                "Rejecting held points.\n");
     }
+    return -1;
+}
 
-    if (waitpid(oc_pid, NULL, 0) != oc_pid) {
-        search_error("Internal error: Could not reap Omega process");
-        return NULL;
+/*
+ * Release a single held point whose verdict is known.
+ */
+int release_callback(int fd, void* data_ptr,
+                     hflow_t* flow, int n, htrial_t** trial)
+{
+    hplugin_data_t* data = (hplugin_data_t*) data_ptr;
+    char byte;
+
+    if (read(fd, &byte, sizeof(byte)) < 1)
+        return -1; // Spurious wakeup.
+
+    for (int i = 0; i < n; ++i) {
+        int idx = find_queued(data, trial[i]->point.id);
+        if (idx < 0 || data->queue[idx].verdict < 0)
+            continue;
+
+        if (!data->queue[idx].verdict) {
+            flow->status = HFLOW_REJECT;
+            flow->point.id = 0; // No hint.
+            print_rejected(data, &trial[i]->point);
+        }
+        else {
+            flow->status = HFLOW_ACCEPT;
+        }
+
+        // Remove the entry by swapping it with the last, parking its
+        // buffers past the end of the queue for reuse.
+        pending_t tmp = data->queue[idx];
+        --data->queue_len;
+        data->queue[idx] = data->queue[data->queue_len];
+        data->queue[data->queue_len] = tmp;
+        return i;
+    }
+
+    search_error("Could not find tested point in constraint waitlist");
+    return -1;
+}
+
+/*
+ * Compile the user constraint text into a postfix program of affine
+ * comparisons.  Returns -1 if the text falls outside the supported
+ * linear subset.
+ */
+int compile_native(hplugin_data_t* data)
+{
+    data->width = data->local_space.len + 1;
+    data->prog_len = 0;
+    data->rows_len = 0;
+
+    for (int i = 0; i < data->local_space.len; ++i) {
+        if (data->local_space.dim[i].type == HVAL_STR)
+            return -1;
+    }
+
+    data->cursor = data->user_text;
+    if (!match(data, "")) {
+        if (parse_or(data) != 0 || !match(data, ""))
+            return -1;
+    }
+
+    free(data->stack);
+    data->stack = malloc((data->prog_len + 1) * sizeof(*data->stack));
+    free(data->coord);
+    data->coord = malloc(data->width * sizeof(*data->coord));
+    if (!data->stack || !data->coord) {
+        search_error("Could not allocate constraint evaluator");
+        return -1;
+    }
+    return repair_init(data);
+}
+
+/*
+ * Evaluate the compiled constraints (and variable bounds) on a point.
+ */
+int check_native(hplugin_data_t* data, const hpoint_t* point)
+{
+    double* x = data->coord;
+    int top = 0;
+
+    x[0] = 1.0;
+    for (int i = 0; i < point->len; ++i) {
+        const hrange_t* range = &data->local_space.dim[i];
+
+        if (range->type == HVAL_INT) {
+            long val = point->term[i].value.i;
+            if (val < range->bounds.i.min || val > range->bounds.i.max)
+                return 0;
+            x[i + 1] = val;
+        }
+        else {
+            double val = point->term[i].value.r;
+            if (val < range->bounds.r.min || val > range->bounds.r.max)
+                return 0;
+            x[i + 1] = val;
+        }
     }
 
-    return buf;
+    for (int i = 0; i < data->prog_len; ++i) {
+        const instr_t* ins = &data->prog[i];
+
+        switch (ins->op) {
+        case OP_REL: {
+            const double* row = &data->rows[ins->row * data->width];
+            double val = 0.0;
+
+            for (int j = 0; j < data->width; ++j)
+                val += row[j] * x[j];
+
+            switch (ins->rel) {
+            case REL_LT: data->stack[top++] = (val <  0.0); break;
+            case REL_LE: data->stack[top++] = (val <= 0.0); break;
+            case REL_GT: data->stack[top++] = (val >  0.0); break;
+            case REL_GE: data->stack[top++] = (val >= 0.0); break;
+            case REL_EQ: data->stack[top++] = (val == 0.0); break;
+            case REL_NE: data->stack[top++] = (val != 0.0); break;
+            }
+            break;
+        }
+        case OP_AND:
+            --top;
+            data->stack[top - 1] = data->stack[top - 1] && data->stack[top];
+            break;
+
+        case OP_OR:
+            --top;
+            data->stack[top - 1] = data->stack[top - 1] || data->stack[top];
+            break;
+
+        case OP_NOT:
+            data->stack[top - 1] = !data->stack[top - 1];
+            break;
+        }
+    }
+    return top ? data->stack[0] : 1;
+}
+
+/*
+ * Recursive descent parser for the linear constraint subset.  Each
+ * function returns 0 on success, or -1 if the input cannot be
+ * handled.  Formulas are emitted in postfix order as they are parsed.
+ */
+int parse_or(hplugin_data_t* data)
+{
+    if (parse_and(data) != 0)
+        return -1;
+
+    while (match(data, "||") || match(data, "or")) {
+        if (parse_and(data) != 0 || emit(data, OP_OR, 0, 0) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+int parse_and(hplugin_data_t* data)
+{
+    if (parse_not(data) != 0)
+        return -1;
+
+    while (match(data, "&&") || match(data, "and")) {
+        if (parse_not(data) != 0 || emit(data, OP_AND, 0, 0) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+int parse_not(hplugin_data_t* data)
+{
+    const char* cursor = data->cursor;
+    int prog_len = data->prog_len;
+    int rows_len = data->rows_len;
+
+    if (!match(data, "!=") && (match(data, "!") || match(data, "not"))) {
+        if (parse_not(data) != 0)
+            return -1;
+        return emit(data, OP_NOT, 0, 0);
+    }
+    data->cursor = cursor;
+
+    // A parenthesis may group either a formula or an expression.
+    if (match(data, "(")) {
+        if (parse_or(data) == 0 && match(data, ")")) {
+            match(data, ""); // Skip white space.
+
+            const char* next = data->cursor;
+            relop_t rel;
+
+            if (!(*next && strchr("+-*", *next)) &&
+                parse_relop(data, &rel) != 0)
+            {
+                data->cursor = next;
+                return 0;
+            }
+        }
+        data->cursor = cursor;
+        data->prog_len = prog_len;
+        data->rows_len = rows_len;
+    }
+    return parse_chain(data);
+}
+
+/*
+ * Parse a chain of comparisons, such as `a <= b < c`, which is
+ * equivalent to the conjunction of each adjacent comparison.
+ */
+int parse_chain(hplugin_data_t* data)
+{
+    double* lhs = calloc(data->width, sizeof(*lhs));
+    double* rhs = calloc(data->width, sizeof(*rhs));
+    int count = 0, retval = -1;
+    relop_t rel;
+
+    if (!lhs || !rhs)
+        goto cleanup;
+
+    if (parse_sum(data, lhs) != 0)
+        goto cleanup;
+
+    while (parse_relop(data, &rel) == 0) {
+        if (parse_sum(data, rhs) != 0)
+            goto cleanup;
+
+        int row = add_row(data, lhs, rhs);
+        if (row < 0 || emit(data, OP_REL, rel, row) != 0)
+            goto cleanup;
+
+        if (count++ && emit(data, OP_AND, 0, 0) != 0)
+            goto cleanup;
+
+        double* tmp = lhs;
+        lhs = rhs;
+        rhs = tmp;
+    }
+    if (count)
+        retval = 0;
+
+  cleanup:
+    free(lhs);
+    free(rhs);
+    return retval;
+}
+
+int parse_relop(hplugin_data_t* data, relop_t* rel)
+{
+    if      (match(data, "<=")) *rel = REL_LE;
+    else if (match(data, ">=")) *rel = REL_GE;
+    else if (match(data, "!=")) *rel = REL_NE;
+    else if (match(data, "==")) *rel = REL_EQ;
+    else if (match(data, "<"))  *rel = REL_LT;
+    else if (match(data, ">"))  *rel = REL_GT;
+    else if (match(data, "="))  *rel = REL_EQ;
+    else return -1;
+    return 0;
+}
+
+int parse_sum(hplugin_data_t* data, double* vec)
+{
+    double* term = calloc(data->width, sizeof(*term));
+    int retval = -1;
+
+    if (!term)
+        return -1;
+
+    if (parse_product(data, vec) != 0)
+        goto cleanup;
+
+    while (1) {
+        double sign;
+
+        if      (match(data, "+")) sign =  1.0;
+        else if (match(data, "-")) sign = -1.0;
+        else break;
+
+        if (parse_product(data, term) != 0)
+            goto cleanup;
+
+        for (int i = 0; i < data->width; ++i)
+            vec[i] += sign * term[i];
+    }
+    retval = 0;
+
+  cleanup:
+    free(term);
+    return retval;
+}
+
+/*
+ * Parse a product of factors.  Juxtaposition (as in `2x`) implies
+ * multiplication.  At most one factor of a product may be
+ * non-constant.
+ */
+int parse_product(hplugin_data_t* data, double* vec)
+{
+    double* factor = calloc(data->width, sizeof(*factor));
+    int retval = -1;
+
+    if (!factor)
+        return -1;
+
+    if (parse_factor(data, vec) != 0)
+        goto cleanup;
+
+    while (1) {
+        if (!match(data, "*")) {
+            const char* next = data->cursor;
+            if (!(isalnum(*next) || *next == '_' || *next == '.' ||
+                  *next == '(') || at_keyword(data))
+                break;
+        }
+
+        if (parse_factor(data, factor) != 0)
+            goto cleanup;
+
+        int i, vec_const = 1, factor_const = 1;
+        for (i = 1; i < data->width; ++i) {
+            if (vec[i] != 0.0)    vec_const = 0;
+            if (factor[i] != 0.0) factor_const = 0;
+        }
+
+        if (factor_const) {
+            for (i = 0; i < data->width; ++i)
+                vec[i] *= factor[0];
+        }
+        else if (vec_const) {
+            for (i = 0; i < data->width; ++i)
+                factor[i] *= vec[0];
+            memcpy(vec, factor, data->width * sizeof(*vec));
+        }
+        else goto cleanup; // Non-linear term.
+    }
+    retval = 0;
+
+  cleanup:
+    free(factor);
+    return retval;
+}
+
+int parse_factor(hplugin_data_t* data, double* vec)
+{
+    const char* ptr;
+
+    memset(vec, 0, data->width * sizeof(*vec));
+    if (match(data, "-")) {
+        if (parse_factor(data, vec) != 0)
+            return -1;
+        for (int i = 0; i < data->width; ++i)
+            vec[i] = -vec[i];
+        return 0;
+    }
+    if (match(data, "+"))
+        return parse_factor(data, vec);
+
+    if (match(data, "(")) {
+        if (parse_sum(data, vec) != 0 || !match(data, ")"))
+            return -1;
+        return 0;
+    }
+
+    ptr = data->cursor;
+    if (isdigit(*ptr) || *ptr == '.') {
+        char* end;
+        vec[0] = strtod(ptr, &end);
+        if (end == ptr)
+            return -1;
+        data->cursor = end;
+        return 0;
+    }
+
+    if ((isalpha(*ptr) || *ptr == '_') && !at_keyword(data)) {
+        int len = 0;
+        while (isalnum(ptr[len]) || ptr[len] == '_')
+            ++len;
+
+        for (int i = 0; i < data->local_space.len; ++i) {
+            const char* name = data->local_space.dim[i].name;
+            if (strncmp(name, ptr, len) == 0 && name[len] == '\0') {
+                vec[i + 1] = 1.0;
+                data->cursor = ptr + len;
+                return 0;
+            }
+        }
+    }
+    return -1; // Unknown identifier or unsupported syntax.
+}
+
+/*
+ * Skip white space, then consume the given token if it is next.  An
+ * empty token matches only the end of input.  Word tokens must not be
+ * followed by further identifier characters.
+ */
+int match(hplugin_data_t* data, const char* token)
+{
+    const char* ptr = data->cursor;
+    size_t len = strlen(token);
+
+    while (isspace(*ptr))
+        ++ptr;
+    data->cursor = ptr;
+
+    if (len == 0)
+        return *ptr == '\0';
+
+    if (strncmp(ptr, token, len) != 0)
+        return 0;
+
+    if (isalpha(token[0]) && (isalnum(ptr[len]) || ptr[len] == '_'))
+        return 0;
+
+    data->cursor = ptr + len;
+    return 1;
+}
+
+int at_keyword(hplugin_data_t* data)
+{
+    const char* cursor = data->cursor;
+    int retval = (match(data, "and") || match(data, "or") ||
+                  match(data, "not"));
+    data->cursor = cursor;
+    return retval;
+}
+
+int emit(hplugin_data_t* data, opcode_t op, relop_t rel, int row)
+{
+    if (data->prog_len == data->prog_cap) {
+        if (array_grow(&data->prog, &data->prog_cap,
+                       sizeof(*data->prog)) != 0)
+        {
+            search_error("Could not grow constraint program");
+            return -1;
+        }
+    }
+    data->prog[data->prog_len].op = op;
+    data->prog[data->prog_len].rel = rel;
+    data->prog[data->prog_len].row = row;
+    ++data->prog_len;
+    return 0;
+}
+
+/*
+ * Store the difference of two affine expressions as a new row, and
+ * return its index.
+ */
+int add_row(hplugin_data_t* data, const double* lhs, const double* rhs)
+{
+    int needed = (data->rows_len + 1) * data->width;
+
+    while (data->rows_cap < needed) {
+        if (array_grow(&data->rows, &data->rows_cap,
+                       sizeof(*data->rows)) != 0)
+        {
+            search_error("Could not grow constraint rows");
+            return -1;
+        }
+    }
+
+    double* row = &data->rows[data->rows_len * data->width];
+    for (int i = 0; i < data->width; ++i)
+        row[i] = lhs[i] - rhs[i];
+
+    return data->rows_len++;
+}
+
+/*
+ * Prepare the buffers used to repair rejected points.  Each
+ * subformula of the compiled program ends at a known instruction.
+ * The start of each is recorded, so that the operands of any logical
+ * operation can be found: the right operand ends just before the
+ * operation, and the left operand ends just before the right one
+ * starts.
+ */
+int repair_init(hplugin_data_t* data)
+{
+    int len = data->prog_len ? data->prog_len : 1;
+
+    free(data->start);
+    free(data->cost_t);
+    free(data->cost_f);
+    free(data->hs);
+    free(data->corr);
+    free(data->scale);
+    free(data->work);
+    free(data->chain);
+
+    data->start  = malloc(len * sizeof(*data->start));
+    data->cost_t = malloc(len * sizeof(*data->cost_t));
+    data->cost_f = malloc(len * sizeof(*data->cost_f));
+    data->hs     = malloc(len * sizeof(*data->hs));
+    data->corr   = malloc((len + 2) * data->width * sizeof(*data->corr));
+    data->scale  = malloc(data->width * sizeof(*data->scale));
+    data->work   = malloc(data->width * sizeof(*data->work));
+    data->chain  = malloc(data->width * sizeof(*data->chain));
+    data->chain_ok = 0;
+
+    if (!data->start || !data->cost_t || !data->cost_f || !data->hs ||
+        !data->corr  || !data->scale  || !data->work   || !data->chain)
+    {
+        search_error("Could not allocate constraint repair buffers");
+        return -1;
+    }
+
+    for (int i = 0; i < data->prog_len; ++i) {
+        switch (data->prog[i].op) {
+        case OP_REL: data->start[i] = i; break;
+        case OP_NOT: data->start[i] = data->start[i - 1]; break;
+        case OP_AND:
+        case OP_OR:
+            data->start[i] = data->start[ data->start[i - 1] - 1 ];
+            break;
+        }
+    }
+
+    // Distances are measured with each variable scaled by its range.
+    data->scale[0] = 1.0;
+    for (int i = 0; i < data->local_space.len; ++i) {
+        const hrange_t* range = &data->local_space.dim[i];
+        double width;
+
+        if (range->type == HVAL_INT)
+            width = range->bounds.i.max - range->bounds.i.min;
+        else
+            width = range->bounds.r.max - range->bounds.r.min;
+
+        data->scale[i + 1] = (width > 0.0) ? width : 1.0;
+    }
+    return 0;
+}
+
+/*
+ * Find a valid replacement for a rejected point, according to the
+ * configured repair method.  If one is found, it is stored in the
+ * hint point.  Returns 0 whether or not a replacement is found, or -1
+ * on error.
+ */
+int repair_point(hplugin_data_t* data, const hpoint_t* point,
+                 hpoint_t* hint)
+{
+    double* x = data->work;
+
+    x[0] = 1.0;
+    for (int i = 0; i < point->len; ++i) {
+        if (data->local_space.dim[i].type == HVAL_INT)
+            x[i + 1] = point->term[i].value.i;
+        else
+            x[i + 1] = point->term[i].value.r;
+    }
+
+    if (data->repair == REPAIR_METHOD_SAMPLE && data->chain_ok) {
+        hit_and_run(data);
+        memcpy(x, data->chain, data->width * sizeof(*x));
+    }
+    else {
+        project(data, x);
+    }
+
+    // Move to the grid of values permitted by the search space.
+    for (int i = 0; i < data->local_space.len; ++i)
+        x[i + 1] = snap(&data->local_space.dim[i], x[i + 1]);
+
+    if (!grid_search(data, x))
+        return 0;
+
+    if (data->repair == REPAIR_METHOD_SAMPLE && !data->chain_ok) {
+        // Begin the random walk from the nearest valid point.
+        memcpy(data->chain, x, data->width * sizeof(*x));
+        data->chain_ok = 1;
+    }
+
+    if (hpoint_copy(hint, point) != 0) {
+        search_error("Could not copy point for constraint repair");
+        return -1;
+    }
+
+    for (int i = 0; i < hint->len; ++i) {
+        if (data->local_space.dim[i].type == HVAL_INT)
+            hint->term[i].value.i = (long) x[i + 1];
+        else
+            hint->term[i].value.r = x[i + 1];
+    }
+
+    // Guard against rounding differences with the direct evaluator.
+    if (!check_native(data, hint)) {
+        hint->id = 0;
+        return 0;
+    }
+    hint->id = point->id;
+    return 0;
+}
+
+/*
+ * Measure how far a point is from satisfying the constraints (zero
+ * if it does).  Along the way, the distance to satisfying and to
+ * violating each subformula is recorded.  Distances to a comparison
+ * are measured to its boundary, so a conjunction sums the distances
+ * of its operands, while a disjunction takes the smallest.
+ */
+double violation(hplugin_data_t* data, const double* x)
+{
+    if (!data->prog_len)
+        return 0.0;
+
+    for (int i = 0; i < data->prog_len; ++i) {
+        const instr_t* ins = &data->prog[i];
+        double* t = &data->cost_t[i];
+        double* f = &data->cost_f[i];
+
+        switch (ins->op) {
+        case OP_REL: {
+            const double* row = &data->rows[ins->row * data->width];
+            double val = row[0], norm = 0.0;
+
+            for (int j = 1; j < data->width; ++j) {
+                val  += row[j] * x[j];
+                norm += row[j] * row[j] * data->scale[j] * data->scale[j];
+            }
+
+            if (norm > 0.0) {
+                norm = sqrt(norm);
+            }
+            else {
+                // Constant comparison.  No point can change its value.
+                norm = 1.0;
+                if (val != 0.0) val = (val < 0.0) ? -HUGE_VAL : HUGE_VAL;
+            }
+
+            switch (ins->rel) {
+            case REL_LT:
+                *t = (val <  0.0) ? 0.0 :  val / norm + STRICT_EPS;
+                *f = (val >= 0.0) ? 0.0 : -val / norm;
+                break;
+            case REL_LE:
+                *t = (val <= 0.0) ? 0.0 :  val / norm;
+                *f = (val >  0.0) ? 0.0 : -val / norm + STRICT_EPS;
+                break;
+            case REL_GT:
+                *t = (val >  0.0) ? 0.0 : -val / norm + STRICT_EPS;
+                *f = (val <= 0.0) ? 0.0 :  val / norm;
+                break;
+            case REL_GE:
+                *t = (val >= 0.0) ? 0.0 : -val / norm;
+                *f = (val <  0.0) ? 0.0 :  val / norm + STRICT_EPS;
+                break;
+            case REL_EQ:
+                *t = fabs(val) / norm;
+                *f = (val != 0.0) ? 0.0 : STRICT_EPS;
+                break;
+            case REL_NE:
+                *t = (val != 0.0) ? 0.0 : STRICT_EPS;
+                *f = fabs(val) / norm;
+                break;
+            }
+            break;
+        }
+        case OP_NOT:
+            *t = data->cost_f[i - 1];
+            *f = data->cost_t[i - 1];
+            break;
+
+        case OP_AND: {
+            int r = i - 1, l = data->start[r] - 1;
+            *t = data->cost_t[l] + data->cost_t[r];
+            *f = fmin(data->cost_f[l], data->cost_f[r]);
+            break;
+        }
+        case OP_OR: {
+            int r = i - 1, l = data->start[r] - 1;
+            *t = fmin(data->cost_t[l], data->cost_t[r]);
+            *f = data->cost_f[l] + data->cost_f[r];
+            break;
+        }
+        }
+    }
+    return data->cost_t[data->prog_len - 1];
+}
+
+/*
+ * Collect the comparisons that must hold (or fail, if want is zero)
+ * for subformula i to be satisfied.  Where a choice exists, the
+ * operand closest to satisfaction is chosen, according to the costs
+ * from the last call to violation().
+ */
+void select_atoms(hplugin_data_t* data, int i, int want)
+{
+    const instr_t* ins = &data->prog[i];
+    int r = i - 1, l = (i > 0) ? data->start[r] - 1 : 0;
+
+    switch (ins->op) {
+    case OP_REL: {
+        halfspace_t* hs = &data->hs[data->hs_len];
+        relop_t rel = ins->rel;
+
+        if (!want) {
+            switch (rel) {
+            case REL_LT: rel = REL_GE; break;
+            case REL_LE: rel = REL_GT; break;
+            case REL_GT: rel = REL_LE; break;
+            case REL_GE: rel = REL_LT; break;
+            case REL_EQ: rel = REL_NE; break;
+            case REL_NE: rel = REL_EQ; break;
+            }
+        }
+
+        hs->row  = ins->row;
+        hs->eq   = (rel == REL_EQ);
+        hs->sign = (rel == REL_GT || rel == REL_GE) ? -1.0 : 1.0;
+        if (rel != REL_NE)
+            ++data->hs_len; // Inequality is left to the grid search.
+        break;
+    }
+    case OP_NOT:
+        select_atoms(data, r, !want);
+        break;
+
+    case OP_AND:
+        if (want) {
+            select_atoms(data, l, 1);
+            select_atoms(data, r, 1);
+        }
+        else if (data->cost_f[l] <= data->cost_f[r]) {
+            select_atoms(data, l, 0);
+        }
+        else {
+            select_atoms(data, r, 0);
+        }
+        break;
+
+    case OP_OR:
+        if (!want) {
+            select_atoms(data, l, 0);
+            select_atoms(data, r, 0);
+        }
+        else if (data->cost_t[l] <= data->cost_t[r]) {
+            select_atoms(data, l, 1);
+        }
+        else {
+            select_atoms(data, r, 1);
+        }
+        break;
+    }
+}
+
+/*
+ * Move a point to the nearest point (within the variable bounds) that
+ * satisfies the constraints.  Disjunctions are resolved by choosing
+ * the nearest operand, and the choice is revisited if the projection
+ * fails to satisfy the constraints.
+ */
+void project(hplugin_data_t* data, double* x)
+{
+    for (int i = 0; i < PROJECT_MAX; ++i) {
+        data->hs_len = 0;
+        if (data->prog_len) {
+            if (violation(data, x) == 0.0)
+                break;
+            select_atoms(data, data->prog_len - 1, 1);
+        }
+        dykstra(data, x);
+    }
+}
+
+/*
+ * Dykstra's alternating projection algorithm, which converges to the
+ * projection of a point onto the intersection of the selected
+ * half-spaces and the variable bounds.
+ */
+void dykstra(hplugin_data_t* data, double* x)
+{
+    int     width = data->width;
+    double* s     = data->scale;
+    double* prev  = &data->corr[(data->hs_len + 1) * width];
+
+    memset(data->corr, 0, (data->hs_len + 1) * width * sizeof(double));
+
+    for (int sweep = 0; sweep < SWEEP_MAX; ++sweep) {
+        double delta = 0.0;
+
+        memcpy(prev, x, width * sizeof(*x));
+        for (int k = 0; k <= data->hs_len; ++k) {
+            double* p = &data->corr[k * width];
+
+            // Project x + p onto set k, and keep the difference as
+            // the next correction for set k.
+            for (int j = 1; j < width; ++j) {
+                x[j] += p[j];
+                p[j]  = x[j];
+            }
+
+            if (k < data->hs_len) {
+                const halfspace_t* hs = &data->hs[k];
+                const double* row = &data->rows[hs->row * width];
+                double val = hs->sign * row[0], norm = 0.0;
+
+                for (int j = 1; j < width; ++j) {
+                    val  += hs->sign * row[j] * x[j];
+                    norm += row[j] * row[j] * s[j] * s[j];
+                }
+
+                if ((val > 0.0 || hs->eq) && norm > 0.0) {
+                    for (int j = 1; j < width; ++j)
+                        x[j] -= val / norm * s[j] * s[j] * hs->sign * row[j];
+                }
+            }
+            else {
+                for (int j = 1; j < width; ++j) {
+                    const hrange_t* range = &data->local_space.dim[j - 1];
+                    double lo, hi;
+
+                    if (range->type == HVAL_INT) {
+                        lo = range->bounds.i.min;
+                        hi = range->bounds.i.max;
+                    }
+                    else {
+                        lo = range->bounds.r.min;
+                        hi = range->bounds.r.max;
+                    }
+                    if (x[j] < lo) x[j] = lo;
+                    if (x[j] > hi) x[j] = hi;
+                }
+            }
+
+            for (int j = 1; j < width; ++j)
+                p[j] -= x[j];
+        }
+
+        for (int j = 1; j < width; ++j)
+            delta = fmax(delta, fabs(x[j] - prev[j]) / s[j]);
+
+        if (delta < 1e-12)
+            break;
+    }
+}
+
+/*
+ * Advance the hit-and-run random walk by one step per variable.  Each
+ * step picks a random direction through the current point, and moves
+ * to a valid point chosen uniformly along that line.  Candidates are
+ * drawn from a shrinking interval, which always contains the current
+ * point.
+ */
+void hit_and_run(hplugin_data_t* data)
+{
+    double* x0 = data->chain;
+    double* x  = data->work;
+    double* d  = data->corr; // Unused outside of projection.
+
+    for (int step = 0; step < data->local_space.len; ++step) {
+        double lo = -HUGE_VAL, hi = HUGE_VAL;
+
+        for (int j = 1; j < data->width; ++j) {
+            const hrange_t* range = &data->local_space.dim[j - 1];
+            double u1 = 1.0 - search_drand48();
+            double u2 = search_drand48();
+            double min, max;
+
+            d[j] = sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2) * data->scale[j];
+            if (d[j] == 0.0)
+                continue;
+
+            if (range->type == HVAL_INT) {
+                min = range->bounds.i.min;
+                max = range->bounds.i.max;
+            }
+            else {
+                min = range->bounds.r.min;
+                max = range->bounds.r.max;
+            }
+
+            double t1 = (min - x0[j]) / d[j];
+            double t2 = (max - x0[j]) / d[j];
+            lo = fmax(lo, fmin(t1, t2));
+            hi = fmin(hi, fmax(t1, t2));
+        }
+        if (!(lo <= 0.0 && 0.0 <= hi))
+            continue;
+
+        x[0] = 1.0;
+        for (int k = 0; k < SHRINK_MAX; ++k) {
+            double t = lo + (hi - lo) * search_drand48();
+
+            for (int j = 1; j < data->width; ++j)
+                x[j] = x0[j] + t * d[j];
+
+            if (violation(data, x) == 0.0) {
+                memcpy(x0, x, data->width * sizeof(*x));
+                break;
+            }
+            if (t < 0.0) lo = t;
+            else         hi = t;
+        }
+    }
+}
+
+/*
+ * Return the permitted value nearest to val.
+ */
+double snap(const hrange_t* range, double val)
+{
+    hval_t hval = HVAL_INITIALIZER;
+
+    if (range->type == HVAL_INT) {
+        hval.value.i = lround(val);
+        return hrange_value(range, hrange_index(range, &hval)).value.i;
+    }
+
+    if (val < range->bounds.r.min) return range->bounds.r.min;
+    if (val > range->bounds.r.max) return range->bounds.r.max;
+    if (range->bounds.r.step > 0.0) {
+        hval.value.r = val;
+        return hrange_value(range, hrange_index(range, &hval)).value.r;
+    }
+    return val;
+}
+
+/*
+ * Distance between adjacent permitted values.  Continuous ranges use
+ * a small fraction of their width.
+ */
+double grid_step(const hrange_t* range)
+{
+    if (range->type == HVAL_INT)
+        return range->bounds.i.step;
+
+    if (range->bounds.r.step > 0.0)
+        return range->bounds.r.step;
+
+    return (range->bounds.r.max - range->bounds.r.min) * 1e-6;
+}
+
+/*
+ * Greedily move a point across the grid of permitted values, one
+ * variable and one step at a time, until the constraints are
+ * satisfied.  Returns non-zero if successful.
+ */
+int grid_search(hplugin_data_t* data, double* x)
+{
+    double curr = violation(data, x);
+
+    for (int iter = 0; curr > 0.0 && iter < SEARCH_MAX; ++iter) {
+        double best = curr;
+        int best_j = 0;
+        double best_val = 0.0;
+
+        for (int j = 1; j < data->width; ++j) {
+            const hrange_t* range = &data->local_space.dim[j - 1];
+            double step = grid_step(range);
+            double orig = x[j];
+
+            for (int dir = -1; dir <= 1; dir += 2) {
+                double val = snap(range, orig + dir * step);
+                if (val == orig)
+                    continue;
+
+                x[j] = val;
+                double cost = violation(data, x);
+                if (cost < best) {
+                    best = cost;
+                    best_j = j;
+                    best_val = val;
+                }
+            }
+            x[j] = orig;
+        }
+
+        if (!best_j)
+            return 0; // Local minimum.
+
+        x[best_j] = best_val;
+        curr = best;
+    }
+    return curr == 0.0;
 }
@@ -16,12 +16,24 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
  */
+#define _XOPEN_SOURCE 600 // Needed for clock_gettime().
 
 /**
  * \page logger Point Logger (log.so)
  *
  * This processing layer writes a log of point/performance pairs to disk as
  * they flow through the auto-tuning [feedback loop](\ref intro_feedback).
+ *
+ * Two log formats are available.  The text format is written
+ * directly as each point is analyzed.  The binary format stores each
+ * point/performance pair as a fixed-width record with one column per
+ * search space dimension and performance objective.  Binary records
+ * are buffered and committed to disk in groups by a background
+ * thread, keeping file I/O out of the search loop.  Binary logs may
+ * be converted to the text format with the
+ * [hlogcat](\ref app_hlogcat) utility.
+ *
+ * Client join messages are only recorded in text format logs.
  */
 
 #include "hlayer.h"
@@ -30,13 +42,26 @@
 #include "hpoint.h"
 #include "hperf.h"
 #include "hcfg.h"
+#include "hlog.h"
 #include "hutil.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+/*
+ * Binary log records are committed to disk once this many bytes have
+ * been buffered, or when the oldest buffered record has waited for
+ * COMMIT_INTERVAL milliseconds.
+ */
+#define COMMIT_SIZE     (64 * 1024)
+#define COMMIT_INTERVAL 100
 
 /*
  * Name used to identify this plugin layer.
@@ -51,12 +76,25 @@ const char hplugin_name[] = "logger";
 const hcfg_info_t hplugin_keyinfo[] = {
     { CFGKEY_LOG_FILE, NULL,
       "Name of point/performance log file." },
+    { CFGKEY_LOG_FORMAT, "text",
+      "Format of the log file.  Valid values are text and binary.  "
+      "Binary logs can be converted to text with the hlogcat "
+      "utility." },
     { CFGKEY_LOG_MODE, "a",
       "Mode to use with 'fopen()'.  Valid values are a for append, "
       "and w for overwrite." },
     { NULL }
 };
 
+/*
+ * Buffer of binary log records awaiting commit.
+ */
+typedef struct logbuf {
+    char*  buf;
+    size_t len;
+    size_t cap;
+} logbuf_t;
+
 /*
  * Structure to hold all data needed by an individual search instance.
  *
@@ -67,8 +105,41 @@ const hcfg_info_t hplugin_keyinfo[] = {
 struct hplugin_data {
     char* filename;
     FILE* fd;
+
+    // Binary log format state.
+    int             binary;
+    int             bin_fd;
+    hspace_t        space;
+    int             obj_count;
+    int             cols;
+    hlog_col_t*     record;
+
+    pthread_t       writer;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    logbuf_t        active;
+    logbuf_t        spare;
+    int             running;
+    int             stop;
+    int             werrno;
 };
 
+/*
+ * Internal helper function prototypes.
+ */
+static int   text_open(hplugin_data_t* data, const char* mode);
+static int   text_close(hplugin_data_t* data);
+static int   binary_open(hplugin_data_t* data, const char* mode);
+static int   binary_close(hplugin_data_t* data);
+static int   binary_header(hplugin_data_t* data, const hspace_t* space,
+                           int obj_count);
+static int   binary_event(hplugin_data_t* data, hlog_event_t event);
+static int   binary_append(hplugin_data_t* data, const hlog_col_t* cols);
+static int   writer_start(hplugin_data_t* data);
+static int   writer_stop(hplugin_data_t* data);
+static void* writer_main(void* arg);
+static int   write_all(int fd, const char* buf, size_t len);
+
 /*
  * Allocate memory for a new search task.
  */
@@ -78,6 +149,16 @@ hplugin_data_t* logger_alloc(void)
     if (!retval)
         return NULL;
 
+    retval->bin_fd = -1;
+    if (pthread_mutex_init(&retval->lock, NULL) != 0) {
+        free(retval);
+        return NULL;
+    }
+    if (pthread_cond_init(&retval->wake, NULL) != 0) {
+        pthread_mutex_destroy(&retval->lock);
+        free(retval);
+        return NULL;
+    }
     return retval;
 }
 
@@ -87,15 +168,32 @@ hplugin_data_t* logger_alloc(void)
 int logger_init(hplugin_data_t* data, hspace_t* space)
 {
     const char* filename = hcfg_get(search_cfg, CFGKEY_LOG_FILE);
+    const char* format   = hcfg_get(search_cfg, CFGKEY_LOG_FORMAT);
     const char* mode     = hcfg_get(search_cfg, CFGKEY_LOG_MODE);
+    int obj_count        = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
     time_t tm = time(NULL);
+    int binary;
 
     if (!filename) {
         search_error(CFGKEY_LOG_FILE " config key empty");
         return -1;
     }
 
-    if (!data->filename || strcmp(data->filename, filename) != 0) {
+    if (!format || strcasecmp(format, "text") == 0) {
+        binary = 0;
+    }
+    else if (strcasecmp(format, "binary") == 0) {
+        binary = 1;
+    }
+    else {
+        search_error("Invalid value for " CFGKEY_LOG_FORMAT
+                     " configuration key");
+        return -1;
+    }
+
+    if (!data->filename || strcmp(data->filename, filename) != 0 ||
+        data->binary != binary)
+    {
         // Save a copy of the filename..
         free(data->filename);
         data->filename = stralloc(filename);
@@ -104,34 +202,99 @@ int logger_init(hplugin_data_t* data, hspace_t* space)
             return -1;
         }
 
-        if (!data->fd)
-            data->fd = fopen(filename, mode);
-        else
-            data->fd = freopen(filename, mode, data->fd);
-
-        if (!data->fd) {
-            search_error( strerror(errno) );
+        if (binary_close(data) != 0)
             return -1;
+
+        data->binary = binary;
+        if (!data->binary) {
+            if (text_open(data, mode) != 0)
+                return -1;
+
+            fprintf(data->fd, "* Begin tuning session log.\n");
+            fprintf(data->fd, "* Timestamp: %s", asctime( localtime(&tm) ));
+        }
+        else {
+            if (text_close(data) != 0)
+                return -1;
+
+            if (binary_open(data, mode) != 0)
+                return -1;
+
+            if (binary_header(data, space, obj_count) != 0 ||
+                binary_event(data, HLOG_EVENT_BEGIN) != 0)
+                return -1;
         }
-        fprintf(data->fd, "* Begin tuning session log.\n");
-        fprintf(data->fd, "* Timestamp: %s", asctime( localtime(&tm) ));
     }
-    else {
+    else if (!data->binary) {
         fprintf(data->fd, "* Logger re-initialized.\n");
         fprintf(data->fd, "* Timestamp: %s", asctime( localtime(&tm) ));
     }
+    else {
+        // Commit pending records before the record layout may change.
+        if (writer_stop(data) != 0)
+            return -1;
+
+        if (!hspace_equal(&data->space, space) ||
+            data->obj_count != obj_count)
+        {
+            if (binary_header(data, space, obj_count) != 0)
+                return -1;
+        }
+        if (binary_event(data, HLOG_EVENT_REINIT) != 0)
+            return -1;
+    }
+
+    if (data->binary && writer_start(data) != 0)
+        return -1;
 
     return 0;
 }
 
 int logger_join(hplugin_data_t* data, const char* client)
 {
-    fprintf(data->fd, "Client \"%s\" joined the tuning session.\n", client);
+    if (!data->binary)
+        fprintf(data->fd, "Client \"%s\" joined the tuning session.\n",
+                client);
     return 0;
 }
 
 int logger_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
 {
+    if (data->binary) {
+        const hpoint_t* point = &trial->point;
+        hlog_col_t* col = data->record;
+
+        if (point->len != data->space.len ||
+            trial->perf.len != data->obj_count)
+        {
+            search_error("Trial does not match binary log layout");
+            return -1;
+        }
+
+        (col++)->i = point->id;
+        for (int i = 0; i < point->len; ++i) {
+            const hval_t* v = &point->term[i];
+            switch (v->type) {
+            case HVAL_INT:  (col++)->i = v->value.i; break;
+            case HVAL_REAL: (col++)->r = v->value.r; break;
+            case HVAL_STR:
+                (col++)->u = hrange_index(&data->space.dim[i], v);
+                break;
+            default:
+                search_error("Invalid point value type");
+                return -1;
+            }
+        }
+        for (int i = 0; i < trial->perf.len; ++i)
+            (col++)->r = trial->perf.obj[i];
+
+        if (binary_append(data, data->record) != 0)
+            return -1;
+
+        flow->status = HFLOW_ACCEPT;
+        return 0;
+    }
+
     fprintf(data->fd, "Point #%d: (", trial->point.id);
     for (int i = 0; i < trial->point.len; ++i) {
         if (i > 0) fprintf(data->fd, ",");
@@ -169,19 +332,346 @@ int logger_analyze(hplugin_data_t* data, hflow_t* flow, htrial_t* trial)
  */
 int logger_fini(hplugin_data_t* data)
 {
-    time_t tm = time(NULL);
+    int retval = 0;
 
-    fprintf(data->fd, "*\n");
-    fprintf(data->fd, "* End tuning session.\n");
-    fprintf(data->fd, "* Timestamp: %s", asctime( localtime(&tm) ));
-    fprintf(data->fd, "*\n");
+    if (data->fd) {
+        time_t tm = time(NULL);
 
-    if (fclose(data->fd) != 0) {
-        search_error( strerror(errno) );
-        return -1;
+        fprintf(data->fd, "*\n");
+        fprintf(data->fd, "* End tuning session.\n");
+        fprintf(data->fd, "* Timestamp: %s", asctime( localtime(&tm) ));
+        fprintf(data->fd, "*\n");
+
+        if (text_close(data) != 0)
+            retval = -1;
+    }
+
+    if (data->bin_fd != -1) {
+        if (writer_stop(data) != 0 ||
+            binary_event(data, HLOG_EVENT_END) != 0)
+            retval = -1;
+
+        if (binary_close(data) != 0)
+            retval = -1;
     }
 
+    pthread_cond_destroy(&data->wake);
+    pthread_mutex_destroy(&data->lock);
+    free(data->active.buf);
+    free(data->spare.buf);
+    free(data->record);
+    hspace_fini(&data->space);
     free(data->filename);
     free(data);
+    return retval;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+int text_open(hplugin_data_t* data, const char* mode)
+{
+    if (!data->fd)
+        data->fd = fopen(data->filename, mode);
+    else
+        data->fd = freopen(data->filename, mode, data->fd);
+
+    if (!data->fd) {
+        search_error( strerror(errno) );
+        return -1;
+    }
+    return 0;
+}
+
+int text_close(hplugin_data_t* data)
+{
+    if (data->fd) {
+        int retval = fclose(data->fd);
+
+        data->fd = NULL;
+        if (retval != 0) {
+            search_error( strerror(errno) );
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Open a binary log file.  Appending to an existing log simply adds a
+ * new header, since readers recognize headers between records.
+ */
+int binary_open(hplugin_data_t* data, const char* mode)
+{
+    int flags = O_WRONLY | O_CREAT;
+
+    if (mode && mode[0] == 'w') {
+        flags |= O_TRUNC;
+    }
+    else if (!mode || mode[0] == 'a') {
+        flags |= O_APPEND;
+    }
+    else {
+        search_error("Invalid value for " CFGKEY_LOG_MODE
+                     " configuration key");
+        return -1;
+    }
+
+    data->bin_fd = open(data->filename, flags, 0666);
+    if (data->bin_fd == -1) {
+        search_error( strerror(errno) );
+        return -1;
+    }
+    return 0;
+}
+
+int binary_close(hplugin_data_t* data)
+{
+    int retval = 0;
+
+    if (data->bin_fd != -1) {
+        if (writer_stop(data) != 0)
+            retval = -1;
+
+        if (close(data->bin_fd) != 0 && retval == 0) {
+            search_error( strerror(errno) );
+            retval = -1;
+        }
+        data->bin_fd = -1;
+    }
+    return retval;
+}
+
+/*
+ * Write a header describing the record layout for the given search
+ * space.  The writer thread must not be running.
+ */
+int binary_header(hplugin_data_t* data, const hspace_t* space,
+                  int obj_count)
+{
+    hlog_header_t head;
+    char* buf = NULL;
+    char* ptr;
+    int buflen, count;
+
+    // Event records need two columns after the point ID.
+    if (space->len + obj_count < 2) {
+        search_error("Search space too small for binary log");
+        return -1;
+    }
+
+    if (hspace_copy(&data->space, space) != 0) {
+        search_error("Could not copy search space for binary log");
+        return -1;
+    }
+    data->obj_count = obj_count;
+
+    data->cols = 1 + space->len + obj_count;
+    free(data->record);
+    data->record = calloc(data->cols, sizeof(*data->record));
+    if (!data->record) {
+        search_error("Could not allocate binary log record");
+        return -1;
+    }
+
+    // Serialize the search space, including its terminating NUL.
+    ptr = NULL;
+    buflen = 0;
+    count = hspace_pack(&ptr, &buflen, space);
+    if (count < 0)
+        goto error;
+
+    buf = malloc(count + 1);
+    if (!buf)
+        goto error;
+
+    ptr = buf;
+    buflen = count + 1;
+    if (hspace_pack(&ptr, &buflen, space) != count)
+        goto error;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, HLOG_MAGIC, sizeof(head.magic));
+    head.dim_count = space->len;
+    head.obj_count = obj_count;
+    head.space_len = count + 1;
+
+    if (write_all(data->bin_fd, (char*) &head, sizeof(head)) != 0 ||
+        write_all(data->bin_fd, buf, count + 1) != 0)
+    {
+        search_error( strerror(errno) );
+        free(buf);
+        return -1;
+    }
+
+    free(buf);
+    return 0;
+
+  error:
+    search_error("Could not serialize search space for binary log");
+    free(buf);
+    return -1;
+}
+
+int binary_event(hplugin_data_t* data, hlog_event_t event)
+{
+    memset(data->record, 0, data->cols * sizeof(*data->record));
+    data->record[0].i = 0;
+    data->record[1].i = event;
+    data->record[2].i = time(NULL);
+
+    if (data->running)
+        return binary_append(data, data->record);
+
+    if (write_all(data->bin_fd, (char*) data->record,
+                  data->cols * sizeof(*data->record)) != 0)
+    {
+        search_error( strerror(errno) );
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Queue a single record for the writer thread.
+ */
+int binary_append(hplugin_data_t* data, const hlog_col_t* cols)
+{
+    size_t size = data->cols * sizeof(*cols);
+    logbuf_t* active = &data->active;
+    int retval = 0;
+
+    pthread_mutex_lock(&data->lock);
+    if (data->werrno) {
+        search_error( strerror(data->werrno) );
+        retval = -1;
+        goto done;
+    }
+
+    if (active->len + size > active->cap) {
+        size_t newcap = active->cap ? active->cap : COMMIT_SIZE;
+        while (newcap < active->len + size)
+            newcap <<= 1;
+
+        char* newbuf = realloc(active->buf, newcap);
+        if (!newbuf) {
+            search_error("Could not grow binary log buffer");
+            retval = -1;
+            goto done;
+        }
+        active->buf = newbuf;
+        active->cap = newcap;
+    }
+    memcpy(active->buf + active->len, cols, size);
+    active->len += size;
+
+    // Wake the writer for the first record, which starts the commit
+    // interval, and once the buffer is full.
+    if (active->len == size || active->len >= COMMIT_SIZE)
+        pthread_cond_signal(&data->wake);
+
+  done:
+    pthread_mutex_unlock(&data->lock);
+    return retval;
+}
+
+int writer_start(hplugin_data_t* data)
+{
+    data->stop = 0;
+    data->werrno = 0;
+    if (pthread_create(&data->writer, NULL, writer_main, data) != 0) {
+        search_error("Could not launch binary log writer thread");
+        return -1;
+    }
+    data->running = 1;
+    return 0;
+}
+
+/*
+ * Commit all pending records, and wait for the writer thread to exit.
+ */
+int writer_stop(hplugin_data_t* data)
+{
+    if (!data->running)
+        return 0;
+
+    pthread_mutex_lock(&data->lock);
+    data->stop = 1;
+    pthread_cond_signal(&data->wake);
+    pthread_mutex_unlock(&data->lock);
+
+    pthread_join(data->writer, NULL);
+    data->running = 0;
+
+    if (data->werrno) {
+        search_error( strerror(data->werrno) );
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Writer thread main loop.  The thread sleeps until a record arrives.
+ * Records are then committed once enough have accumulated, or once
+ * the commit interval expires.  Buffers are swapped under the lock,
+ * so the search thread never waits on I/O.
+ */
+void* writer_main(void* arg)
+{
+    hplugin_data_t* data = (hplugin_data_t*) arg;
+    struct timespec deadline;
+    int done = 0;
+
+    pthread_mutex_lock(&data->lock);
+    while (!done) {
+        while (!data->stop && data->active.len == 0)
+            pthread_cond_wait(&data->wake, &data->lock);
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += COMMIT_INTERVAL * 1000000L;
+        deadline.tv_sec  += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+
+        while (!data->stop && data->active.len < COMMIT_SIZE) {
+            if (pthread_cond_timedwait(&data->wake, &data->lock,
+                                       &deadline) == ETIMEDOUT)
+                break;
+        }
+        done = data->stop;
+
+        if (data->active.len == 0)
+            continue;
+
+        logbuf_t tmp = data->active;
+        data->active = data->spare;
+        data->active.len = 0;
+        data->spare = tmp;
+        pthread_mutex_unlock(&data->lock);
+
+        int err = 0;
+        if (write_all(data->bin_fd, data->spare.buf, data->spare.len) != 0)
+            err = errno;
+
+        pthread_mutex_lock(&data->lock);
+        if (err && !data->werrno)
+            data->werrno = err;
+    }
+    pthread_mutex_unlock(&data->lock);
+
+    return NULL;
+}
+
+int write_all(int fd, const char* buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t count = write(fd, buf, len);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += count;
+        len -= count;
+    }
     return 0;
 }
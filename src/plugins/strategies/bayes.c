@@ -0,0 +1,1288 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _XOPEN_SOURCE 500 // Needed for M_PI and M_SQRT1_2.
+
+/**
+ * \page bayes Bayesian Optimization (bayes.so)
+ *
+ * This search strategy fits a Gaussian process surrogate model to
+ * every performance observed so far, and proposes the point which
+ * maximizes an acquisition function over that model.  It is best
+ * suited to searches where each evaluation is expensive, and the
+ * total number of evaluations is measured in the hundreds or low
+ * thousands.  This search will never reach a converged state.
+ *
+ * The model is seeded with BAYES_INIT points drawn from a scrambled
+ * Sobol sequence (see SAMPLE_METHOD), which covers the search space
+ * more evenly than independent random points.
+ *
+ * Each tuning variable is mapped onto the unit interval before it is
+ * modeled.  Integer and stepped real variables are mapped by their
+ * index, so proposals always fall on a valid value.  Enumerated
+ * variables have no natural order, and are instead one-hot encoded
+ * so that any two distinct values are equally far apart.  The model
+ * uses a Matern 5/2 kernel whose length scale and noise level are
+ * chosen by maximum likelihood each time the number of observations
+ * doubles.
+ *
+ * Points still under evaluation are included in the model with a
+ * fabricated "constant liar" performance (see BAYES_LIAR), which
+ * steers concurrent clients toward distinct points.  The fabricated
+ * value is replaced as soon as the true performance arrives.
+ *
+ * The Cholesky factor of the kernel matrix is extended by one row per
+ * proposal, rather than recomputed, so proposals cost O(n^2) for a
+ * history of n points.  Candidate points are first ranked by an upper
+ * bound of the acquisition function which only needs the model mean,
+ * and the more expensive model variance is computed only for the
+ * candidates which could still beat the best candidate found so far.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+#include "libsample.h"
+
+#include <stdlib.h>
+#include <string.h> // For strcmp() and memmove().
+#include <math.h>   // For erfc(), exp(), isnan(), and sqrt().
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_BAYES_INIT, "0",
+      "Number of random points to evaluate before the surrogate model "
+      "is consulted.  A value of 0 selects twice the number of search "
+      "space dimensions (or 4, whichever is larger)." },
+    { CFGKEY_BAYES_ACQUISITION, "ei",
+      "Acquisition function used to choose among candidate points. "
+      "    ei: Expected improvement over the best observed "
+      "performance. "
+      "    lcb: Lower confidence bound, or the predicted performance "
+      "less " CFGKEY_BAYES_KAPPA " standard deviations." },
+    { CFGKEY_BAYES_KAPPA, "2.0",
+      "Exploration weight of the lcb acquisition function.  Larger "
+      "values favor points the model knows little about." },
+    { CFGKEY_BAYES_LIAR, "mean",
+      "Performance assumed for points still under evaluation. "
+      "    best: The best observed performance. "
+      "    mean: The mean observed performance. "
+      "    worst: The worst observed performance.  This spreads "
+      "concurrent proposals furthest apart." },
+    { CFGKEY_BAYES_SAMPLES, "512",
+      "Number of candidate points scored by the acquisition function "
+      "for each proposal." },
+    { CFGKEY_SAMPLE_METHOD, NULL,
+      "Method used to generate the initial points.  Valid values are "
+      "uniform, sobol (default), and lhs." },
+    { NULL }
+};
+
+typedef enum acquisition {
+    ACQUISITION_UNKNOWN = 0,
+    ACQUISITION_EI,
+    ACQUISITION_LCB,
+
+    ACQUISITION_MAX
+} acquisition_t;
+
+typedef enum liar {
+    LIAR_UNKNOWN = 0,
+    LIAR_BEST,
+    LIAR_MEAN,
+    LIAR_WORST,
+
+    LIAR_MAX
+} liar_t;
+
+typedef enum sample_state {
+    SAMPLE_PENDING = 0,
+    SAMPLE_OBSERVED,
+    SAMPLE_REJECTED,
+
+    SAMPLE_MAX
+} sample_state_t;
+
+/*
+ * A point included in the surrogate model.
+ */
+typedef struct sample {
+    unsigned       id;
+    sample_state_t state;
+    double         perf;
+} sample_t;
+
+typedef struct scored {
+    double score;
+    int    idx;
+} scored_t;
+
+/*
+ * Number of candidates whose model variance is computed together.
+ * Solving for several right-hand sides at once lets each row of the
+ * Cholesky factor be streamed from memory only once per batch.
+ */
+#define BATCH 8
+
+/*
+ * Number of nearest samples used to bound the model variance.
+ */
+#define NEAR 32
+
+/*
+ * Number of extra candidates used to refine the winning candidate.
+ */
+#define REFINE 64
+
+/*
+ * Model hyperparameters are no longer refit once the history grows
+ * beyond this size, since each refit costs O(n^3).
+ */
+#define FIT_LIMIT 512
+
+/*
+ * Smallest diagonal entry allowed in the Cholesky factor.  This
+ * guards against duplicate points, which would otherwise make the
+ * kernel matrix singular.
+ */
+#define JITTER 1e-10
+
+
+/*
+ * Row offset of the packed, row-major lower triangular factor.
+ */
+#define TRI(i) ((size_t) (i) * ((i) + 1) / 2)
+
+static const double length_grid[] = {0.05, 0.1, 0.2, 0.4, 0.8, 1.6};
+static const double noise_grid[]  = {1e-6, 1e-3, 1e-1};
+
+/*
+ * Structure to hold data for an individual Bayesian search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    int       space_id;
+    hspace_t* space;
+    hpoint_t  best;
+    double    best_perf;
+    hpoint_t  next;
+    unsigned  next_id;
+
+    // Configuration variables.
+    int           init_count;
+    acquisition_t acquisition;
+    double        kappa;
+    liar_t        liar;
+    int           sample_count;
+    sampler_t     sampler;
+    double*       unit;
+
+    // Encoding of search space dimensions into model features.
+    int*      offset;
+    int       width;
+
+    // Gaussian process model.
+    sample_t* sample;
+    int       len, cap;
+    int       observed;
+    int       fit_len;
+    double*   x;      // One row of encoded features per sample.
+    double*   chol;   // Packed Cholesky factor of the kernel matrix.
+    double*   target; // Standardized performance per sample.
+    double*   alpha;  // Kernel matrix inverse applied to target.
+    double*   kstar;  // Kernel values for a batch of candidates.
+    double    length;
+    double    noise;
+    double    incumbent;
+    int       incumbent_idx;
+
+    // Candidate points for the acquisition function.
+    double*   cand;
+    double*   mean;
+    int*      near;
+    scored_t* rank;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int    config_strategy(hplugin_data_t* data);
+static int    config_encoding(hplugin_data_t* data);
+static int    issue_point(hplugin_data_t* data, hpoint_t* point,
+                          unsigned id);
+static int    add_sample(hplugin_data_t* data, unsigned id);
+static int    find_sample(hplugin_data_t* data, unsigned id);
+static void   encode(hplugin_data_t* data, const hpoint_t* point, double* x);
+static void   decode(hplugin_data_t* data, const double* x, hpoint_t* point);
+static void   snap(hplugin_data_t* data, double* x);
+static void   random_features(hplugin_data_t* data, double* x);
+static void   design_features(hplugin_data_t* data, double* x);
+static void   perturb(hplugin_data_t* data, const double* src, double* dst,
+                      double sigma);
+static double kernel(hplugin_data_t* data, const double* a, const double* b);
+static void   model_append(hplugin_data_t* data, int row);
+static void   model_factor(hplugin_data_t* data);
+static void   model_remove(hplugin_data_t* data, int row);
+static double model_solve(hplugin_data_t* data);
+static void   model_fit(hplugin_data_t* data);
+static void   propose(hplugin_data_t* data, double* x);
+static int    score_candidates(hplugin_data_t* data, const double* cand,
+                               int count, double* best_score);
+static double local_variance(hplugin_data_t* data, const double* xc,
+                             const int* near, int m);
+static int    score_batch(hplugin_data_t* data, const double* cand,
+                          const int* queue, int m, double* best_score,
+                          int win);
+static double acquire(hplugin_data_t* data, double mean, double var);
+static int    score_cmp(const void* a, const void* b);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->best_perf = HUGE_VAL;
+    retval->next_id = 1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    if (data->space_id != space->id) {
+        if (hpoint_init(&data->next, space->len) != 0) {
+            search_error("Could not initialize point structure");
+            return -1;
+        }
+        data->next.len = space->len;
+        data->space = space;
+        data->space_id = space->id;
+
+        if (config_encoding(data) != 0)
+            return -1;
+    }
+
+    if (config_strategy(data) != 0)
+        return -1;
+
+    // Forget the model built for any previous search.
+    data->len = 0;
+    data->observed = 0;
+    data->fit_len = 0;
+    data->length = 0.2;
+    data->noise = 1e-3;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    if (issue_point(data, point, data->next_id++) != 0)
+        return -1;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = find_sample(data, point->id);
+
+    if (flow->point.id) {
+        hpoint_t* hint = &flow->point;
+
+        hint->id = point->id;
+        if (hpoint_copy(point, hint) != 0) {
+            search_error("Could not copy hint point during reject");
+            return -1;
+        }
+
+        // Move the sample to the hint's location.
+        if (idx >= 0)
+            model_remove(data, idx);
+
+        if (add_sample(data, point->id) != 0)
+            return -1;
+
+        encode(data, point, data->x + (data->len - 1) * data->width);
+        model_append(data, data->len - 1);
+    }
+    else {
+        // Keep the rejected point in the model as a poor performer, so
+        // it is not proposed again.
+        if (idx >= 0)
+            data->sample[idx].state = SAMPLE_REJECTED;
+
+        if (issue_point(data, point, point->id) != 0)
+            return -1;
+    }
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    double perf = hperf_unify(&trial->perf);
+
+    int idx = find_sample(data, trial->point.id);
+    if (idx >= 0) {
+        if (isfinite(perf)) {
+            data->sample[idx].state = SAMPLE_OBSERVED;
+            data->sample[idx].perf = perf;
+            ++data->observed;
+        }
+        else {
+            data->sample[idx].state = SAMPLE_REJECTED;
+        }
+    }
+
+    if (data->best_perf > perf) {
+        data->best_perf = perf;
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point out of strategy");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    free(data->rank);
+    free(data->near);
+    free(data->mean);
+    free(data->cand);
+    free(data->kstar);
+    free(data->alpha);
+    free(data->target);
+    free(data->chol);
+    free(data->x);
+    free(data->sample);
+    free(data->offset);
+    free(data->unit);
+
+    sampler_fini(&data->sampler);
+    hpoint_fini(&data->next);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    const char* cfgstr;
+
+    data->init_count = hcfg_int(search_cfg, CFGKEY_BAYES_INIT);
+    if (data->init_count < 0) {
+        search_error("Configuration key " CFGKEY_BAYES_INIT
+                     " must be non-negative");
+        return -1;
+    }
+    if (data->init_count == 0) {
+        data->init_count = 2 * data->space->len;
+        if (data->init_count < 4)
+            data->init_count = 4;
+    }
+
+    sample_method_t method = SAMPLE_METHOD_SOBOL;
+    cfgstr = hcfg_get(search_cfg, CFGKEY_SAMPLE_METHOD);
+    if (cfgstr) {
+        method = sample_method(cfgstr);
+        if (method == SAMPLE_METHOD_UNKNOWN) {
+            search_error("Invalid value for " CFGKEY_SAMPLE_METHOD
+                         " configuration key");
+            return -1;
+        }
+    }
+
+    if (sampler_init(&data->sampler, data->space->len, method,
+                     data->init_count) != 0)
+    {
+        search_error("Could not initialize point sampler");
+        return -1;
+    }
+
+    free(data->unit);
+    data->unit = malloc(data->space->len * sizeof(*data->unit));
+    if (!data->unit) {
+        search_error("Could not allocate sample buffer");
+        return -1;
+    }
+
+    cfgstr = hcfg_get(search_cfg, CFGKEY_BAYES_ACQUISITION);
+    if (strcmp(cfgstr, "ei") == 0) {
+        data->acquisition = ACQUISITION_EI;
+    }
+    else if (strcmp(cfgstr, "lcb") == 0) {
+        data->acquisition = ACQUISITION_LCB;
+    }
+    else {
+        search_error("Invalid value for "
+                     CFGKEY_BAYES_ACQUISITION " configuration key");
+        return -1;
+    }
+
+    data->kappa = hcfg_real(search_cfg, CFGKEY_BAYES_KAPPA);
+    if (isnan(data->kappa) || data->kappa < 0.0) {
+        search_error("Configuration key " CFGKEY_BAYES_KAPPA
+                     " must be non-negative");
+        return -1;
+    }
+
+    cfgstr = hcfg_get(search_cfg, CFGKEY_BAYES_LIAR);
+    if (strcmp(cfgstr, "best") == 0) {
+        data->liar = LIAR_BEST;
+    }
+    else if (strcmp(cfgstr, "mean") == 0) {
+        data->liar = LIAR_MEAN;
+    }
+    else if (strcmp(cfgstr, "worst") == 0) {
+        data->liar = LIAR_WORST;
+    }
+    else {
+        search_error("Invalid value for "
+                     CFGKEY_BAYES_LIAR " configuration key");
+        return -1;
+    }
+
+    int count = hcfg_int(search_cfg, CFGKEY_BAYES_SAMPLES);
+    if (count < 1) {
+        search_error("Configuration key " CFGKEY_BAYES_SAMPLES
+                     " must be positive");
+        return -1;
+    }
+
+    if (data->sample_count < count) {
+        int rows = count + REFINE;
+
+        free(data->cand);
+        free(data->mean);
+        free(data->near);
+        free(data->rank);
+        data->cand = malloc(rows * data->width * sizeof(*data->cand));
+        data->mean = malloc(rows * sizeof(*data->mean));
+        data->near = malloc(rows * NEAR * sizeof(*data->near));
+        data->rank = malloc(rows * sizeof(*data->rank));
+        if (!data->cand || !data->mean || !data->near || !data->rank) {
+            search_error("Could not allocate candidate points");
+            data->sample_count = 0;
+            return -1;
+        }
+    }
+    data->sample_count = count;
+
+    return 0;
+}
+
+/*
+ * Assign each search space dimension its range of model features.
+ * Enumerated dimensions receive one feature per value, and all other
+ * dimensions receive a single feature.
+ */
+int config_encoding(hplugin_data_t* data)
+{
+    hspace_t* space = data->space;
+
+    free(data->offset);
+    data->offset = malloc((space->len + 1) * sizeof(*data->offset));
+    if (!data->offset) {
+        search_error("Could not allocate feature offsets");
+        return -1;
+    }
+
+    data->width = 0;
+    for (int i = 0; i < space->len; ++i) {
+        data->offset[i] = data->width;
+        if (space->dim[i].type == HVAL_STR)
+            data->width += (int) hrange_limit(&space->dim[i]);
+        else
+            data->width += 1;
+    }
+    data->offset[space->len] = data->width;
+
+    // Sample and candidate buffers depend on the feature width.
+    free(data->x);
+    free(data->cand);
+    data->x = NULL;
+    data->cand = NULL;
+    data->len = 0;
+    data->cap = 0;
+    data->sample_count = 0;
+    free(data->sample);
+    data->sample = NULL;
+
+    return 0;
+}
+
+/*
+ * Choose a new point, record it in the model as pending, and copy it
+ * into the given point structure.
+ */
+int issue_point(hplugin_data_t* data, hpoint_t* point, unsigned id)
+{
+    if (data->observed >= 2 * data->fit_len &&
+        data->observed >= 2 && data->observed <= FIT_LIMIT)
+    {
+        model_fit(data);
+    }
+
+    if (add_sample(data, id) != 0)
+        return -1;
+
+    double* x = data->x + (data->len - 1) * data->width;
+    propose(data, x);
+    model_append(data, data->len - 1);
+
+    decode(data, x, &data->next);
+    data->next.id = id;
+    if (hpoint_copy(point, &data->next) != 0) {
+        search_error("Could not copy point during generation");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Reserve a pending sample at the end of the model, growing the
+ * model buffers if necessary.  The caller must fill in its features
+ * and append it to the Cholesky factor.
+ */
+int add_sample(hplugin_data_t* data, unsigned id)
+{
+    if (data->len == data->cap) {
+        if (array_grow(&data->sample, &data->cap,
+                       sizeof(*data->sample)) != 0)
+        {
+            search_error("Could not grow sample list");
+            return -1;
+        }
+
+        int cap = data->cap;
+        double* x      = realloc(data->x, cap * data->width * sizeof(*x));
+        double* chol   = realloc(data->chol, TRI(cap) * sizeof(*chol));
+        double* target = realloc(data->target, cap * sizeof(*target));
+        double* alpha  = realloc(data->alpha, cap * sizeof(*alpha));
+        double* kstar  = realloc(data->kstar, cap * BATCH * sizeof(*kstar));
+
+        if (x)      data->x = x;
+        if (chol)   data->chol = chol;
+        if (target) data->target = target;
+        if (alpha)  data->alpha = alpha;
+        if (kstar)  data->kstar = kstar;
+        if (!x || !chol || !target || !alpha || !kstar) {
+            search_error("Could not grow surrogate model");
+            return -1;
+        }
+    }
+
+    sample_t* sample = &data->sample[data->len++];
+    sample->id = id;
+    sample->state = SAMPLE_PENDING;
+    sample->perf = 0.0;
+    return 0;
+}
+
+int find_sample(hplugin_data_t* data, unsigned id)
+{
+    for (int i = data->len - 1; i >= 0; --i) {
+        if (data->sample[i].id == id &&
+            data->sample[i].state == SAMPLE_PENDING)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Map a point onto the unit hypercube of model features.
+ */
+void encode(hplugin_data_t* data, const hpoint_t* point, double* x)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        double* f = x + data->offset[i];
+
+        if (range->type == HVAL_STR) {
+            int limit = data->offset[i + 1] - data->offset[i];
+            for (int j = 0; j < limit; ++j)
+                f[j] = 0.0;
+            f[ hrange_index(range, &point->term[i]) ] = M_SQRT1_2;
+        }
+        else if (hrange_finite(range)) {
+            unsigned long limit = hrange_limit(range);
+            unsigned long idx = hrange_index(range, &point->term[i]);
+            *f = (limit > 1) ? (double) idx / (limit - 1) : 0.0;
+        }
+        else {
+            double span = range->bounds.r.max - range->bounds.r.min;
+            *f = (point->term[i].value.r - range->bounds.r.min);
+            *f = (span > 0.0) ? *f / span : 0.0;
+        }
+    }
+}
+
+/*
+ * Map a (snapped) feature vector back into the search space.
+ */
+void decode(hplugin_data_t* data, const double* x, hpoint_t* point)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        const double* f = x + data->offset[i];
+
+        if (range->type == HVAL_STR) {
+            int limit = data->offset[i + 1] - data->offset[i];
+            int idx = 0;
+            for (int j = 1; j < limit; ++j) {
+                if (f[idx] < f[j])
+                    idx = j;
+            }
+            point->term[i] = hrange_value(range, idx);
+        }
+        else if (hrange_finite(range)) {
+            unsigned long limit = hrange_limit(range);
+            unsigned long idx = (unsigned long) (*f * (limit - 1) + 0.5);
+            point->term[i] = hrange_value(range, idx);
+        }
+        else {
+            point->term[i] = hrange_random(range, *f);
+        }
+    }
+}
+
+/*
+ * Move a feature vector onto the nearest valid point of the search
+ * space, so the model scores exactly what would be proposed.
+ */
+void snap(hplugin_data_t* data, double* x)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        double* f = x + data->offset[i];
+
+        if (range->type == HVAL_STR) {
+            int limit = data->offset[i + 1] - data->offset[i];
+            int idx = 0;
+            for (int j = 1; j < limit; ++j) {
+                if (f[idx] < f[j])
+                    idx = j;
+            }
+            for (int j = 0; j < limit; ++j)
+                f[j] = (j == idx) ? M_SQRT1_2 : 0.0;
+            continue;
+        }
+
+        if (*f < 0.0) *f = 0.0;
+        if (*f > 1.0) *f = 1.0;
+
+        if (hrange_finite(range)) {
+            unsigned long limit = hrange_limit(range);
+            if (limit > 1) {
+                double idx = floor(*f * (limit - 1) + 0.5);
+                *f = idx / (limit - 1);
+            }
+            else {
+                *f = 0.0;
+            }
+        }
+    }
+}
+
+void random_features(hplugin_data_t* data, double* x)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        double* f = x + data->offset[i];
+
+        if (range->type == HVAL_STR) {
+            int limit = data->offset[i + 1] - data->offset[i];
+            int idx = (int) (search_drand48() * limit);
+            for (int j = 0; j < limit; ++j)
+                f[j] = (j == idx) ? M_SQRT1_2 : 0.0;
+        }
+        else {
+            *f = search_drand48();
+        }
+    }
+    snap(data, x);
+}
+
+/*
+ * Write the features of the next point of the initial design into x.
+ */
+void design_features(hplugin_data_t* data, double* x)
+{
+    sampler_next(&data->sampler, data->unit);
+
+    for (int i = 0; i < data->space->len; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        double* f = x + data->offset[i];
+        double u = data->unit[i];
+
+        if (range->type == HVAL_STR) {
+            int limit = data->offset[i + 1] - data->offset[i];
+            int idx = (int) (u * limit);
+            for (int j = 0; j < limit; ++j)
+                f[j] = (j == idx) ? M_SQRT1_2 : 0.0;
+        }
+        else if (hrange_finite(range)) {
+            unsigned long limit = hrange_limit(range);
+            unsigned long idx = (unsigned long) (u * limit);
+            *f = (limit > 1) ? (double) idx / (limit - 1) : 0.0;
+        }
+        else {
+            *f = u;
+        }
+    }
+}
+
+/*
+ * Produce a nearby copy of a feature vector.  Numeric features are
+ * moved by a normal deviate, while each enumerated dimension switches
+ * to a random value with probability 1/N for N dimensions.
+ */
+void perturb(hplugin_data_t* data, const double* src, double* dst,
+             double sigma)
+{
+    int dims = data->space->len;
+
+    memcpy(dst, src, data->width * sizeof(*dst));
+    for (int i = 0; i < dims; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+        double* f = dst + data->offset[i];
+
+        if (range->type == HVAL_STR) {
+            if (search_drand48() * dims < 1.0) {
+                int limit = data->offset[i + 1] - data->offset[i];
+                int idx = (int) (search_drand48() * limit);
+                for (int j = 0; j < limit; ++j)
+                    f[j] = (j == idx) ? M_SQRT1_2 : 0.0;
+            }
+        }
+        else {
+            *f += sigma * sample_normal();
+        }
+    }
+    snap(data, dst);
+}
+
+/*
+ * Matern 5/2 covariance with unit signal variance.
+ */
+double kernel(hplugin_data_t* data, const double* a, const double* b)
+{
+    double dist = 0.0;
+    for (int i = 0; i < data->width; ++i) {
+        double diff = a[i] - b[i];
+        dist += diff * diff;
+    }
+
+    double r = sqrt(5.0 * dist) / data->length;
+    return (1.0 + r + r * r / 3.0) * exp(-r);
+}
+
+/*
+ * Extend the Cholesky factor by one row for the sample at the given
+ * row index.  All previous rows must already be factored.  Each
+ * element is a dot product of two contiguous rows, so this costs
+ * O(n^2) and streams through the factor in memory order.
+ */
+void model_append(hplugin_data_t* data, int row)
+{
+    const double* x = data->x + row * data->width;
+    double* l = data->chol + TRI(row);
+
+    for (int j = 0; j < row; ++j)
+        l[j] = kernel(data, x, data->x + j * data->width);
+
+    double diag = 1.0 + data->noise;
+    for (int j = 0; j < row; ++j) {
+        const double* lj = data->chol + TRI(j);
+        double sum = l[j];
+
+        for (int k = 0; k < j; ++k)
+            sum -= l[k] * lj[k];
+        l[j] = sum / lj[j];
+        diag -= l[j] * l[j];
+    }
+
+    if (diag < JITTER)
+        diag = JITTER;
+    l[row] = sqrt(diag);
+}
+
+/*
+ * Compute the Cholesky factor from scratch.
+ */
+void model_factor(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->len; ++i)
+        model_append(data, i);
+}
+
+/*
+ * Remove a sample from the model.  Deleting row and column k of the
+ * kernel matrix leaves the leading rows of the factor untouched,
+ * while the trailing block receives a rank-1 update from column k.
+ */
+void model_remove(hplugin_data_t* data, int row)
+{
+    double* chol = data->chol;
+    int n = data->len;
+
+    // Rank-1 update of the trailing block, in place.  Column k of the
+    // factor is consumed as the update vector.
+    for (int j = row + 1; j < n; ++j) {
+        double* lj = chol + TRI(j);
+        double  u  = lj[row];
+        double  r  = sqrt(lj[j] * lj[j] + u * u);
+        double  c  = r / lj[j];
+        double  s  = u / lj[j];
+
+        lj[j] = r;
+        for (int i = j + 1; i < n; ++i) {
+            double* li = chol + TRI(i);
+            li[j] = (li[j] + s * li[row]) / c;
+            li[row] = c * li[row] - s * li[j];
+        }
+    }
+
+    // Compact the packed factor, dropping row and column k.
+    double* dst = chol + TRI(row);
+    for (int i = row + 1; i < n; ++i) {
+        const double* src = chol + TRI(i);
+
+        memmove(dst, src, row * sizeof(*dst));
+        dst += row;
+        memmove(dst, src + row + 1, (i - row) * sizeof(*dst));
+        dst += i - row;
+    }
+
+    memmove(data->x + row * data->width, data->x + (row + 1) * data->width,
+            (n - row - 1) * data->width * sizeof(*data->x));
+    memmove(data->sample + row, data->sample + row + 1,
+            (n - row - 1) * sizeof(*data->sample));
+    --data->len;
+}
+
+/*
+ * Standardize the performance of each sample (fabricating values
+ * where needed), and solve for the model weights.  Returns the log
+ * marginal likelihood of the model.
+ */
+double model_solve(hplugin_data_t* data)
+{
+    double sum = 0.0, sumsq = 0.0, min = HUGE_VAL, max = -HUGE_VAL;
+    int n = data->len;
+
+    data->incumbent_idx = -1;
+    for (int i = 0; i < n; ++i) {
+        if (data->sample[i].state != SAMPLE_OBSERVED)
+            continue;
+
+        double perf = data->sample[i].perf;
+        sum += perf;
+        sumsq += perf * perf;
+        if (min > perf) {
+            min = perf;
+            data->incumbent_idx = i;
+        }
+        if (max < perf)
+            max = perf;
+    }
+
+    double mean = 0.0, scale = 1.0;
+    if (data->observed > 0) {
+        mean = sum / data->observed;
+        scale = sqrt(fmax(sumsq / data->observed - mean * mean, 0.0));
+        if (!(scale > 1e-12 * fmax(fabs(mean), 1.0)))
+            scale = 1.0;
+    }
+    else {
+        min = max = 0.0;
+    }
+
+    double lie;
+    switch (data->liar) {
+    case LIAR_BEST:  lie = min; break;
+    case LIAR_WORST: lie = max; break;
+    default:         lie = mean; break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        switch (data->sample[i].state) {
+        case SAMPLE_OBSERVED: data->target[i] = data->sample[i].perf; break;
+        case SAMPLE_REJECTED: data->target[i] = max; break;
+        default:              data->target[i] = lie; break;
+        }
+        data->target[i] = (data->target[i] - mean) / scale;
+    }
+    data->incumbent = (min - mean) / scale;
+
+    // Forward substitution, L z = y.
+    double fit = 0.0;
+    double* alpha = data->alpha;
+    for (int i = 0; i < n; ++i) {
+        const double* li = data->chol + TRI(i);
+        double val = data->target[i];
+
+        for (int j = 0; j < i; ++j)
+            val -= li[j] * alpha[j];
+        alpha[i] = val / li[i];
+        fit += alpha[i] * alpha[i] / 2.0 + log(li[i]);
+    }
+
+    // Backward substitution, L^T a = z.  Rows of L are columns of L^T,
+    // so each solved element is scattered into the earlier elements.
+    for (int i = n - 1; i >= 0; --i) {
+        const double* li = data->chol + TRI(i);
+
+        alpha[i] /= li[i];
+        for (int j = 0; j < i; ++j)
+            alpha[j] -= li[j] * alpha[i];
+    }
+
+    return -fit - n * log(2.0 * M_PI) / 2.0;
+}
+
+/*
+ * Choose the kernel length scale and noise level which maximize the
+ * marginal likelihood of the current samples.
+ */
+void model_fit(hplugin_data_t* data)
+{
+    int lcount = sizeof(length_grid) / sizeof(*length_grid);
+    int ncount = sizeof(noise_grid) / sizeof(*noise_grid);
+    double best = -HUGE_VAL;
+    double best_length = data->length, best_noise = data->noise;
+
+    for (int i = 0; i < lcount; ++i) {
+        for (int j = 0; j < ncount; ++j) {
+            data->length = length_grid[i];
+            data->noise = noise_grid[j];
+            model_factor(data);
+
+            double lml = model_solve(data);
+            if (best < lml) {
+                best = lml;
+                best_length = data->length;
+                best_noise = data->noise;
+            }
+        }
+    }
+
+    data->length = best_length;
+    data->noise = best_noise;
+    model_factor(data);
+    data->fit_len = data->observed;
+}
+
+/*
+ * Write the features of the next point to evaluate into x.
+ */
+void propose(hplugin_data_t* data, double* x)
+{
+    int width = data->width;
+    int count = data->sample_count;
+
+    // The new sample occupies the last row, but is not yet factored.
+    --data->len;
+    if (data->len < data->init_count || data->observed == 0) {
+        design_features(data, x);
+        ++data->len;
+        return;
+    }
+    model_solve(data);
+
+    // Half of the candidates are drawn uniformly.  The other half are
+    // drawn near the incumbent, or near other observed samples.
+    double* cand = data->cand;
+    for (int i = 0; i < count; ++i) {
+        double* dst = cand + i * width;
+
+        if (i < count / 2) {
+            random_features(data, dst);
+        }
+        else if (i < 3 * count / 4) {
+            perturb(data, data->x + data->incumbent_idx * width, dst,
+                    data->length / 2);
+        }
+        else {
+            int idx;
+            do {
+                idx = (int) (search_drand48() * data->len);
+            } while (data->sample[idx].state != SAMPLE_OBSERVED);
+            perturb(data, data->x + idx * width, dst, data->length / 2);
+        }
+    }
+
+    double score = -HUGE_VAL;
+    int win = score_candidates(data, cand, count, &score);
+
+    // Refine the winner with a tighter local search.
+    double* local = cand + count * width;
+    memcpy(local, cand + win * width, width * sizeof(*local));
+    for (int i = 1; i < REFINE; ++i)
+        perturb(data, local, local + i * width, data->length / 8);
+
+    win = score_candidates(data, local, REFINE, &score);
+    memcpy(x, local + win * width, width * sizeof(*x));
+    ++data->len;
+}
+
+/*
+ * Find the candidate which maximizes the acquisition function, and
+ * return its index (or 0 if no candidate beats the given best score).
+ *
+ * The exact model variance costs O(n^2) per candidate, so it is only
+ * computed when two cheaper upper bounds on the score fail to rule a
+ * candidate out.  Both bounds rely on the fact that conditioning on
+ * fewer samples never decreases the variance.  The first uses only
+ * the nearest sample, and orders the candidates.  The second uses the
+ * NEAR nearest samples.
+ */
+int score_candidates(hplugin_data_t* data, const double* cand, int count,
+                     double* best_score)
+{
+    int width = data->width;
+    int n = data->len;
+    int m = (n < NEAR) ? n : NEAR;
+    int queue[BATCH], queued = 0;
+    int win = 0;
+
+    for (int c = 0; c < count; ++c) {
+        const double* xc = cand + c * width;
+        int* near = data->near + c * NEAR;
+        double near_k[NEAR];
+        double mean = 0.0;
+        int found = 0;
+
+        for (int i = 0; i < n; ++i) {
+            double k = kernel(data, xc, data->x + i * width);
+            mean += k * data->alpha[i];
+
+            // Keep the m largest kernel values in descending order.
+            if (found < m || near_k[m - 1] < k) {
+                int j = (found < m) ? found++ : m - 1;
+                for (; j > 0 && near_k[j - 1] < k; --j) {
+                    near_k[j] = near_k[j - 1];
+                    near[j] = near[j - 1];
+                }
+                near_k[j] = k;
+                near[j] = i;
+            }
+        }
+
+        double var = 1.0 - near_k[0] * near_k[0] / (1.0 + data->noise);
+        data->mean[c] = mean;
+        data->rank[c].score = acquire(data, mean, var);
+        data->rank[c].idx = c;
+    }
+    qsort(data->rank, count, sizeof(*data->rank), score_cmp);
+
+    for (int r = 0; r < count; ++r) {
+        if (data->rank[r].score <= *best_score)
+            break;
+
+        int idx = data->rank[r].idx;
+        double var = local_variance(data, cand + idx * width,
+                                    data->near + idx * NEAR, m);
+        if (acquire(data, data->mean[idx], var) <= *best_score)
+            continue;
+
+        queue[queued++] = idx;
+        if (queued == BATCH) {
+            win = score_batch(data, cand, queue, queued, best_score, win);
+            queued = 0;
+        }
+    }
+
+    if (queued)
+        win = score_batch(data, cand, queue, queued, best_score, win);
+    return win;
+}
+
+/*
+ * Model variance at a candidate, given only the samples listed in
+ * the near array.
+ */
+double local_variance(hplugin_data_t* data, const double* xc,
+                      const int* near, int m)
+{
+    double l[NEAR][NEAR], v[NEAR];
+    double var = 1.0;
+
+    for (int i = 0; i < m; ++i) {
+        const double* xi = data->x + near[i] * data->width;
+        double diag = 1.0 + data->noise;
+
+        for (int j = 0; j < i; ++j) {
+            double sum = kernel(data, xi, data->x + near[j] * data->width);
+
+            for (int k = 0; k < j; ++k)
+                sum -= l[i][k] * l[j][k];
+            l[i][j] = sum / l[j][j];
+            diag -= l[i][j] * l[i][j];
+        }
+        l[i][i] = sqrt(diag < JITTER ? JITTER : diag);
+
+        double sum = kernel(data, xc, xi);
+        for (int j = 0; j < i; ++j)
+            sum -= l[i][j] * v[j];
+        v[i] = sum / l[i][i];
+        var -= v[i] * v[i];
+    }
+    return (var > 0.0) ? var : 0.0;
+}
+
+/*
+ * Compute the exact score of a batch of candidates, and return the
+ * index of the best candidate seen so far.
+ */
+int score_batch(hplugin_data_t* data, const double* cand, const int* queue,
+                int m, double* best_score, int win)
+{
+    int width = data->width;
+    int n = data->len;
+
+    for (int i = 0; i < n; ++i) {
+        double* ki = data->kstar + i * BATCH;
+        for (int c = 0; c < m; ++c)
+            ki[c] = kernel(data, cand + queue[c] * width,
+                           data->x + i * width);
+        for (int c = m; c < BATCH; ++c)
+            ki[c] = 0.0;
+    }
+
+    // Forward substitution for the whole batch at once.
+    double var[BATCH];
+    for (int c = 0; c < BATCH; ++c)
+        var[c] = 1.0;
+
+    for (int i = 0; i < n; ++i) {
+        const double* li = data->chol + TRI(i);
+        double* vi = data->kstar + i * BATCH;
+        double acc[BATCH];
+
+        // Accumulate in a local array, which cannot alias the earlier
+        // rows, so the compiler is free to vectorize the inner loop.
+        for (int c = 0; c < BATCH; ++c)
+            acc[c] = vi[c];
+
+        for (int j = 0; j < i; ++j) {
+            const double* vj = data->kstar + j * BATCH;
+            double lij = li[j];
+
+            for (int c = 0; c < BATCH; ++c)
+                acc[c] -= lij * vj[c];
+        }
+        for (int c = 0; c < BATCH; ++c) {
+            vi[c] = acc[c] / li[i];
+            var[c] -= vi[c] * vi[c];
+        }
+    }
+
+    for (int c = 0; c < m; ++c) {
+        double score = acquire(data, data->mean[ queue[c] ],
+                               (var[c] > 0.0) ? var[c] : 0.0);
+        if (*best_score < score) {
+            *best_score = score;
+            win = queue[c];
+        }
+    }
+    return win;
+}
+
+/*
+ * Score a candidate by its predicted mean and variance.  Larger
+ * scores are better, and scores never decrease with the variance.
+ */
+double acquire(hplugin_data_t* data, double mean, double var)
+{
+    double sigma = sqrt(var);
+
+    if (data->acquisition == ACQUISITION_LCB)
+        return data->kappa * sigma - mean;
+
+    double gain = data->incumbent - mean;
+    if (sigma < 1e-12)
+        return (gain > 0.0) ? gain : 0.0;
+
+    double z = gain / sigma;
+    return (gain * erfc(-z * M_SQRT1_2) / 2.0 +
+            sigma * exp(-z * z / 2.0) / sqrt(2.0 * M_PI));
+}
+
+/*
+ * Sort scored candidates in descending order.
+ */
+int score_cmp(const void* a, const void* b)
+{
+    double diff = ((const scored_t*) b)->score - ((const scored_t*) a)->score;
+    return (diff > 0.0) - (diff < 0.0);
+}
@@ -0,0 +1,1072 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page cmaes Covariance Matrix Adaptation (cmaes.so)
+ *
+ * This search strategy implements the Covariance Matrix Adaptation
+ * Evolution Strategy (CMA-ES).  Each generation, a population of
+ * CMAES_LAMBDA candidate points is drawn from a multivariate normal
+ * distribution.  Once the entire population has been evaluated, the
+ * mean of the distribution moves toward the best performing half of
+ * the population, and its step size and covariance matrix adapt to
+ * the shape of the search landscape.  Unlike simplex-based methods,
+ * it remains effective on ill-conditioned and high-dimensional
+ * search spaces, and the population size is independent of the
+ * number of dimensions.
+ *
+ * Every candidate in a generation may be evaluated in parallel, so
+ * the population size should be at least the number of clients.  By
+ * default it is the larger of CLIENT_COUNT and the customary
+ * 4 + 3 ln(N) for an N-dimensional search space.
+ *
+ * The search operates on the unit hypercube, with each dimension
+ * scaled to its range.  Candidates are clamped to the range bounds,
+ * and integer, stepped real, and enumerated dimensions are rounded
+ * to a valid value.  The rounded candidate is what the distribution
+ * learns from.
+ *
+ * The eigendecomposition of the covariance matrix costs O(N^3), so
+ * it is only recomputed once enough generations have passed for the
+ * covariance matrix to change appreciably.  It uses Householder
+ * tridiagonalization followed by the implicit QL method, arranged so
+ * every inner loop walks contiguous memory.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+#include "libsample.h"
+#include "libvertex.h"
+
+#include <stdlib.h> // For malloc() and qsort().
+#include <string.h> // For memcpy(), memset(), and strcmp().
+#include <math.h>   // For exp(), hypot(), isnan(), log(), and sqrt().
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_INIT_POINT, NULL,
+      "Centroid point used to initialize the search distribution.  If "
+      "this key is left undefined, the center of the search space is "
+      "used." },
+    { CFGKEY_INIT_RADIUS, "0.3",
+      "Initial step size of the search distribution, as a fraction of "
+      "each dimension's range." },
+    { CFGKEY_CMAES_LAMBDA, "0",
+      "Number of candidate points generated per generation.  A value "
+      "of 0 selects the larger of " CFGKEY_CLIENT_COUNT " and "
+      "4 + 3 ln(N) for an N-dimensional search space." },
+    { CFGKEY_REJECT_METHOD, "penalty",
+      "How to choose a replacement when dealing with rejected points. "
+      "    penalty: Assign the invalid point the worst possible "
+      "performance, and offer the next candidate of the generation in "
+      "its place.  The distribution learns to avoid invalid regions.\n"
+      "    resample: Draw a replacement from the same distribution.  "
+      "Use this method if invalid points are rare, since the "
+      "distribution does not learn from them." },
+    { CFGKEY_SIZE_TOL, "0.0001",
+      "Convergence test succeeds if the standard deviation of the "
+      "search distribution along its widest axis falls below this "
+      "fraction of the search space.  The search also converges if "
+      "every candidate in a generation rounds to the same point." },
+    { NULL }
+};
+
+typedef enum reject_method {
+    REJECT_METHOD_UNKNOWN = 0,
+    REJECT_METHOD_PENALTY,
+    REJECT_METHOD_RESAMPLE,
+
+    REJECT_METHOD_MAX
+} reject_method_t;
+
+typedef enum offspring_state {
+    OFFSPRING_READY = 0,
+    OFFSPRING_ISSUED,
+    OFFSPRING_REPORTED,
+
+    OFFSPRING_MAX
+} offspring_state_t;
+
+typedef struct ranked {
+    double perf;
+    int    idx;
+} ranked_t;
+
+/*
+ * Structure to hold data for an individual CMA-ES search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    hspace_t* space;
+    hpoint_t  best;
+    hperf_t   best_perf;
+    unsigned  next_id;
+    int       converged;
+
+    // Configuration variables.
+    vertex_t        init_point;
+    double          init_sigma;
+    double          size_tol;
+    reject_method_t reject_type;
+    int             lambda;
+    int             mu;
+
+    // Strategy parameters.
+    double*   weights;
+    double    mueff;
+    double    cc, cs, c1, cmu, damps, chin;
+
+    // Search distribution.
+    int       n;
+    double*   mean;
+    double    sigma;
+    double*   pc;
+    double*   ps;
+    double*   cov;     // Covariance matrix, N x N.
+    double*   eigvec;  // Row j holds the j-th eigenvector of cov.
+    double*   eigval;  // Square roots of the eigenvalues of cov.
+    double*   work;
+    double*   tmp;
+    long      evals;
+    long      eigen_evals;
+
+    // Current generation.
+    double*            pop;   // Lambda rows of N normalized terms.
+    double*            fit;
+    unsigned*          id;
+    offspring_state_t* state;
+    ranked_t*          rank;
+    int                reported;
+
+    // Conversion between normalized terms and search space points.
+    vertex_t  vertex;
+    hpoint_t  point;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int    config_strategy(hplugin_data_t* data);
+static int    alloc_state(hplugin_data_t* data);
+static void   reset_state(hplugin_data_t* data);
+static int    sample_population(hplugin_data_t* data);
+static int    sample_offspring(hplugin_data_t* data, int k);
+static int    repair(hplugin_data_t* data, double* u);
+static int    make_point(hplugin_data_t* data, const double* u,
+                         unsigned id, hpoint_t* point);
+static void   normalize(hplugin_data_t* data, const vertex_t* vertex,
+                        double* u);
+static void   denormalize(hplugin_data_t* data, const double* u,
+                          vertex_t* vertex);
+static int    find_offspring(hplugin_data_t* data, unsigned id);
+static int    report_offspring(hplugin_data_t* data, int k, double perf);
+static void   update_distribution(hplugin_data_t* data);
+static void   decompose(hplugin_data_t* data);
+static void   tridiagonalize(double* v, double* d, double* e, int n);
+static void   diagonalize(double* v, double* d, double* e, int n);
+static void   check_convergence(hplugin_data_t* data);
+static int    rank_cmp(const void* a, const void* b);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->next_id = 1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    data->space = space;
+    if (config_strategy(data) != 0)
+        return -1;
+
+    if (alloc_state(data) != 0)
+        return -1;
+
+    reset_state(data);
+    if (sample_population(data) != 0)
+        return -1;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int k = 0;
+
+    if (!data->converged) {
+        while (k < data->lambda && data->state[k] != OFFSPRING_READY)
+            ++k;
+    }
+
+    if (data->converged || k == data->lambda) {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    if (make_point(data, &data->pop[k * data->n],
+                   data->next_id, point) != 0)
+        return -1;
+
+    data->id[k] = data->next_id++;
+    data->state[k] = OFFSPRING_ISSUED;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int k = find_offspring(data, point->id);
+    if (k < 0) {
+        search_error("Could not find rejected point in population");
+        return -1;
+    }
+    double* u = &data->pop[k * data->n];
+
+    if (flow->point.id) {
+        hpoint_t* hint = &flow->point;
+
+        hint->id = point->id;
+        if (hpoint_copy(point, hint) != 0) {
+            search_error("Could not copy hint point during reject");
+            return -1;
+        }
+
+        if (vertex_set(&data->vertex, data->space, point) != 0) {
+            search_error("Could not convert hint point to vertex");
+            return -1;
+        }
+        normalize(data, &data->vertex, u);
+    }
+    else if (data->reject_type == REJECT_METHOD_PENALTY) {
+        // Report an infinite penalty for the invalid point, and
+        // offer the next candidate in its place.
+        //
+        if (report_offspring(data, k, HUGE_VAL) != 0)
+            return -1;
+
+        return strategy_generate(data, flow, point);
+    }
+    else if (data->reject_type == REJECT_METHOD_RESAMPLE) {
+        // Draw a replacement from the same distribution.
+        if (sample_offspring(data, k) != 0)
+            return -1;
+
+        data->state[k] = OFFSPRING_ISSUED;
+        if (make_point(data, u, point->id, point) != 0)
+            return -1;
+    }
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    if (hperf_cmp(&data->best_perf, &trial->perf) > 0) {
+        if (hperf_copy(&data->best_perf, &trial->perf) != 0) {
+            search_error("Could not store best performance");
+            return -1;
+        }
+
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point during analyze");
+            return -1;
+        }
+    }
+
+    int k = find_offspring(data, trial->point.id);
+    if (k < 0)
+        return 0;
+
+    return report_offspring(data, k, hperf_unify(&trial->perf));
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point out of strategy");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    free(data->rank);
+    free(data->state);
+    free(data->id);
+    free(data->fit);
+    free(data->pop);
+    free(data->tmp);
+    free(data->work);
+    free(data->eigval);
+    free(data->eigvec);
+    free(data->cov);
+    free(data->ps);
+    free(data->pc);
+    free(data->mean);
+    free(data->weights);
+
+    hpoint_fini(&data->point);
+    vertex_fini(&data->vertex);
+    vertex_fini(&data->init_point);
+    hperf_fini(&data->best_perf);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    const char* cfgstr;
+    double cfgval;
+
+    cfgstr = hcfg_get(search_cfg, CFGKEY_INIT_POINT);
+    if (cfgstr) {
+        if (vertex_parse(&data->init_point, data->space, cfgstr) != 0) {
+            search_error("Could not convert initial point to vertex");
+            return -1;
+        }
+    }
+    else {
+        if (vertex_center(&data->init_point, data->space) != 0) {
+            search_error("Could not create central vertex");
+            return -1;
+        }
+    }
+
+    cfgval = hcfg_real(search_cfg, CFGKEY_INIT_RADIUS);
+    if (isnan(cfgval) || cfgval <= 0) {
+        search_error("Configuration key " CFGKEY_INIT_RADIUS
+                     " must be positive");
+        return -1;
+    }
+    data->init_sigma = cfgval;
+
+    cfgval = hcfg_real(search_cfg, CFGKEY_SIZE_TOL);
+    if (isnan(cfgval) || cfgval <= 0.0 || cfgval >= 1.0) {
+        search_error("Configuration key " CFGKEY_SIZE_TOL
+                     " must be between 0.0 and 1.0 (exclusive)");
+        return -1;
+    }
+    data->size_tol = cfgval;
+
+    cfgstr = hcfg_get(search_cfg, CFGKEY_REJECT_METHOD);
+    if (strcmp(cfgstr, "penalty") == 0) {
+        data->reject_type = REJECT_METHOD_PENALTY;
+    }
+    else if (strcmp(cfgstr, "resample") == 0) {
+        data->reject_type = REJECT_METHOD_RESAMPLE;
+    }
+    else {
+        search_error("Invalid value for "
+                     CFGKEY_REJECT_METHOD " configuration key");
+        return -1;
+    }
+
+    data->lambda = hcfg_int(search_cfg, CFGKEY_CMAES_LAMBDA);
+    if (data->lambda < 0 || data->lambda == 1) {
+        search_error("Configuration key " CFGKEY_CMAES_LAMBDA
+                     " must be 0 or at least 2");
+        return -1;
+    }
+
+    if (data->lambda == 0) {
+        int clients = hcfg_int(search_cfg, CFGKEY_CLIENT_COUNT);
+
+        data->lambda = 4 + (int) (3 * log(data->space->len));
+        if (data->lambda < clients)
+            data->lambda = clients;
+    }
+    data->mu = data->lambda / 2;
+
+    if (data->best_perf.len == 0) {
+        int perf_n = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
+        if (perf_n < 1) {
+            search_error("Invalid value for " CFGKEY_PERF_COUNT
+                         " configuration key");
+            return -1;
+        }
+
+        if (hperf_init(&data->best_perf, perf_n) != 0) {
+            search_error("Could not allocate best performance structure");
+            return -1;
+        }
+        data->best_perf.len = perf_n;
+    }
+    hperf_reset(&data->best_perf);
+
+    return 0;
+}
+
+/*
+ * (Re-)allocate the state vectors and matrices for the current search
+ * space dimensionality and population size.
+ */
+int alloc_state(hplugin_data_t* data)
+{
+    int n = data->space->len;
+    int lambda = data->lambda;
+
+    data->n = n;
+    data->weights = realloc(data->weights, data->mu * sizeof(double));
+    data->mean    = realloc(data->mean, n * sizeof(double));
+    data->pc      = realloc(data->pc, n * sizeof(double));
+    data->ps      = realloc(data->ps, n * sizeof(double));
+    data->cov     = realloc(data->cov, n * n * sizeof(double));
+    data->eigvec  = realloc(data->eigvec, n * n * sizeof(double));
+    data->eigval  = realloc(data->eigval, n * sizeof(double));
+    data->work    = realloc(data->work, n * sizeof(double));
+    data->tmp     = realloc(data->tmp, n * sizeof(double));
+    data->pop     = realloc(data->pop, lambda * n * sizeof(double));
+    data->fit     = realloc(data->fit, lambda * sizeof(double));
+    data->id      = realloc(data->id, lambda * sizeof(unsigned));
+    data->state   = realloc(data->state,
+                            lambda * sizeof(offspring_state_t));
+    data->rank    = realloc(data->rank, lambda * sizeof(ranked_t));
+
+    if (!data->weights || !data->mean || !data->pc || !data->ps ||
+        !data->cov || !data->eigvec || !data->eigval || !data->work ||
+        !data->tmp || !data->pop || !data->fit || !data->id ||
+        !data->state || !data->rank)
+    {
+        search_error("Could not allocate CMA-ES state");
+        return -1;
+    }
+
+    if (vertex_init(&data->vertex, n) != 0) {
+        search_error("Could not allocate vertex structure");
+        return -1;
+    }
+
+    if (hpoint_init(&data->point, n) != 0) {
+        search_error("Could not allocate point structure");
+        return -1;
+    }
+    data->point.len = n;
+
+    return 0;
+}
+
+/*
+ * Set the strategy parameters to their customary values, and start
+ * from an isotropic distribution around the initial point.
+ */
+void reset_state(hplugin_data_t* data)
+{
+    int n = data->n;
+    int mu = data->mu;
+    double sum = 0.0, sumsq = 0.0;
+
+    for (int i = 0; i < mu; ++i) {
+        data->weights[i] = log(mu + 0.5) - log(i + 1.0);
+        sum += data->weights[i];
+    }
+    for (int i = 0; i < mu; ++i) {
+        data->weights[i] /= sum;
+        sumsq += data->weights[i] * data->weights[i];
+    }
+    data->mueff = 1.0 / sumsq;
+
+    double mueff = data->mueff;
+    data->cc = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+    data->cs = (mueff + 2.0) / (n + mueff + 5.0);
+    data->c1 = 2.0 / ((n + 1.3) * (n + 1.3) + mueff);
+    data->cmu = 2.0 * (mueff - 2.0 + 1.0 / mueff) /
+                ((n + 2.0) * (n + 2.0) + mueff);
+    if (data->cmu > 1.0 - data->c1)
+        data->cmu = 1.0 - data->c1;
+    data->damps = 1.0 + data->cs +
+                  2.0 * fmax(0.0, sqrt((mueff - 1.0) / (n + 1.0)) - 1.0);
+    data->chin = sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    normalize(data, &data->init_point, data->mean);
+    data->sigma = data->init_sigma;
+    memset(data->pc, 0, n * sizeof(double));
+    memset(data->ps, 0, n * sizeof(double));
+    memset(data->cov, 0, n * n * sizeof(double));
+    memset(data->eigvec, 0, n * n * sizeof(double));
+    for (int i = 0; i < n; ++i) {
+        data->cov[i * n + i] = 1.0;
+        data->eigvec[i * n + i] = 1.0;
+        data->eigval[i] = 1.0;
+    }
+
+    data->evals = 0;
+    data->eigen_evals = 0;
+    data->converged = 0;
+}
+
+int sample_population(hplugin_data_t* data)
+{
+    for (int k = 0; k < data->lambda; ++k) {
+        if (sample_offspring(data, k) != 0)
+            return -1;
+    }
+    data->reported = 0;
+    return 0;
+}
+
+/*
+ * Draw mean + sigma * B * D * z for a standard normal vector z, and
+ * move the result onto a valid point of the search space.
+ */
+int sample_offspring(hplugin_data_t* data, int k)
+{
+    int n = data->n;
+    double* u = &data->pop[k * n];
+
+    memcpy(u, data->mean, n * sizeof(double));
+    for (int j = 0; j < n; ++j) {
+        const double* bj = &data->eigvec[j * n];
+        double scale = data->sigma * data->eigval[j] * sample_normal();
+
+        for (int i = 0; i < n; ++i)
+            u[i] += scale * bj[i];
+    }
+
+    if (repair(data, u) != 0)
+        return -1;
+
+    data->state[k] = OFFSPRING_READY;
+    return 0;
+}
+
+/*
+ * Clamp normalized terms to the search space bounds, and round them
+ * to the nearest valid value by way of an actual search space point.
+ */
+int repair(hplugin_data_t* data, double* u)
+{
+    for (int i = 0; i < data->n; ++i) {
+        double max = 1.0;
+        if (hrange_finite(&data->space->dim[i]))
+            max = nextafter(1.0, 0.0);
+
+        if (u[i] < 0.0) u[i] = 0.0;
+        if (u[i] > max) u[i] = max;
+    }
+
+    denormalize(data, u, &data->vertex);
+    if (vertex_point(&data->vertex, data->space, &data->point) != 0 ||
+        vertex_set(&data->vertex, data->space, &data->point) != 0)
+    {
+        search_error("Could not round candidate to search space");
+        return -1;
+    }
+    normalize(data, &data->vertex, u);
+    return 0;
+}
+
+int make_point(hplugin_data_t* data, const double* u,
+               unsigned id, hpoint_t* point)
+{
+    denormalize(data, u, &data->vertex);
+    data->vertex.id = id;
+    if (vertex_point(&data->vertex, data->space, point) != 0) {
+        search_error("Could not make point from vertex");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Vertex terms of finite dimensions already lie on the unit interval.
+ * Continuous real dimensions must be scaled from their bounds.
+ */
+void normalize(hplugin_data_t* data, const vertex_t* vertex, double* u)
+{
+    for (int i = 0; i < data->n; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+
+        if (hrange_finite(range)) {
+            u[i] = vertex->term[i];
+        }
+        else {
+            double span = range->bounds.r.max - range->bounds.r.min;
+
+            u[i] = vertex->term[i] - range->bounds.r.min;
+            u[i] = (span > 0.0) ? u[i] / span : 0.0;
+        }
+    }
+}
+
+void denormalize(hplugin_data_t* data, const double* u, vertex_t* vertex)
+{
+    for (int i = 0; i < data->n; ++i) {
+        const hrange_t* range = &data->space->dim[i];
+
+        if (hrange_finite(range)) {
+            vertex->term[i] = u[i];
+        }
+        else {
+            double span = range->bounds.r.max - range->bounds.r.min;
+            vertex->term[i] = range->bounds.r.min + u[i] * span;
+        }
+    }
+}
+
+int find_offspring(hplugin_data_t* data, unsigned id)
+{
+    for (int k = 0; k < data->lambda; ++k) {
+        if (data->id[k] == id && data->state[k] == OFFSPRING_ISSUED)
+            return k;
+    }
+    return -1;
+}
+
+/*
+ * Record the performance of an offspring, and start a new generation
+ * once the entire population has been evaluated.
+ */
+int report_offspring(hplugin_data_t* data, int k, double perf)
+{
+    data->fit[k] = perf;
+    data->state[k] = OFFSPRING_REPORTED;
+    if (++data->reported < data->lambda)
+        return 0;
+
+    update_distribution(data);
+    check_convergence(data);
+    if (!data->converged) {
+        if (sample_population(data) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * Adapt the mean, evolution paths, covariance matrix, and step size
+ * from a fully evaluated generation.
+ */
+void update_distribution(hplugin_data_t* data)
+{
+    int n = data->n;
+    double* old = data->tmp;
+    double* ymean = data->work;
+
+    for (int k = 0; k < data->lambda; ++k) {
+        data->rank[k].perf = data->fit[k];
+        data->rank[k].idx = k;
+    }
+    qsort(data->rank, data->lambda, sizeof(*data->rank), rank_cmp);
+    data->evals += data->lambda;
+
+    // Move the mean toward the weighted best half of the generation.
+    memcpy(old, data->mean, n * sizeof(double));
+    memset(data->mean, 0, n * sizeof(double));
+    for (int r = 0; r < data->mu; ++r) {
+        const double* u = &data->pop[data->rank[r].idx * n];
+        double w = data->weights[r];
+
+        for (int i = 0; i < n; ++i)
+            data->mean[i] += w * u[i];
+    }
+    for (int i = 0; i < n; ++i)
+        ymean[i] = (data->mean[i] - old[i]) / data->sigma;
+
+    // Conjugate evolution path: ps += C^(-1/2) * ymean, where
+    // C^(-1/2) = B * D^-1 * B^T.
+    double csn = sqrt(data->cs * (2.0 - data->cs) * data->mueff);
+    for (int i = 0; i < n; ++i)
+        data->ps[i] *= 1.0 - data->cs;
+
+    for (int j = 0; j < n; ++j) {
+        const double* bj = &data->eigvec[j * n];
+        double dot = 0.0;
+
+        for (int i = 0; i < n; ++i)
+            dot += bj[i] * ymean[i];
+
+        dot *= csn / data->eigval[j];
+        for (int i = 0; i < n; ++i)
+            data->ps[i] += dot * bj[i];
+    }
+
+    double psnorm = 0.0;
+    for (int i = 0; i < n; ++i)
+        psnorm += data->ps[i] * data->ps[i];
+    psnorm = sqrt(psnorm);
+
+    double gens = (double) data->evals / data->lambda;
+    double hsig = psnorm / sqrt(1.0 - pow(1.0 - data->cs, 2.0 * gens));
+    hsig = (hsig / data->chin < 1.4 + 2.0 / (n + 1.0)) ? 1.0 : 0.0;
+
+    double ccn = sqrt(data->cc * (2.0 - data->cc) * data->mueff);
+    for (int i = 0; i < n; ++i)
+        data->pc[i] = (1.0 - data->cc) * data->pc[i] + hsig * ccn * ymean[i];
+
+    // Rank-one and rank-mu covariance update.  Each row of the update
+    // is a scaled copy of a contiguous vector, so the inner loops are
+    // free to vectorize.
+    double c1 = data->c1, cmu = data->cmu;
+    double keep = 1.0 - c1 - cmu +
+                  (1.0 - hsig) * c1 * data->cc * (2.0 - data->cc);
+
+    for (int i = 0; i < n; ++i) {
+        double* ci = &data->cov[i * n];
+        double scale = c1 * data->pc[i];
+
+        for (int j = 0; j < n; ++j)
+            ci[j] = keep * ci[j] + scale * data->pc[j];
+    }
+
+    for (int r = 0; r < data->mu; ++r) {
+        const double* u = &data->pop[data->rank[r].idx * n];
+        double w = cmu * data->weights[r] / (data->sigma * data->sigma);
+
+        for (int i = 0; i < n; ++i)
+            ymean[i] = u[i] - old[i];
+
+        for (int i = 0; i < n; ++i) {
+            double* ci = &data->cov[i * n];
+            double scale = w * ymean[i];
+
+            for (int j = 0; j < n; ++j)
+                ci[j] += scale * ymean[j];
+        }
+    }
+
+    data->sigma *= exp((data->cs / data->damps) * (psnorm / data->chin - 1));
+
+    // Lazy eigendecomposition, amortized over enough generations that
+    // its O(N^3) cost is negligible next to the O(N^2) updates above.
+    double lag = data->lambda / (c1 + cmu) / n / 10.0;
+    if (data->evals - data->eigen_evals > lag) {
+        decompose(data);
+        data->eigen_evals = data->evals;
+    }
+}
+
+/*
+ * Compute the eigendecomposition of the covariance matrix, keeping
+ * the eigenvectors as rows of eigvec and the square roots of the
+ * eigenvalues in eigval.
+ */
+void decompose(hplugin_data_t* data)
+{
+    int n = data->n;
+    double* v = data->eigvec;
+    double* d = data->eigval;
+    double* e = data->work;
+
+    // Enforce symmetry, which rounding in the updates may disturb.
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (data->cov[i * n + j] + data->cov[j * n + i]) / 2;
+            data->cov[i * n + j] = avg;
+            data->cov[j * n + i] = avg;
+        }
+    }
+    memcpy(v, data->cov, n * n * sizeof(double));
+
+    tridiagonalize(v, d, e, n);
+    diagonalize(v, d, e, n);
+
+    // Bound the condition number of the covariance matrix.
+    double max = 0.0;
+    for (int i = 0; i < n; ++i) {
+        if (max < d[i])
+            max = d[i];
+    }
+
+    for (int i = 0; i < n; ++i) {
+        if (d[i] < max * 1e-14)
+            d[i] = max * 1e-14;
+        d[i] = sqrt(d[i]);
+    }
+}
+
+/*
+ * Symmetric Householder reduction to tridiagonal form, derived from
+ * the public domain JAMA library (which is in turn derived from the
+ * EISPACK routine tred2).
+ *
+ * The matrix V(r,c) is stored column-major, so every inner loop below
+ * (which iterates over rows) touches contiguous memory.  On return,
+ * column j of V (row j of v in memory) holds the j-th transformation
+ * vector, d holds the diagonal, and e holds the sub-diagonal.
+ */
+#define V(r, c) v[(c) * n + (r)]
+void tridiagonalize(double* v, double* d, double* e, int n)
+{
+    for (int j = 0; j < n; ++j)
+        d[j] = V(n - 1, j);
+
+    for (int i = n - 1; i > 0; --i) {
+        double scale = 0.0, h = 0.0;
+
+        for (int k = 0; k < i; ++k)
+            scale += fabs(d[k]);
+
+        if (scale == 0.0) {
+            e[i] = d[i - 1];
+            for (int j = 0; j < i; ++j) {
+                d[j] = V(i - 1, j);
+                V(i, j) = 0.0;
+                V(j, i) = 0.0;
+            }
+        }
+        else {
+            // Generate the Householder vector.
+            for (int k = 0; k < i; ++k) {
+                d[k] /= scale;
+                h += d[k] * d[k];
+            }
+
+            double f = d[i - 1];
+            double g = sqrt(h);
+            if (f > 0.0)
+                g = -g;
+
+            e[i] = scale * g;
+            h -= f * g;
+            d[i - 1] = f - g;
+            for (int j = 0; j < i; ++j)
+                e[j] = 0.0;
+
+            // Apply the similarity transformation to remaining columns.
+            for (int j = 0; j < i; ++j) {
+                f = d[j];
+                V(j, i) = f;
+                g = e[j] + V(j, j) * f;
+                for (int k = j + 1; k < i; ++k) {
+                    g += V(k, j) * d[k];
+                    e[k] += V(k, j) * f;
+                }
+                e[j] = g;
+            }
+
+            f = 0.0;
+            for (int j = 0; j < i; ++j) {
+                e[j] /= h;
+                f += e[j] * d[j];
+            }
+
+            double hh = f / (h + h);
+            for (int j = 0; j < i; ++j)
+                e[j] -= hh * d[j];
+
+            for (int j = 0; j < i; ++j) {
+                f = d[j];
+                g = e[j];
+                for (int k = j; k < i; ++k)
+                    V(k, j) -= (f * e[k] + g * d[k]);
+                d[j] = V(i - 1, j);
+                V(i, j) = 0.0;
+            }
+        }
+        d[i] = h;
+    }
+
+    // Accumulate the transformations.
+    for (int i = 0; i < n - 1; ++i) {
+        V(n - 1, i) = V(i, i);
+        V(i, i) = 1.0;
+
+        double h = d[i + 1];
+        if (h != 0.0) {
+            for (int k = 0; k <= i; ++k)
+                d[k] = V(k, i + 1) / h;
+
+            for (int j = 0; j <= i; ++j) {
+                double g = 0.0;
+                for (int k = 0; k <= i; ++k)
+                    g += V(k, i + 1) * V(k, j);
+                for (int k = 0; k <= i; ++k)
+                    V(k, j) -= g * d[k];
+            }
+        }
+
+        for (int k = 0; k <= i; ++k)
+            V(k, i + 1) = 0.0;
+    }
+
+    for (int j = 0; j < n; ++j) {
+        d[j] = V(n - 1, j);
+        V(n - 1, j) = 0.0;
+    }
+    V(n - 1, n - 1) = 1.0;
+    e[0] = 0.0;
+}
+
+/*
+ * Symmetric tridiagonal QL algorithm, derived from the public domain
+ * JAMA library (which is in turn derived from the EISPACK routine
+ * tql2).  Each plane rotation updates two columns of V, which are
+ * contiguous in memory.  On return, d holds the eigenvalues and the
+ * columns of V hold the corresponding eigenvectors.
+ */
+void diagonalize(double* v, double* d, double* e, int n)
+{
+    double f = 0.0, tst1 = 0.0;
+    double eps = pow(2.0, -52.0);
+
+    for (int i = 1; i < n; ++i)
+        e[i - 1] = e[i];
+    e[n - 1] = 0.0;
+
+    for (int l = 0; l < n; ++l) {
+        // Find a small sub-diagonal element.
+        tst1 = fmax(tst1, fabs(d[l]) + fabs(e[l]));
+
+        int m = l;
+        while (m < n - 1 && fabs(e[m]) > eps * tst1)
+            ++m;
+
+        // If m == l, d[l] is already an eigenvalue.  Otherwise, iterate.
+        for (int iter = 0; m > l && iter < 30 * n; ++iter) {
+            // Compute the implicit shift.
+            double g = d[l];
+            double p = (d[l + 1] - g) / (2.0 * e[l]);
+            double r = hypot(p, 1.0);
+            if (p < 0)
+                r = -r;
+
+            d[l] = e[l] / (p + r);
+            d[l + 1] = e[l] * (p + r);
+
+            double dl1 = d[l + 1];
+            double h = g - d[l];
+            for (int i = l + 2; i < n; ++i)
+                d[i] -= h;
+            f += h;
+
+            // Implicit QL transformation.
+            p = d[m];
+            double c = 1.0, c2 = 1.0, c3 = 1.0;
+            double el1 = e[l + 1];
+            double s = 0.0, s2 = 0.0;
+
+            for (int i = m - 1; i >= l; --i) {
+                double* vi = &V(0, i);
+                double* vn = &V(0, i + 1);
+
+                c3 = c2;
+                c2 = c;
+                s2 = s;
+                g = c * e[i];
+                h = c * p;
+                r = hypot(p, e[i]);
+                e[i + 1] = s * r;
+                s = e[i] / r;
+                c = p / r;
+                p = c * d[i] - s * g;
+                d[i + 1] = h + s * (c * g + s * d[i]);
+
+                // Accumulate the transformation.
+                for (int k = 0; k < n; ++k) {
+                    h = vn[k];
+                    vn[k] = s * vi[k] + c * h;
+                    vi[k] = c * vi[k] - s * h;
+                }
+            }
+
+            p = -s * s2 * c3 * el1 * e[l] / dl1;
+            e[l] = s * p;
+            d[l] = c * p;
+
+            if (fabs(e[l]) <= eps * tst1)
+                break;
+        }
+        d[l] += f;
+        e[l] = 0.0;
+    }
+}
+#undef V
+
+void check_convergence(hplugin_data_t* data)
+{
+    int n = data->n;
+    double widest = 0.0;
+
+    for (int i = 0; i < n; ++i) {
+        if (widest < data->eigval[i])
+            widest = data->eigval[i];
+    }
+    if (data->sigma * widest < data->size_tol)
+        goto converged;
+
+    // A distribution narrower than the rounding of finite dimensions
+    // can no longer make progress.
+    for (int k = 1; k < data->lambda; ++k) {
+        if (memcmp(&data->pop[k * n], data->pop, n * sizeof(double)) != 0)
+            return;
+    }
+
+  converged:
+    data->converged = 1;
+    search_setcfg(CFGKEY_CONVERGED, "1");
+}
+
+/*
+ * Sort ranked offspring in ascending order of performance.
+ */
+int rank_cmp(const void* a, const void* b)
+{
+    double diff = ((const ranked_t*) a)->perf - ((const ranked_t*) b)->perf;
+    return (diff > 0.0) - (diff < 0.0);
+}
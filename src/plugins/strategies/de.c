@@ -0,0 +1,636 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page de Differential Evolution (de.so)
+ *
+ * This search strategy implements a steady-state variant of
+ * Differential Evolution (DE/rand/1/bin).  It maintains a population
+ * of DE_POPULATION points, which is initially filled with a Latin
+ * hypercube sample (see SAMPLE_METHOD).  Each request for a new point
+ * produces a trial point for the next population member in turn:
+ * three other members a, b, and c are chosen at random, and the trial
+ * takes each term either from the mutant a + DE_F * (b - c) (with
+ * probability DE_CR) or from the member itself.  When the trial's
+ * performance is reported, it replaces the member if it performs at
+ * least as well.
+ *
+ * There is no generational barrier.  A point is available whenever a
+ * client asks for one, and the population is updated as soon as each
+ * result arrives, so slow clients never hold up fast ones.  The
+ * population should be much larger than the number of clients, so
+ * that few trials target a member which is still being improved.
+ *
+ * Enumerated dimensions have no notion of distance, and are handled
+ * natively.  The mutant keeps the value of a, unless b and c differ,
+ * in which case it takes a random value with probability DE_F.  Thus,
+ * enumerated values stop changing once the population agrees on them.
+ * Integer and stepped real values are rounded to the nearest valid
+ * value.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+#include "libvertex.h"
+#include "libsample.h"
+
+#include <stdlib.h>
+#include <string.h> // For memset().
+#include <math.h>   // For isnan() and nextafter().
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_DE_POPULATION, "0",
+      "Number of points in the population.  A value of 0 selects the "
+      "larger of 10 times the number of search space dimensions and 4 "
+      "times " CFGKEY_CLIENT_COUNT "." },
+    { CFGKEY_DE_F, "0.5",
+      "Differential weight applied to the difference vector when "
+      "building a mutant point." },
+    { CFGKEY_DE_CR, "0.9",
+      "Crossover probability.  Each term of a trial point is taken from "
+      "the mutant point with this probability, and from the population "
+      "member otherwise." },
+    { CFGKEY_SAMPLE_METHOD, NULL,
+      "Method used to generate the initial population.  Valid values "
+      "are uniform, sobol, and lhs (default)." },
+    { CFGKEY_SIZE_TOL, "0.0001",
+      "Convergence test succeeds if the population spans less than this "
+      "fraction of the search space in every dimension." },
+    { NULL }
+};
+
+/*
+ * A trial point under evaluation, and the population member it may
+ * replace.  Trials with a negative target are part of the initial
+ * population.
+ */
+typedef struct trial {
+    vertex_t vertex;
+    int      target;
+} trial_t;
+
+/*
+ * Structure to hold data for an individual DE search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    hspace_t* space;
+    hpoint_t  best;
+    hperf_t   best_perf;
+    unsigned  next_id;
+    int       converged;
+
+    // Configuration variables.
+    int       pop_size;
+    double    weight;
+    double    crossover;
+    double    size_tol;
+
+    // Search state.
+    vertex_t* pop;
+    double*   fit;
+    int       pop_len;      // Number of evaluated population members.
+    int       init_pending; // Number of random points under evaluation.
+    int       target;
+    int       evals;
+
+    trial_t*  trial;
+    int       trial_len, trial_cap;
+
+    hpoint_t  point;
+    sampler_t sampler;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int  config_strategy(hplugin_data_t* data);
+static int  alloc_state(hplugin_data_t* data);
+static int  make_trial(hplugin_data_t* data, vertex_t* vertex, int target);
+static void pick_members(hplugin_data_t* data, int target, int* idx);
+static void bounds(hplugin_data_t* data, int i, double* min, double* max);
+static int  repair(hplugin_data_t* data, vertex_t* vertex);
+static int  find_trial(hplugin_data_t* data, unsigned id);
+static void check_convergence(hplugin_data_t* data);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->next_id = 1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    data->space = space;
+    if (config_strategy(data) != 0)
+        return -1;
+
+    if (alloc_state(data) != 0)
+        return -1;
+
+    data->pop_len = 0;
+    data->init_pending = 0;
+    data->target = 0;
+    data->evals = 0;
+    data->trial_len = 0;
+    data->converged = 0;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    if (data->converged) {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    if (data->trial_len == data->trial_cap) {
+        if (array_grow(&data->trial, &data->trial_cap,
+                       sizeof(*data->trial)) != 0)
+        {
+            search_error("Could not grow trial list");
+            return -1;
+        }
+    }
+    trial_t* trial = &data->trial[data->trial_len];
+
+    // Fill the initial population with random points, then generate
+    // trials for each evaluated population member in turn.
+    if (data->pop_len + data->init_pending < data->pop_size ||
+        data->pop_len < 4)
+    {
+        trial->target = -1;
+        ++data->init_pending;
+    }
+    else {
+        if (data->target >= data->pop_len)
+            data->target = 0;
+        trial->target = data->target++;
+    }
+
+    if (make_trial(data, &trial->vertex, trial->target) != 0)
+        return -1;
+
+    trial->vertex.id = data->next_id;
+    if (vertex_point(&trial->vertex, data->space, point) != 0) {
+        search_error("Could not make point from trial vertex");
+        return -1;
+    }
+    ++data->next_id;
+    ++data->trial_len;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = find_trial(data, point->id);
+    if (idx < 0) {
+        search_error("Could not find rejected point");
+        return -1;
+    }
+    trial_t* trial = &data->trial[idx];
+
+    if (flow->point.id) {
+        hpoint_t* hint = &flow->point;
+
+        hint->id = point->id;
+        if (vertex_set(&trial->vertex, data->space, hint) != 0) {
+            search_error("Could not copy hint into trial during reject");
+            return -1;
+        }
+
+        if (hpoint_copy(point, hint) != 0) {
+            search_error("Could not return hint during reject");
+            return -1;
+        }
+    }
+    else {
+        // An invalid trial would never survive selection, so simply
+        // build another for the same population member.
+        if (make_trial(data, &trial->vertex, trial->target) != 0)
+            return -1;
+
+        trial->vertex.id = point->id;
+        if (vertex_point(&trial->vertex, data->space, point) != 0) {
+            search_error("Could not make point from trial vertex");
+            return -1;
+        }
+    }
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    if (hperf_cmp(&data->best_perf, &trial->perf) > 0) {
+        if (hperf_copy(&data->best_perf, &trial->perf) != 0) {
+            search_error("Could not store best performance");
+            return -1;
+        }
+
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point during analyze");
+            return -1;
+        }
+    }
+
+    int idx = find_trial(data, trial->point.id);
+    if (idx < 0)
+        return 0;
+
+    trial_t* entry = &data->trial[idx];
+    double perf = hperf_unify(&trial->perf);
+    int target = entry->target;
+
+    // Random points are appended to the population, or replace the
+    // worst member once it is full.  Trials replace their target if
+    // they perform at least as well.
+    if (target < 0) {
+        --data->init_pending;
+        if (data->pop_len < data->pop_size) {
+            target = data->pop_len++;
+        }
+        else {
+            target = 0;
+            for (int i = 1; i < data->pop_size; ++i) {
+                if (data->fit[target] < data->fit[i])
+                    target = i;
+            }
+            if (perf > data->fit[target])
+                target = -1;
+        }
+    }
+    else if (perf > data->fit[target]) {
+        target = -1;
+    }
+
+    if (target >= 0) {
+        if (vertex_copy(&data->pop[target], &entry->vertex) != 0) {
+            search_error("Could not copy trial into population");
+            return -1;
+        }
+        data->fit[target] = perf;
+    }
+
+    // Remove the trial by swapping it with the last entry.  Vertex
+    // buffers are parked past the end of the list for reuse.
+    trial_t tmp = *entry;
+    *entry = data->trial[--data->trial_len];
+    data->trial[data->trial_len] = tmp;
+
+    // Check for convergence once per population's worth of results.
+    if (++data->evals >= data->pop_size &&
+        data->pop_len == data->pop_size)
+    {
+        data->evals = 0;
+        check_convergence(data);
+    }
+    return 0;
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point out of strategy");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->trial_cap; ++i)
+        vertex_fini(&data->trial[i].vertex);
+    free(data->trial);
+
+    for (int i = 0; i < data->pop_size; ++i)
+        vertex_fini(&data->pop[i]);
+    free(data->pop);
+    free(data->fit);
+
+    sampler_fini(&data->sampler);
+    hpoint_fini(&data->point);
+    hperf_fini(&data->best_perf);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    double cfgval;
+
+    int size = hcfg_int(search_cfg, CFGKEY_DE_POPULATION);
+    if (size < 0 || (size > 0 && size < 4)) {
+        search_error("Configuration key " CFGKEY_DE_POPULATION
+                     " must be 0 or at least 4");
+        return -1;
+    }
+
+    if (size == 0) {
+        int clients = hcfg_int(search_cfg, CFGKEY_CLIENT_COUNT);
+
+        size = 10 * data->space->len;
+        if (size < 4 * clients)
+            size = 4 * clients;
+    }
+
+    // Release any population members beyond the new size.
+    for (int i = size; i < data->pop_size; ++i)
+        vertex_fini(&data->pop[i]);
+    if (data->pop_size != size) {
+        vertex_t* pop = realloc(data->pop, size * sizeof(*pop));
+        double*   fit = realloc(data->fit, size * sizeof(*fit));
+
+        if (pop) data->pop = pop;
+        if (fit) data->fit = fit;
+        if (!pop || !fit) {
+            search_error("Could not allocate population");
+            return -1;
+        }
+
+        for (int i = data->pop_size; i < size; ++i)
+            memset(&data->pop[i], 0, sizeof(*data->pop));
+        data->pop_size = size;
+    }
+
+    cfgval = hcfg_real(search_cfg, CFGKEY_DE_F);
+    if (isnan(cfgval) || cfgval <= 0.0 || cfgval > 2.0) {
+        search_error("Configuration key " CFGKEY_DE_F
+                     " must be between 0.0 (exclusive) and 2.0");
+        return -1;
+    }
+    data->weight = cfgval;
+
+    cfgval = hcfg_real(search_cfg, CFGKEY_DE_CR);
+    if (isnan(cfgval) || cfgval < 0.0 || cfgval > 1.0) {
+        search_error("Configuration key " CFGKEY_DE_CR
+                     " must be between 0.0 and 1.0");
+        return -1;
+    }
+    data->crossover = cfgval;
+
+    cfgval = hcfg_real(search_cfg, CFGKEY_SIZE_TOL);
+    if (isnan(cfgval) || cfgval <= 0.0 || cfgval >= 1.0) {
+        search_error("Configuration key " CFGKEY_SIZE_TOL
+                     " must be between 0.0 and 1.0 (exclusive)");
+        return -1;
+    }
+    data->size_tol = cfgval;
+
+    sample_method_t method = SAMPLE_METHOD_LHS;
+    const char* cfgstr = hcfg_get(search_cfg, CFGKEY_SAMPLE_METHOD);
+    if (cfgstr) {
+        method = sample_method(cfgstr);
+        if (method == SAMPLE_METHOD_UNKNOWN) {
+            search_error("Invalid value for " CFGKEY_SAMPLE_METHOD
+                         " configuration key");
+            return -1;
+        }
+    }
+
+    if (sampler_init(&data->sampler, data->space->len, method,
+                     data->pop_size) != 0)
+    {
+        search_error("Could not initialize point sampler");
+        return -1;
+    }
+    return 0;
+}
+
+int alloc_state(hplugin_data_t* data)
+{
+    if (data->best_perf.len == 0) {
+        int perf_n = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
+        if (perf_n < 1) {
+            search_error("Invalid value for " CFGKEY_PERF_COUNT
+                         " configuration key");
+            return -1;
+        }
+
+        if (hperf_init(&data->best_perf, perf_n) != 0) {
+            search_error("Could not allocate best performance structure");
+            return -1;
+        }
+        data->best_perf.len = perf_n;
+    }
+    hperf_reset(&data->best_perf);
+
+    if (hpoint_init(&data->point, data->space->len) != 0) {
+        search_error("Could not allocate point structure");
+        return -1;
+    }
+    data->point.len = data->space->len;
+
+    return 0;
+}
+
+/*
+ * Build a new trial vertex for the given population member, or a
+ * sampled vertex if the target is negative.
+ */
+int make_trial(hplugin_data_t* data, vertex_t* vertex, int target)
+{
+    int n = data->space->len;
+
+    if (target < 0) {
+        if (sampler_point(&data->sampler, data->space, &data->point) != 0 ||
+            vertex_set(vertex, data->space, &data->point) != 0)
+        {
+            search_error("Could not make sampled trial vertex");
+            return -1;
+        }
+        return 0;
+    }
+
+    if (vertex->len != n) {
+        if (vertex_init(vertex, n) != 0) {
+            search_error("Could not allocate trial vertex");
+            return -1;
+        }
+    }
+
+    int idx[3];
+    pick_members(data, target, idx);
+
+    const double* x = data->pop[target].term;
+    const double* a = data->pop[ idx[0] ].term;
+    const double* b = data->pop[ idx[1] ].term;
+    const double* c = data->pop[ idx[2] ].term;
+
+    // At least one term is always taken from the mutant.
+    int forced = (int) (search_drand48() * n);
+
+    for (int i = 0; i < n; ++i) {
+        if (i != forced && search_drand48() >= data->crossover) {
+            vertex->term[i] = x[i];
+            continue;
+        }
+
+        if (data->space->dim[i].type == HVAL_STR) {
+            vertex->term[i] = a[i];
+            if (b[i] != c[i] && search_drand48() < data->weight)
+                vertex->term[i] = search_drand48();
+            continue;
+        }
+
+        double min, max;
+        bounds(data, i, &min, &max);
+
+        // Terms which leave the search space are placed halfway
+        // between the base point and the violated bound.
+        double val = a[i] + data->weight * (b[i] - c[i]);
+        if (val < min) val = (min + a[i]) / 2;
+        if (val > max) val = (max + a[i]) / 2;
+        vertex->term[i] = val;
+    }
+    return repair(data, vertex);
+}
+
+/*
+ * Choose three distinct evaluated population members, all different
+ * from the target member.
+ */
+void pick_members(hplugin_data_t* data, int target, int* idx)
+{
+    for (int i = 0; i < 3; ++i) {
+        int j;
+        do {
+            idx[i] = (int) (search_drand48() * data->pop_len);
+            for (j = 0; j < i && idx[j] != idx[i]; ++j)
+                continue;
+        } while (idx[i] == target || j < i);
+    }
+}
+
+void bounds(hplugin_data_t* data, int i, double* min, double* max)
+{
+    const hrange_t* range = &data->space->dim[i];
+
+    if (hrange_finite(range)) {
+        *min = 0.0;
+        *max = nextafter(1.0, 0.0);
+    }
+    else {
+        *min = range->bounds.r.min;
+        *max = range->bounds.r.max;
+    }
+}
+
+/*
+ * Round a vertex to the nearest valid point in the search space.
+ */
+int repair(hplugin_data_t* data, vertex_t* vertex)
+{
+    unsigned id = vertex->id;
+
+    if (vertex_point(vertex, data->space, &data->point) != 0 ||
+        vertex_set(vertex, data->space, &data->point) != 0)
+    {
+        search_error("Could not round trial vertex to search space");
+        return -1;
+    }
+    vertex->id = id;
+    return 0;
+}
+
+int find_trial(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->trial_len; ++i) {
+        if (data->trial[i].vertex.id == id)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * The search has converged once the population has collapsed.
+ */
+void check_convergence(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        double lo = data->pop[0].term[i];
+        double hi = lo;
+
+        for (int j = 1; j < data->pop_size; ++j) {
+            double val = data->pop[j].term[i];
+            if (lo > val) lo = val;
+            if (hi < val) hi = val;
+        }
+
+        double min, max;
+        bounds(data, i, &min, &max);
+        if (hi - lo >= data->size_tol * (max - min))
+            return;
+    }
+
+    data->converged = 1;
+    search_setcfg(CFGKEY_CONVERGED, "1");
+}
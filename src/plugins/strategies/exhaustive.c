@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
  */
+#define _XOPEN_SOURCE 600 // Needed for ftruncate() and gethostname().
 
 /**
  * \page exhaustive Exhaustive (exhaustive.so)
@@ -28,6 +29,23 @@
  *
  * It is mainly used as a basis of comparison for more intelligent
  * search strategies.
+ *
+ * Points of a finite search space are enumerated by their linear
+ * index (in the same order as the odometer), which allows a sweep to
+ * be divided among several independent sessions.  If the
+ * EXHAUSTIVE_STATE configuration key names a file, each session
+ * reserves blocks of EXHAUSTIVE_BLOCK indexes from a range it owns,
+ * recorded in that file.  A session whose range is exhausted steals
+ * the upper half of the largest unreserved range owned by another
+ * session.  The file must be on a file system shared by all
+ * participating sessions, and which supports fcntl() locks.
+ *
+ * The file also serves as a checkpoint.  It records how much of each
+ * range has been completed, and ranges are removed once complete.  A
+ * range whose session ends early is returned to the pool, as is the
+ * range of a session which has not updated the file for
+ * EXHAUSTIVE_TIMEOUT seconds (or which is known to have exited), so
+ * a later session resumes the sweep where it stopped.
  */
 
 #include "hstrategy.h"
@@ -35,9 +53,15 @@
 #include "hutil.h"
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <math.h>
+#include <time.h>
+#include <signal.h>   // For kill().
+#include <inttypes.h> // For PRIu64 and SCNu64.
+#include <unistd.h>
+#include <fcntl.h>
 
 /*
  * Configuration variables used in this plugin.
@@ -49,6 +73,14 @@ const hcfg_info_t hplugin_keyinfo[] = {
       "is considered converged." },
     { CFGKEY_INIT_POINT, NULL,
       "Initial point begin testing from." },
+    { CFGKEY_EXHAUSTIVE_STATE, NULL,
+      "File used to share the search space among sessions, and to "
+      "record their progress.  Only used for finite search spaces." },
+    { CFGKEY_EXHAUSTIVE_BLOCK, "1024",
+      "Number of points reserved from the state file at a time." },
+    { CFGKEY_EXHAUSTIVE_TIMEOUT, "600",
+      "Seconds after which the range of a silent session may be "
+      "claimed by others." },
     { NULL }
 };
 
@@ -61,6 +93,28 @@ typedef union unit {
     double        value;
 } unit_u;
 
+/*
+ * A range of linear indexes owned by a single session.  Indexes in
+ * [base, done) have been evaluated, and indexes in [done, next) have
+ * been reserved by the owner.  Indexes in [next, end) may be stolen.
+ */
+#define OWNER_MAX 128
+#define OWNER_FREE "-"
+
+typedef struct range {
+    char     owner[OWNER_MAX];
+    long     stamp;
+    uint64_t base;
+    uint64_t done;
+    uint64_t next;
+    uint64_t end;
+} range_t;
+
+typedef struct pending {
+    unsigned id;
+    uint64_t index;
+} pending_t;
+
 /*
  * Structure to hold data for an individual exhaustive search instance.
  */
@@ -79,6 +133,23 @@ struct hplugin_data {
     int final_id;
     int outstanding_points;
     int final_point_received;
+
+    // Linear index enumeration for finite search spaces.
+    uint64_t   total;
+    uint64_t   block_next, block_end;
+    int        exhausted;
+    pending_t* pending;
+    int        pending_len, pending_cap;
+
+    // Work ranges, shared through a state file.
+    range_t*  range;
+    int       range_len, range_cap;
+    FILE*     fp;
+    char      owner[OWNER_MAX];
+    char      host[64];
+    int       block;
+    long      timeout;
+    long      synced;
 };
 
 /*
@@ -87,6 +158,18 @@ struct hplugin_data {
 static int  config_strategy(hplugin_data_t* data);
 static void increment(hplugin_data_t* data);
 static int  make_next_point(hplugin_data_t* data, hpoint_t* point);
+static int  config_ranges(hplugin_data_t* data, uint64_t start);
+static int  next_index(hplugin_data_t* data, uint64_t* index);
+static int  sync_ranges(hplugin_data_t* data, int claim);
+static int  claim_range(hplugin_data_t* data, long now);
+static int  add_range(hplugin_data_t* data, const char* owner,
+                      uint64_t base, uint64_t end);
+static int  abandoned(hplugin_data_t* data, const range_t* range, long now);
+static void release_ranges(hplugin_data_t* data);
+static int  lock_state(hplugin_data_t* data);
+static int  unlock_state(hplugin_data_t* data);
+static void drop_lock(hplugin_data_t* data);
+static int  finish(hplugin_data_t* data);
 
 /*
  * Allocate memory for a new search task.
@@ -158,6 +241,46 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
  */
 int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
 {
+    if (data->space->size) {
+        uint64_t index;
+
+        if (next_index(data, &index) != 0)
+            return -1;
+
+        if (data->exhausted) {
+            if (!data->pending_len && finish(data) != 0)
+                return -1;
+
+            flow->status = HFLOW_WAIT;
+            return 0;
+        }
+
+        if (data->pending_len == data->pending_cap) {
+            if (array_grow(&data->pending, &data->pending_cap,
+                           sizeof(*data->pending)) != 0)
+            {
+                search_error("Could not grow pending point list");
+                return -1;
+            }
+        }
+
+        if (hspace_unrank(data->space, index % data->space->size,
+                          point) != 0)
+        {
+            search_error("Could not make point from index during generate");
+            return -1;
+        }
+        point->id = data->next_id;
+
+        data->pending[data->pending_len].id = point->id;
+        data->pending[data->pending_len].index = index;
+        ++data->pending_len;
+        ++data->next_id;
+
+        flow->status = HFLOW_ACCEPT;
+        return 0;
+    }
+
     if (data->remaining_passes > 0) {
         if (make_next_point(data, point) != 0) {
             search_error("Could not make point from index during generate");
@@ -198,6 +321,37 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
             return -1;
         }
     }
+    else if (data->space->size) {
+        int idx;
+        for (idx = 0; idx < data->pending_len; ++idx) {
+            if (data->pending[idx].id == point->id)
+                break;
+        }
+        if (idx == data->pending_len) {
+            search_error("Could not find rejected point");
+            return -1;
+        }
+
+        uint64_t index;
+        if (next_index(data, &index) != 0)
+            return -1;
+
+        unsigned id = point->id;
+        if (!data->exhausted) {
+            if (hspace_unrank(data->space, index % data->space->size,
+                              point) != 0)
+            {
+                search_error("Could not make point from index during reject");
+                return -1;
+            }
+            data->pending[idx].index = index;
+        }
+        else if (!data->best.id || hpoint_copy(point, &data->best) != 0) {
+            search_error("No points remain to replace rejected point");
+            return -1;
+        }
+        point->id = id;
+    }
     else {
         if (make_next_point(data, point) != 0) {
             search_error("Could not make point from index during reject");
@@ -226,6 +380,26 @@ int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
         }
     }
 
+    if (data->space->size) {
+        for (int i = 0; i < data->pending_len; ++i) {
+            if (data->pending[i].id == trial->point.id) {
+                data->pending[i] = data->pending[--data->pending_len];
+                break;
+            }
+        }
+
+        if (data->exhausted && !data->pending_len)
+            return finish(data);
+
+        // Keep the state file current, so that our ranges are not
+        // mistaken for abandoned ones.
+        //
+        if (data->fp && time(NULL) - data->synced >= data->timeout / 4)
+            return sync_ranges(data, 0);
+
+        return 0;
+    }
+
     if (trial->point.id == data->final_id) {
         if (search_setcfg(CFGKEY_CONVERGED, "1") != 0) {
             search_error("Could not set convergence status");
@@ -270,6 +444,13 @@ int strategy_best(hplugin_data_t* data, hpoint_t* point)
  */
 int strategy_fini(hplugin_data_t* data)
 {
+    if (data->fp) {
+        release_ranges(data);
+        fclose(data->fp);
+    }
+    free(data->range);
+    free(data->pending);
+
     free(data->wrap);
     free(data->next);
     free(data->head);
@@ -286,6 +467,7 @@ int strategy_fini(hplugin_data_t* data)
 int config_strategy(hplugin_data_t* data)
 {
     const char* cfgstr;
+    uint64_t start = 0;
 
     data->remaining_passes = hcfg_int(search_cfg, CFGKEY_PASSES);
     if (data->remaining_passes < 0) {
@@ -295,7 +477,7 @@ int config_strategy(hplugin_data_t* data)
 
     cfgstr = hcfg_get(search_cfg, CFGKEY_INIT_POINT);
     if (cfgstr) {
-        hpoint_t init;
+        hpoint_t init = HPOINT_INITIALIZER;
 
         if (hpoint_parse(&init, cfgstr, data->space) != 0) {
             search_error("Error parsing point from " CFGKEY_INIT_POINT);
@@ -314,11 +496,27 @@ int config_strategy(hplugin_data_t* data)
             else
                 data->head[i].value = init.term[i].value.r;
         }
+
+        if (data->space->size && hspace_rank(data->space, &init,
+                                             &start) != 0)
+        {
+            search_error("Could not index initial point");
+            return -1;
+        }
         hpoint_fini(&init);
     }
     else {
         memset(data->head, 0, data->space->len * sizeof(*data->head));
     }
+
+    if (data->space->size)
+        return config_ranges(data, start);
+
+    if (hcfg_get(search_cfg, CFGKEY_EXHAUSTIVE_STATE)) {
+        search_error(CFGKEY_EXHAUSTIVE_STATE " requires a finite "
+                     "search space");
+        return -1;
+    }
     return 0;
 }
 
@@ -371,3 +569,407 @@ int make_next_point(hplugin_data_t* data, hpoint_t* point)
     point->len = data->space->len;
     return 0;
 }
+
+/*
+ * Prepare to enumerate indexes [start, total), where each pass
+ * through the search space adds its size to the total.  Without a
+ * state file, this session owns the entire range.
+ */
+int config_ranges(hplugin_data_t* data, uint64_t start)
+{
+    uint64_t passes = data->remaining_passes;
+
+    if (passes && data->space->size > UINT64_MAX / passes) {
+        search_error("Too many passes through the search space");
+        return -1;
+    }
+    data->total = passes * data->space->size;
+
+    data->block = hcfg_int(search_cfg, CFGKEY_EXHAUSTIVE_BLOCK);
+    if (data->block < 1) {
+        search_error("Configuration key " CFGKEY_EXHAUSTIVE_BLOCK
+                     " must be positive");
+        return -1;
+    }
+
+    data->timeout = hcfg_int(search_cfg, CFGKEY_EXHAUSTIVE_TIMEOUT);
+    if (data->timeout < 1) {
+        search_error("Configuration key " CFGKEY_EXHAUSTIVE_TIMEOUT
+                     " must be positive");
+        return -1;
+    }
+
+    // Release the ranges of any previous search before starting anew.
+    if (data->fp) {
+        release_ranges(data);
+        fclose(data->fp);
+        data->fp = NULL;
+    }
+    data->range_len = 0;
+    data->pending_len = 0;
+    data->block_next = 0;
+    data->block_end = 0;
+    data->exhausted = 0;
+
+    gethostname(data->host, sizeof(data->host));
+    data->host[sizeof(data->host) - 1] = '\0';
+    for (char* ptr = data->host; *ptr; ++ptr) {
+        if (*ptr == ':' || *ptr == ' ')
+            *ptr = '_';
+    }
+    snprintf(data->owner, sizeof(data->owner), "%s:%ld:%p",
+             data->host, (long) getpid(), (void*) data);
+
+    const char* filename = hcfg_get(search_cfg, CFGKEY_EXHAUSTIVE_STATE);
+    if (!filename) {
+        if (start < data->total)
+            return add_range(data, OWNER_FREE, start, data->total);
+        return 0;
+    }
+
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd == -1 || !(data->fp = fdopen(fd, "r+"))) {
+        search_error("Could not open " CFGKEY_EXHAUSTIVE_STATE " file");
+        if (fd != -1)
+            close(fd);
+        return -1;
+    }
+
+    // A new state file begins with a single unclaimed range.
+    if (lock_state(data) != 0)
+        return -1;
+
+    if (data->synced < 0 && start < data->total) {
+        if (add_range(data, OWNER_FREE, start, data->total) != 0)
+            return -1;
+    }
+    return unlock_state(data);
+}
+
+/*
+ * Reserve the next linear index for this session.  Sets the exhausted
+ * flag if no indexes remain.
+ */
+int next_index(hplugin_data_t* data, uint64_t* index)
+{
+    if (data->block_next == data->block_end) {
+        if (data->exhausted)
+            return 0;
+
+        if (sync_ranges(data, 1) != 0)
+            return -1;
+
+        if (data->block_next == data->block_end) {
+            data->exhausted = 1;
+            return 0;
+        }
+    }
+    *index = data->block_next++;
+    return 0;
+}
+
+/*
+ * Record the progress of this session's ranges, and optionally claim
+ * a new block of indexes.  When a state file is used, ranges are
+ * reloaded from (and written back to) the file under lock.
+ */
+int sync_ranges(hplugin_data_t* data, int claim)
+{
+    if (data->fp && lock_state(data) != 0)
+        return -1;
+
+    long now = (long) time(NULL);
+    for (int i = 0; i < data->range_len; ++i) {
+        range_t* range = &data->range[i];
+
+        if (strcmp(range->owner, data->owner) == 0) {
+            // Completed indexes end at our earliest pending point, or
+            // the first unused index of our current block.
+            //
+            range->done = range->next;
+            if (data->block_next < data->block_end &&
+                range->base <= data->block_next &&
+                data->block_next < range->done)
+                range->done = data->block_next;
+
+            for (int j = 0; j < data->pending_len; ++j) {
+                uint64_t index = data->pending[j].index;
+
+                if (range->base <= index && index < range->done)
+                    range->done = index;
+            }
+            range->stamp = now;
+        }
+
+        // Remove completed ranges.
+        if (range->done >= range->end) {
+            data->range[i--] = data->range[--data->range_len];
+            continue;
+        }
+    }
+
+    if (claim && claim_range(data, now) != 0)
+        return -1;
+
+    if (data->fp)
+        return unlock_state(data);
+    return 0;
+}
+
+/*
+ * Reserve a block of indexes for this session.  Blocks are taken from
+ * a range we own, an unclaimed or abandoned range, or from the upper
+ * half of another session's range, in that order of preference.
+ */
+int claim_range(hplugin_data_t* data, long now)
+{
+    int idx;
+    range_t* range;
+
+    for (idx = 0; idx < data->range_len; ++idx) {
+        range = &data->range[idx];
+        if (strcmp(range->owner, data->owner) == 0 &&
+            range->next < range->end)
+            break;
+    }
+
+    if (idx == data->range_len) {
+        for (idx = 0; idx < data->range_len; ++idx) {
+            range = &data->range[idx];
+            if (strcmp(range->owner, OWNER_FREE) == 0 &&
+                range->next < range->end)
+                break;
+        }
+    }
+
+    if (idx == data->range_len) {
+        for (idx = 0; idx < data->range_len; ++idx) {
+            range = &data->range[idx];
+            if (abandoned(data, range, now)) {
+                range->next = range->done;
+                break;
+            }
+        }
+    }
+
+    if (idx == data->range_len) {
+        // Steal half of the largest unreserved remainder.
+        int victim = -1;
+        uint64_t most = 0;
+
+        for (int i = 0; i < data->range_len; ++i) {
+            range = &data->range[i];
+            if (most < range->end - range->next) {
+                most = range->end - range->next;
+                victim = i;
+            }
+        }
+        if (victim < 0)
+            return 0; // No work remains.
+
+        range = &data->range[victim];
+        uint64_t split = range->end - (most + 1) / 2;
+        uint64_t end = range->end;
+
+        range->end = split;
+        if (add_range(data, data->owner, split, end) != 0)
+            return -1;
+    }
+
+    range = &data->range[idx];
+    snprintf(range->owner, sizeof(range->owner), "%s", data->owner);
+    range->stamp = now;
+
+    data->block_next = range->next;
+    data->block_end = range->next + data->block;
+    if (data->block_end > range->end || data->block_end < range->next)
+        data->block_end = range->end;
+    range->next = data->block_end;
+
+    return 0;
+}
+
+int add_range(hplugin_data_t* data, const char* owner,
+              uint64_t base, uint64_t end)
+{
+    if (data->range_len == data->range_cap) {
+        if (array_grow(&data->range, &data->range_cap,
+                       sizeof(*data->range)) != 0)
+        {
+            search_error("Could not grow range list");
+            return -1;
+        }
+    }
+
+    range_t* range = &data->range[data->range_len++];
+    snprintf(range->owner, sizeof(range->owner), "%s", owner);
+    range->stamp = (long) time(NULL);
+    range->base = base;
+    range->done = base;
+    range->next = base;
+    range->end = end;
+
+    return 0;
+}
+
+/*
+ * A range is abandoned if its owner has not updated it recently, or
+ * if the owner was a process on this host which no longer exists.
+ */
+int abandoned(hplugin_data_t* data, const range_t* range, long now)
+{
+    char host[sizeof(data->host)];
+    long pid;
+
+    if (strcmp(range->owner, OWNER_FREE) == 0 ||
+        strcmp(range->owner, data->owner) == 0)
+        return 0;
+
+    if (now - range->stamp > data->timeout)
+        return 1;
+
+    if (sscanf(range->owner, "%63[^:]:%ld", host, &pid) == 2 &&
+        strcmp(host, data->host) == 0 &&
+        kill((pid_t) pid, 0) != 0 && errno == ESRCH)
+        return 1;
+
+    return 0;
+}
+
+/*
+ * Return the unfinished portion of our ranges to the state file, so
+ * other sessions may claim them.
+ */
+void release_ranges(hplugin_data_t* data)
+{
+    if (data->fp && sync_ranges(data, 0) == 0 && lock_state(data) == 0) {
+        for (int i = 0; i < data->range_len; ++i) {
+            range_t* range = &data->range[i];
+
+            if (strcmp(range->owner, data->owner) == 0) {
+                snprintf(range->owner, sizeof(range->owner), OWNER_FREE);
+                range->next = range->done;
+            }
+        }
+        unlock_state(data);
+    }
+}
+
+/*
+ * Lock the state file, and load the list of ranges from it.  An empty
+ * file yields an empty list, and sets the synced time to -1.
+ */
+int lock_state(hplugin_data_t* data)
+{
+    struct flock lock = {0};
+
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    while (fcntl(fileno(data->fp), F_SETLKW, &lock) != 0) {
+        if (errno != EINTR) {
+            search_error("Could not lock " CFGKEY_EXHAUSTIVE_STATE " file");
+            return -1;
+        }
+    }
+
+    rewind(data->fp);
+    data->range_len = 0;
+    data->synced = 0;
+
+    uint64_t hash, total;
+    int count = fscanf(data->fp, " exhaustive %" SCNx64 " %" SCNu64,
+                       &hash, &total);
+    if (count == EOF) {
+        data->synced = -1;
+        return 0;
+    }
+
+    if (count != 2 || hash != hspace_hash(data->space) ||
+        total != data->total)
+    {
+        search_error(CFGKEY_EXHAUSTIVE_STATE " file does not match "
+                     "this search");
+        drop_lock(data);
+        return -1;
+    }
+
+    range_t range;
+    while ((count = fscanf(data->fp, " %127s %ld %" SCNu64 " %" SCNu64
+                           " %" SCNu64 " %" SCNu64, range.owner,
+                           &range.stamp, &range.base, &range.done,
+                           &range.next, &range.end)) == 6)
+    {
+        if (add_range(data, range.owner, range.base, range.end) != 0) {
+            drop_lock(data);
+            return -1;
+        }
+        data->range[data->range_len - 1] = range;
+    }
+
+    if (count != EOF) {
+        search_error("Invalid range in " CFGKEY_EXHAUSTIVE_STATE " file");
+        drop_lock(data);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Write the list of ranges to the state file, and release the lock.
+ */
+int unlock_state(hplugin_data_t* data)
+{
+    int retval = 0;
+
+    rewind(data->fp);
+    fprintf(data->fp, "exhaustive %016" PRIx64 " %" PRIu64 "\n",
+            hspace_hash(data->space), data->total);
+
+    for (int i = 0; i < data->range_len; ++i) {
+        range_t* range = &data->range[i];
+
+        fprintf(data->fp, "%s %ld %" PRIu64 " %" PRIu64 " %" PRIu64
+                " %" PRIu64 "\n", range->owner, range->stamp,
+                range->base, range->done, range->next, range->end);
+    }
+
+    if (fflush(data->fp) != 0 ||
+        ftruncate(fileno(data->fp), ftell(data->fp)) != 0)
+    {
+        search_error("Could not write " CFGKEY_EXHAUSTIVE_STATE " file");
+        retval = -1;
+    }
+    data->synced = (long) time(NULL);
+
+    drop_lock(data);
+    return retval;
+}
+
+/*
+ * Release the state file lock without writing to the file.  Used when
+ * the file belongs to another search or cannot be parsed, so that it
+ * is left exactly as it was found.
+ */
+void drop_lock(hplugin_data_t* data)
+{
+    struct flock lock = {0};
+
+    lock.l_type = F_UNLCK;
+    lock.l_whence = SEEK_SET;
+    fcntl(fileno(data->fp), F_SETLK, &lock);
+}
+
+/*
+ * All indexes available to this session have been evaluated.
+ */
+int finish(hplugin_data_t* data)
+{
+    if (data->fp && sync_ranges(data, 0) != 0)
+        return -1;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "1") != 0) {
+        search_error("Could not set convergence status");
+        return -1;
+    }
+    return 0;
+}
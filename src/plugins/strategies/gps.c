@@ -0,0 +1,800 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page gps Pattern Search (gps.so)
+ *
+ * This search strategy implements a generalized pattern search in the
+ * style of Hooke and Jeeves.  Starting from a center point, each poll
+ * evaluates the 2N neighbors found by stepping up and down along each
+ * of the N search space dimensions.  Since the neighbors do not depend
+ * on each other, a poll is handed out to as many clients as are
+ * available.  Once every point in the poll has been evaluated, the
+ * center moves to the best point found.  After a successful move, the
+ * next poll also includes a pattern point which repeats the move.  If
+ * no point improves upon the center, every step size is halved.  The
+ * search converges when no step can be reduced any further.
+ *
+ * Integer, enumerated, and stepped real dimensions are searched over
+ * the index of their values, so every poll point is a valid point of
+ * the search space and no rounding is involved.  Steps in these
+ * dimensions start at GPS_STEP times the number of values, and never
+ * drop below a single value.  Continuous real dimensions use steps
+ * relative to their range, down to SIZE_TOL times the range.
+ *
+ * Points which were already evaluated, including those reported by
+ * other strategies, are remembered and never tested twice.  Points
+ * which are clamped onto the search space boundary, and so coincide
+ * with another poll point, are only tested once.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+
+#include <stdlib.h>
+#include <string.h> // For memcpy().
+#include <math.h>   // For floor() and HUGE_VAL.
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_INIT_POINT, NULL,
+      "Center point of the first poll.  The middle of the search space "
+      "is used by default." },
+    { CFGKEY_GPS_STEP, "0.25",
+      "Initial step size, as a fraction of each dimension's range." },
+    { CFGKEY_SIZE_TOL, NULL,
+      "Smallest step size in continuous real dimensions, as a fraction "
+      "of the dimension's range.  Defaults to 0.005." },
+    { NULL }
+};
+
+typedef enum poll_state {
+    POLL_UNSENT,
+    POLL_SENT,
+    POLL_DONE
+} poll_state_t;
+
+/*
+ * A single point of the current poll, in lattice coordinates.
+ */
+typedef struct poll {
+    double*      coord;
+    unsigned     id;
+    poll_state_t state;
+    double       perf;
+} poll_t;
+
+/*
+ * Structure to hold data for an individual pattern search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    hspace_t* space;
+    hpoint_t  best;
+    hperf_t   best_perf;
+    unsigned  next_id;
+    int       converged;
+
+    // Configuration variables.
+    double    init_step;
+    double    size_tol;
+
+    // Search state, in lattice coordinates.  Finite dimensions hold a
+    // value index, and continuous real dimensions hold the value.
+    double*   vec;
+    double*   lower;
+    double*   upper;
+    double*   step;
+    double*   min_step;
+    double*   center;
+    double*   prev;
+    double*   coord;
+    double    center_perf;
+    int       anchored;
+    int       moved;
+
+    poll_t*   poll;
+    double*   poll_buf;
+    int       poll_len, poll_cap;
+    int       poll_done;
+
+    // Open-addressing hash map of evaluated points.
+    double*   memo_coord;
+    double*   memo_perf;
+    int       memo_len, memo_cap;
+    int*      hash;
+    int       hash_cap;
+
+    hpoint_t  point;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int      config_strategy(hplugin_data_t* data);
+static int      alloc_state(hplugin_data_t* data);
+static void     to_coord(hplugin_data_t* data, const hpoint_t* point,
+                         double* coord);
+static int      to_point(hplugin_data_t* data, const double* coord,
+                         hpoint_t* point);
+static void     build_poll(hplugin_data_t* data);
+static void     add_poll(hplugin_data_t* data, const double* coord);
+static int      finish_poll(hplugin_data_t* data);
+static int      contract(hplugin_data_t* data);
+static int      next_entry(hplugin_data_t* data);
+static int      find_entry(hplugin_data_t* data, unsigned id);
+static int      same(hplugin_data_t* data, const double* a, const double* b);
+static int      memo_find(hplugin_data_t* data, const double* coord);
+static int      memo_add(hplugin_data_t* data, const double* coord,
+                         double perf);
+static unsigned memo_hash(hplugin_data_t* data, const double* coord);
+static int      memo_slot(hplugin_data_t* data, const double* coord);
+static int      memo_rehash(hplugin_data_t* data, int len);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->next_id = 1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    data->space = space;
+    if (alloc_state(data) != 0)
+        return -1;
+
+    if (config_strategy(data) != 0)
+        return -1;
+
+    data->center_perf = HUGE_VAL;
+    data->anchored = 0;
+    data->moved = 0;
+    data->memo_len = 0;
+    if (memo_rehash(data, 0) != 0) {
+        search_error("Could not initialize evaluated point map");
+        return -1;
+    }
+    build_poll(data);
+    data->converged = 0;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = next_entry(data);
+    if (data->converged || idx < 0) {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    poll_t* entry = &data->poll[idx];
+    if (to_point(data, entry->coord, point) != 0) {
+        search_error("Could not make point from poll entry");
+        return -1;
+    }
+    entry->id = data->next_id++;
+    entry->state = POLL_SENT;
+    point->id = entry->id;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    unsigned id = point->id;
+    int idx = find_entry(data, id);
+
+    if (flow->point.id) {
+        hpoint_t* hint = &flow->point;
+
+        hint->id = id;
+        if (idx >= 0)
+            to_coord(data, hint, data->poll[idx].coord);
+
+        if (hpoint_copy(point, hint) != 0) {
+            search_error("Could not return hint during reject");
+            return -1;
+        }
+    }
+    else {
+        // Treat the invalid point as an evaluation failure, and send
+        // the next untested point in its place.
+        if (idx >= 0) {
+            poll_t* entry = &data->poll[idx];
+
+            entry->state = POLL_DONE;
+            entry->perf = HUGE_VAL;
+            ++data->poll_done;
+            if (memo_add(data, entry->coord, HUGE_VAL) != 0)
+                return -1;
+
+            if (finish_poll(data) != 0)
+                return -1;
+        }
+
+        // Nothing is left to test until the poll completes.  Sending
+        // the center again could be rejected again, so wait instead.
+        idx = next_entry(data);
+        if (data->converged || idx < 0) {
+            flow->status = HFLOW_WAIT;
+            return 0;
+        }
+
+        poll_t* entry = &data->poll[idx];
+        if (to_point(data, entry->coord, point) != 0) {
+            search_error("Could not make point from poll entry");
+            return -1;
+        }
+        entry->id = id;
+        entry->state = POLL_SENT;
+        point->id = id;
+    }
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    if (hperf_cmp(&data->best_perf, &trial->perf) > 0) {
+        if (hperf_copy(&data->best_perf, &trial->perf) != 0) {
+            search_error("Could not store best performance");
+            return -1;
+        }
+
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point during analyze");
+            return -1;
+        }
+    }
+
+    double perf = hperf_unify(&trial->perf);
+    to_coord(data, &trial->point, data->coord);
+    if (memo_add(data, data->coord, perf) != 0)
+        return -1;
+
+    if (data->converged)
+        return 0;
+
+    // Complete the poll entry this trial was sent for, along with any
+    // untested entries for the same point.
+    for (int i = 0; i < data->poll_len; ++i) {
+        poll_t* entry = &data->poll[i];
+
+        if (entry->state == POLL_DONE)
+            continue;
+
+        if ((entry->state == POLL_SENT && entry->id == trial->point.id) ||
+            same(data, entry->coord, data->coord))
+        {
+            entry->state = POLL_DONE;
+            entry->perf = perf;
+            ++data->poll_done;
+        }
+    }
+    return finish_poll(data);
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point during request for best");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    free(data->hash);
+    free(data->memo_perf);
+    free(data->memo_coord);
+    free(data->poll_buf);
+    free(data->poll);
+    free(data->vec);
+
+    hpoint_fini(&data->point);
+    hperf_fini(&data->best_perf);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    data->init_step = hcfg_real(search_cfg, CFGKEY_GPS_STEP);
+    if (!(data->init_step > 0.0 && data->init_step <= 1.0)) {
+        search_error("Configuration key " CFGKEY_GPS_STEP
+                     " must be within the range (0, 1]");
+        return -1;
+    }
+
+    data->size_tol = 0.005;
+    if (hcfg_get(search_cfg, CFGKEY_SIZE_TOL)) {
+        data->size_tol = hcfg_real(search_cfg, CFGKEY_SIZE_TOL);
+        if (!(data->size_tol > 0.0 && data->size_tol <= 1.0)) {
+            search_error("Configuration key " CFGKEY_SIZE_TOL
+                         " must be within the range (0, 1]");
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < data->space->len; ++i) {
+        hrange_t* dim = &data->space->dim[i];
+        double range;
+
+        if (hrange_finite(dim)) {
+            data->lower[i] = 0.0;
+            data->upper[i] = hrange_limit(dim) - 1.0;
+            range = data->upper[i];
+
+            data->step[i] = floor(data->init_step * range + 0.5);
+            data->min_step[i] = 1.0;
+            if (data->step[i] < 1.0)
+                data->step[i] = 1.0;
+        }
+        else {
+            data->lower[i] = dim->bounds.r.min;
+            data->upper[i] = dim->bounds.r.max;
+            range = data->upper[i] - data->lower[i];
+
+            data->step[i] = data->init_step * range;
+            data->min_step[i] = data->size_tol * range;
+            if (data->step[i] < data->min_step[i])
+                data->step[i] = data->min_step[i];
+        }
+
+        // Dimensions with a single value are never stepped.
+        if (!(range > 0.0))
+            data->step[i] = data->min_step[i] = 0.0;
+
+        if (hrange_finite(dim))
+            data->center[i] = floor(range / 2);
+        else
+            data->center[i] = data->lower[i] + range / 2;
+    }
+
+    const char* cfgval = hcfg_get(search_cfg, CFGKEY_INIT_POINT);
+    if (cfgval) {
+        if (hpoint_parse(&data->point, cfgval, data->space) != 0) {
+            search_error("Error parsing point from " CFGKEY_INIT_POINT);
+            return -1;
+        }
+
+        data->point.id = 1;
+        if (hpoint_align(&data->point, data->space) != 0) {
+            search_error("Could not align initial point to search space");
+            return -1;
+        }
+        to_coord(data, &data->point, data->center);
+    }
+    return 0;
+}
+
+int alloc_state(hplugin_data_t* data)
+{
+    int len = data->space->len;
+    int cap = 2 * len + 2;
+
+    double* vec = realloc(data->vec, 7 * len * sizeof(*vec));
+    if (!vec) {
+        search_error("Could not allocate pattern search state");
+        return -1;
+    }
+    data->vec      = vec;
+    data->lower    = vec + 0 * len;
+    data->upper    = vec + 1 * len;
+    data->step     = vec + 2 * len;
+    data->min_step = vec + 3 * len;
+    data->center   = vec + 4 * len;
+    data->prev     = vec + 5 * len;
+    data->coord    = vec + 6 * len;
+
+    poll_t* poll = realloc(data->poll, cap * sizeof(*poll));
+    if (!poll) {
+        search_error("Could not allocate poll list");
+        return -1;
+    }
+    data->poll = poll;
+
+    double* buf = realloc(data->poll_buf, cap * len * sizeof(*buf));
+    if (!buf) {
+        search_error("Could not allocate poll coordinates");
+        return -1;
+    }
+    data->poll_buf = buf;
+    data->poll_cap = cap;
+
+    for (int i = 0; i < cap; ++i)
+        data->poll[i].coord = data->poll_buf + i * len;
+
+    if (hpoint_init(&data->point, len) != 0) {
+        search_error("Could not initialize point structure");
+        return -1;
+    }
+    return 0;
+}
+
+void to_coord(hplugin_data_t* data, const hpoint_t* point, double* coord)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        hrange_t* dim = &data->space->dim[i];
+
+        if (hrange_finite(dim))
+            coord[i] = hrange_index(dim, &point->term[i]);
+        else
+            coord[i] = point->term[i].value.r;
+
+        if (coord[i] < data->lower[i]) coord[i] = data->lower[i];
+        if (coord[i] > data->upper[i]) coord[i] = data->upper[i];
+    }
+}
+
+int to_point(hplugin_data_t* data, const double* coord, hpoint_t* point)
+{
+    if (hpoint_init(point, data->space->len) != 0)
+        return -1;
+
+    for (int i = 0; i < data->space->len; ++i) {
+        hrange_t* dim = &data->space->dim[i];
+        hval_t* val = &point->term[i];
+
+        hval_fini(val);
+        if (hrange_finite(dim)) {
+            *val = hrange_value(dim, (unsigned long) coord[i]);
+        }
+        else {
+            *val = hval_zero;
+            val->type    = HVAL_REAL;
+            val->value.r = coord[i];
+        }
+    }
+    point->len = data->space->len;
+    return 0;
+}
+
+/*
+ * Fill the poll list with the neighbors of the current center point.
+ */
+void build_poll(hplugin_data_t* data)
+{
+    int len = data->space->len;
+    double* coord = data->coord;
+
+    data->poll_len = 0;
+    data->poll_done = 0;
+
+    if (!data->anchored)
+        add_poll(data, data->center);
+
+    // Repeat a successful move, Hooke-Jeeves style.
+    if (data->moved) {
+        for (int i = 0; i < len; ++i) {
+            coord[i] = 2 * data->center[i] - data->prev[i];
+            if (coord[i] < data->lower[i]) coord[i] = data->lower[i];
+            if (coord[i] > data->upper[i]) coord[i] = data->upper[i];
+        }
+        add_poll(data, coord);
+    }
+
+    for (int i = 0; i < len; ++i) {
+        if (!(data->step[i] > 0.0))
+            continue;
+
+        memcpy(coord, data->center, len * sizeof(*coord));
+        coord[i] = data->center[i] - data->step[i];
+        if (coord[i] < data->lower[i]) coord[i] = data->lower[i];
+        add_poll(data, coord);
+
+        coord[i] = data->center[i] + data->step[i];
+        if (coord[i] > data->upper[i]) coord[i] = data->upper[i];
+        add_poll(data, coord);
+    }
+}
+
+void add_poll(hplugin_data_t* data, const double* coord)
+{
+    if (data->anchored && same(data, coord, data->center))
+        return;
+
+    for (int i = 0; i < data->poll_len; ++i) {
+        if (same(data, coord, data->poll[i].coord))
+            return;
+    }
+
+    poll_t* entry = &data->poll[data->poll_len++];
+    memcpy(entry->coord, coord, data->space->len * sizeof(*coord));
+    entry->id = 0;
+
+    int idx = memo_find(data, coord);
+    if (idx >= 0) {
+        entry->state = POLL_DONE;
+        entry->perf = data->memo_perf[idx];
+        ++data->poll_done;
+    }
+    else {
+        entry->state = POLL_UNSENT;
+        entry->perf = HUGE_VAL;
+    }
+}
+
+/*
+ * Move the center or contract the step sizes once every point of the
+ * current poll has been evaluated.
+ */
+int finish_poll(hplugin_data_t* data)
+{
+    int len = data->space->len;
+
+    while (!data->converged && data->poll_done == data->poll_len) {
+        int best = -1;
+        double best_perf = data->center_perf;
+
+        for (int i = 0; i < data->poll_len; ++i) {
+            if (best_perf > data->poll[i].perf) {
+                best_perf = data->poll[i].perf;
+                best = i;
+            }
+        }
+
+        if (best >= 0 && !same(data, data->poll[best].coord, data->center)) {
+            memcpy(data->prev, data->center, len * sizeof(*data->prev));
+            memcpy(data->center, data->poll[best].coord,
+                   len * sizeof(*data->center));
+            data->center_perf = best_perf;
+            data->moved = 1;
+        }
+        else {
+            if (best >= 0)
+                data->center_perf = best_perf;
+            data->moved = 0;
+
+            if (!contract(data)) {
+                data->converged = 1;
+                if (search_setcfg(CFGKEY_CONVERGED, "1") != 0) {
+                    search_error("Could not set " CFGKEY_CONVERGED
+                                 " config variable");
+                    return -1;
+                }
+                break;
+            }
+        }
+        data->anchored = 1;
+        build_poll(data);
+    }
+    return 0;
+}
+
+/*
+ * Halve every step size.  Returns 0 if no step could be reduced.
+ */
+int contract(hplugin_data_t* data)
+{
+    int changed = 0;
+
+    for (int i = 0; i < data->space->len; ++i) {
+        double step = data->step[i] / 2;
+
+        if (hrange_finite(&data->space->dim[i]))
+            step = floor(step);
+        if (step < data->min_step[i])
+            step = data->min_step[i];
+
+        if (data->step[i] != step) {
+            data->step[i] = step;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+int next_entry(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->poll_len; ++i) {
+        if (data->poll[i].state == POLL_UNSENT)
+            return i;
+    }
+    return -1;
+}
+
+int find_entry(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->poll_len; ++i) {
+        if (data->poll[i].state == POLL_SENT && data->poll[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+int same(hplugin_data_t* data, const double* a, const double* b)
+{
+    for (int i = 0; i < data->space->len; ++i) {
+        if (a[i] != b[i])
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Return the index of an evaluated point, or -1 if it is unknown.
+ */
+int memo_find(hplugin_data_t* data, const double* coord)
+{
+    return data->hash[ memo_slot(data, coord) ];
+}
+
+/*
+ * Remember the performance of an evaluated point.  Only the first
+ * report for each point is kept.
+ */
+int memo_add(hplugin_data_t* data, const double* coord, double perf)
+{
+    int len = data->space->len;
+
+    if (memo_find(data, coord) >= 0)
+        return 0;
+
+    if (data->memo_len == data->memo_cap) {
+        int cap = data->memo_cap;
+
+        if (array_grow(&data->memo_perf, &cap,
+                       sizeof(*data->memo_perf)) != 0)
+        {
+            search_error("Could not grow evaluated point list");
+            return -1;
+        }
+
+        double* buf = realloc(data->memo_coord,
+                              cap * len * sizeof(*buf));
+        if (!buf) {
+            search_error("Could not grow evaluated point list");
+            return -1;
+        }
+        data->memo_coord = buf;
+        data->memo_cap = cap;
+    }
+
+    // Keep the hash map at most half full.
+    if (2 * (data->memo_len + 1) > data->hash_cap) {
+        if (memo_rehash(data, data->memo_len + 1) != 0) {
+            search_error("Could not extend evaluated point map");
+            return -1;
+        }
+    }
+
+    int idx = data->memo_len++;
+    memcpy(data->memo_coord + idx * len, coord, len * sizeof(*coord));
+    data->memo_perf[idx] = perf;
+    data->hash[ memo_slot(data, coord) ] = idx;
+    return 0;
+}
+
+unsigned memo_hash(hplugin_data_t* data, const double* coord)
+{
+    unsigned hash = 2166136261u;
+
+    for (int i = 0; i < data->space->len; ++i) {
+        double val = coord[i];
+        unsigned char byte[sizeof(val)];
+
+        if (val == 0.0)
+            val = 0.0; // Negative zero must hash like positive zero.
+        memcpy(byte, &val, sizeof(val));
+
+        for (size_t j = 0; j < sizeof(val); ++j) {
+            hash ^= byte[j];
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+/*
+ * Return the hash map slot which holds the given point, or the empty
+ * slot where it would be inserted.
+ */
+int memo_slot(hplugin_data_t* data, const double* coord)
+{
+    int len = data->space->len;
+    unsigned mask = data->hash_cap - 1;
+    unsigned slot = memo_hash(data, coord) & mask;
+
+    while (data->hash[slot] != -1) {
+        if (same(data, data->memo_coord + data->hash[slot] * len, coord))
+            break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * (Re)build the hash map so that it may hold at least len points.
+ */
+int memo_rehash(hplugin_data_t* data, int len)
+{
+    int cap = data->hash_cap ? data->hash_cap : 64;
+    while (cap < 2 * len)
+        cap *= 2;
+
+    if (cap != data->hash_cap) {
+        int* newbuf = realloc(data->hash, cap * sizeof(*newbuf));
+        if (!newbuf)
+            return -1;
+
+        data->hash = newbuf;
+        data->hash_cap = cap;
+    }
+
+    for (int i = 0; i < data->hash_cap; ++i)
+        data->hash[i] = -1;
+
+    for (int i = 0; i < data->memo_len; ++i) {
+        double* coord = data->memo_coord + i * data->space->len;
+        data->hash[ memo_slot(data, coord) ] = i;
+    }
+    return 0;
+}
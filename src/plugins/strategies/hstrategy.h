@@ -55,6 +55,14 @@ int strategy_best(hplugin_data_t* data, hpoint_t* point);
 int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point);
 int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point);
 
+/*
+ * A strategy without a replacement for a rejected point may set
+ * flow->status to HFLOW_WAIT in strategy_rejected().  Session-core
+ * then releases the trial.  The rejected point is dropped, its
+ * pending slot is freed, and it never reaches strategy_analyze().
+ * New points are requested through strategy_generate() as usual.
+ */
+
 /*
  * The following functions are optional.
  *
@@ -0,0 +1,552 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page hyperband Hyperband (hyperband.so)
+ *
+ * This search strategy implements an asynchronous variant of
+ * Hyperband, a multi-fidelity search built on successive halving.
+ * Most configurations are evaluated with only a fraction of the full
+ * evaluation budget, and only the most promising survivors are
+ * promoted to larger budgets.  Clients retrieve the budget of each
+ * fetched point with ah_get_budget(), and should scale their problem
+ * size, iteration count, or time limit accordingly.
+ *
+ * Each successive halving _bracket_ consists of a series of _rungs_,
+ * where the budget grows by a factor of HYPERBAND_ETA from one rung
+ * to the next, and the final rung uses the full budget.  Whenever a
+ * point is requested, the strategy looks for a configuration in the
+ * top 1/HYPERBAND_ETA of any rung that has not yet been promoted, and
+ * re-issues it with the budget of the next rung.  Otherwise, a new
+ * random configuration is started in the lowest rung of a bracket.
+ * No rung waits for others to complete, so points are always
+ * available.
+ *
+ * Hyperband hedges against budgets too small to be informative by
+ * running several brackets, each beginning at a different budget.
+ * New configurations are distributed among brackets in the same
+ * proportion as the original (synchronous) algorithm.
+ *
+ * Performance reported for partial budgets is only compared within a
+ * rung.  The best point is the best configuration evaluated with the
+ * largest budget thus far.  This search will never reach a converged
+ * state.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+
+#include <stdlib.h>
+#include <string.h> // For memmove().
+#include <math.h>   // For pow(), log(), and isnan().
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_HYPERBAND_ETA, "3",
+      "Reduction factor between rungs.  Only the top 1/ETA of the "
+      "configurations in each rung are promoted to the next rung, "
+      "with ETA times the budget." },
+    { CFGKEY_HYPERBAND_MIN_BUDGET, "0.01",
+      "Smallest fraction of the full evaluation budget a configuration "
+      "may be evaluated with." },
+    { CFGKEY_HYPERBAND_BRACKETS, "0",
+      "Number of brackets to run, beginning with the bracket of "
+      "smallest initial budget.  A value of 1 reduces the search to "
+      "successive halving.  A value of 0 runs all brackets." },
+    { NULL }
+};
+
+/*
+ * A completed evaluation within a rung.
+ */
+typedef struct entry {
+    int    cfg;
+    double perf;
+    int    promoted;
+} entry_t;
+
+/*
+ * A rung holds its completed evaluations in order of performance.
+ */
+typedef struct rung {
+    entry_t* entry;
+    int      len, cap;
+    double   budget;
+} rung_t;
+
+typedef struct bracket {
+    rung_t* rung;
+    int     len;
+    double  share;   // Number of configurations started per round.
+    int     started; // Number of configurations started thus far.
+} bracket_t;
+
+typedef struct config {
+    hpoint_t point;
+    int      bracket;
+} config_t;
+
+/*
+ * A point under evaluation: configuration cfg, evaluated in rung
+ * number rung of its bracket.
+ */
+typedef struct pending {
+    unsigned id;
+    int      cfg;
+    int      rung;
+} pending_t;
+
+/*
+ * Structure to hold data for an individual Hyperband search instance.
+ *
+ * To support multiple parallel search instances, no global variables
+ * should be defined or used in this plug-in layer.  They should
+ * instead be defined as a part of this structure.
+ */
+struct hplugin_data {
+    hspace_t* space;
+    hpoint_t  best;
+    double    best_perf;
+    double    best_budget;
+    unsigned  next_id;
+
+    // Configuration variables.
+    double     eta;
+
+    // Search state.
+    bracket_t* bracket;
+    int        bracket_len;
+
+    config_t*  config;
+    int        config_len, config_cap;
+
+    pending_t* pending;
+    int        pending_len, pending_cap;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int  config_strategy(hplugin_data_t* data);
+static void free_brackets(hplugin_data_t* data);
+static int  find_promotion(hplugin_data_t* data, int* b, int* k, int* j);
+static int  new_config(hplugin_data_t* data);
+static int  issue_point(hplugin_data_t* data, pending_t* pend,
+                        hpoint_t* point);
+static int  add_entry(rung_t* rung, int cfg, double perf);
+static int  find_pending(hplugin_data_t* data, unsigned id);
+static void randomize(hplugin_data_t* data, hpoint_t* point);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->next_id = 1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    data->space = space;
+    if (config_strategy(data) != 0)
+        return -1;
+
+    data->best.id = 0;
+    data->best_perf = HUGE_VAL;
+    data->best_budget = 0.0;
+    data->config_len = 0;
+    data->pending_len = 0;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    if (data->pending_len == data->pending_cap) {
+        if (array_grow(&data->pending, &data->pending_cap,
+                       sizeof(*data->pending)) != 0)
+        {
+            search_error("Could not grow pending point list");
+            return -1;
+        }
+    }
+    pending_t* pend = &data->pending[data->pending_len];
+
+    int b = 0, k = 0, j = 0;
+    if (find_promotion(data, &b, &k, &j)) {
+        // Re-issue a promising configuration with a larger budget.
+        entry_t* entry = &data->bracket[b].rung[k].entry[j];
+
+        entry->promoted = 1;
+        pend->cfg = entry->cfg;
+        pend->rung = k + 1;
+    }
+    else {
+        pend->cfg = new_config(data);
+        if (pend->cfg < 0)
+            return -1;
+
+        randomize(data, &data->config[pend->cfg].point);
+        pend->rung = 0;
+    }
+
+    pend->id = data->next_id;
+    if (issue_point(data, pend, point) != 0)
+        return -1;
+
+    ++data->next_id;
+    ++data->pending_len;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = find_pending(data, point->id);
+    if (idx < 0) {
+        search_error("Could not find rejected point");
+        return -1;
+    }
+    pending_t* pend = &data->pending[idx];
+
+    // Promoted configurations have already been evaluated, so a
+    // rejection removes them from the search.  Either way, a new
+    // configuration takes the place of the rejected point.
+    //
+    if (pend->rung > 0) {
+        pend->cfg = new_config(data);
+        if (pend->cfg < 0)
+            return -1;
+        pend->rung = 0;
+    }
+    hpoint_t* cfg_point = &data->config[pend->cfg].point;
+
+    if (flow->point.id) {
+        if (hpoint_copy(cfg_point, &flow->point) != 0) {
+            search_error("Could not copy hint point during reject");
+            return -1;
+        }
+    }
+    else {
+        randomize(data, cfg_point);
+    }
+
+    if (issue_point(data, pend, point) != 0)
+        return -1;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    double perf = hperf_unify(&trial->perf);
+    double budget = trial->point.budget;
+
+    if (budget <= 0.0)
+        budget = 1.0;
+
+    // Only compare performance among points with equal budgets.
+    if (data->best_budget < budget ||
+        (data->best_budget == budget && data->best_perf > perf))
+    {
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point");
+            return -1;
+        }
+        data->best_perf = perf;
+        data->best_budget = budget;
+    }
+
+    int idx = find_pending(data, trial->point.id);
+    if (idx < 0)
+        return 0;
+
+    pending_t* pend = &data->pending[idx];
+    config_t* cfg = &data->config[pend->cfg];
+
+    if (add_entry(&data->bracket[cfg->bracket].rung[pend->rung],
+                  pend->cfg, perf) != 0)
+    {
+        search_error("Could not grow rung");
+        return -1;
+    }
+
+    data->pending[idx] = data->pending[--data->pending_len];
+    return 0;
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point out of strategy");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    free_brackets(data);
+
+    for (int i = 0; i < data->config_cap; ++i)
+        hpoint_fini(&data->config[i].point);
+    free(data->config);
+    free(data->pending);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return 0;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    double eta = hcfg_real(search_cfg, CFGKEY_HYPERBAND_ETA);
+    if (isnan(eta) || eta < 2.0) {
+        search_error("Configuration key " CFGKEY_HYPERBAND_ETA
+                     " must be at least 2.0");
+        return -1;
+    }
+    data->eta = eta;
+
+    double min = hcfg_real(search_cfg, CFGKEY_HYPERBAND_MIN_BUDGET);
+    if (isnan(min) || min <= 0.0 || min > 1.0) {
+        search_error("Configuration key " CFGKEY_HYPERBAND_MIN_BUDGET
+                     " must be between 0.0 (exclusive) and 1.0");
+        return -1;
+    }
+
+    // Determine the number of rungs in the largest bracket.
+    int s_max = (int) floor(log(1.0 / min) / log(eta) + 1e-9);
+
+    int count = hcfg_int(search_cfg, CFGKEY_HYPERBAND_BRACKETS);
+    if (count < 0) {
+        search_error("Configuration key " CFGKEY_HYPERBAND_BRACKETS
+                     " must not be negative");
+        return -1;
+    }
+    if (count == 0 || count > s_max + 1)
+        count = s_max + 1;
+
+    free_brackets(data);
+    data->bracket = calloc(count, sizeof(*data->bracket));
+    if (!data->bracket) {
+        search_error("Could not allocate bracket list");
+        return -1;
+    }
+    data->bracket_len = count;
+
+    // Bracket s begins with budget ETA^-s, and receives new
+    // configurations in proportion to (s_max + 1) / (s + 1) * ETA^s.
+    //
+    for (int i = 0; i < count; ++i) {
+        bracket_t* bracket = &data->bracket[i];
+        int s = s_max - i;
+
+        bracket->rung = calloc(s + 1, sizeof(*bracket->rung));
+        if (!bracket->rung) {
+            search_error("Could not allocate rung list");
+            return -1;
+        }
+        bracket->len = s + 1;
+        bracket->share = ceil((s_max + 1.0) / (s + 1.0) * pow(eta, s));
+
+        for (int k = 0; k <= s; ++k)
+            bracket->rung[k].budget = pow(eta, k - s);
+    }
+    return 0;
+}
+
+void free_brackets(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->bracket_len; ++i) {
+        for (int k = 0; k < data->bracket[i].len; ++k)
+            free(data->bracket[i].rung[k].entry);
+        free(data->bracket[i].rung);
+    }
+    free(data->bracket);
+    data->bracket = NULL;
+    data->bracket_len = 0;
+}
+
+/*
+ * Find a configuration that is eligible for promotion.  If several
+ * are found, prefer the one that would receive the largest budget.
+ *
+ * Returns 1 and sets the bracket, rung, and entry index if one is
+ * found.  Otherwise, 0 is returned.
+ */
+int find_promotion(hplugin_data_t* data, int* b, int* k, int* j)
+{
+    double budget = 0.0;
+
+    for (int i = 0; i < data->bracket_len; ++i) {
+        bracket_t* bracket = &data->bracket[i];
+
+        for (int r = bracket->len - 2; r >= 0; --r) {
+            rung_t* rung = &bracket->rung[r];
+            if (rung[1].budget <= budget)
+                break;
+
+            int quota = (int) (rung->len / data->eta);
+            for (int e = 0; e < quota; ++e) {
+                if (!rung->entry[e].promoted) {
+                    *b = i;
+                    *k = r;
+                    *j = e;
+                    budget = rung[1].budget;
+                    break;
+                }
+            }
+        }
+    }
+    return budget > 0.0;
+}
+
+/*
+ * Allocate a new configuration, and assign it to the bracket which
+ * has received the smallest fraction of its share.
+ *
+ * Returns the index of the new configuration, or -1 on error.
+ */
+int new_config(hplugin_data_t* data)
+{
+    if (data->config_len == data->config_cap) {
+        if (array_grow(&data->config, &data->config_cap,
+                       sizeof(*data->config)) != 0)
+        {
+            search_error("Could not grow configuration list");
+            return -1;
+        }
+    }
+    config_t* cfg = &data->config[data->config_len];
+
+    if (hpoint_init(&cfg->point, data->space->len) != 0) {
+        search_error("Could not allocate configuration point");
+        return -1;
+    }
+    cfg->point.len = data->space->len;
+
+    cfg->bracket = 0;
+    for (int i = 1; i < data->bracket_len; ++i) {
+        bracket_t* curr = &data->bracket[i];
+        bracket_t* prev = &data->bracket[cfg->bracket];
+
+        if (curr->started / curr->share < prev->started / prev->share)
+            cfg->bracket = i;
+    }
+    ++data->bracket[cfg->bracket].started;
+
+    return data->config_len++;
+}
+
+int issue_point(hplugin_data_t* data, pending_t* pend, hpoint_t* point)
+{
+    config_t* cfg = &data->config[pend->cfg];
+
+    if (hpoint_copy(point, &cfg->point) != 0) {
+        search_error("Could not copy configuration to point");
+        return -1;
+    }
+    point->id = pend->id;
+    point->budget = data->bracket[cfg->bracket].rung[pend->rung].budget;
+
+    return 0;
+}
+
+/*
+ * Insert an evaluation into a rung, keeping the rung sorted by
+ * performance.
+ */
+int add_entry(rung_t* rung, int cfg, double perf)
+{
+    if (rung->len == rung->cap) {
+        if (array_grow(&rung->entry, &rung->cap, sizeof(*rung->entry)) != 0)
+            return -1;
+    }
+
+    int i = rung->len;
+    while (i > 0 && rung->entry[i - 1].perf > perf)
+        --i;
+
+    memmove(&rung->entry[i + 1], &rung->entry[i],
+            (rung->len - i) * sizeof(*rung->entry));
+    rung->entry[i].cfg = cfg;
+    rung->entry[i].perf = perf;
+    rung->entry[i].promoted = 0;
+    ++rung->len;
+
+    return 0;
+}
+
+int find_pending(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->pending_len; ++i) {
+        if (data->pending[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+void randomize(hplugin_data_t* data, hpoint_t* point)
+{
+    for (int i = 0; i < data->space->len; ++i)
+        point->term[i] = hrange_random(&data->space->dim[i], search_drand48());
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _XOPEN_SOURCE 500 // Needed for M_PI.
+
+/*
+ * Space-filling designs over the unit hypercube, for use as the
+ * initial design of search strategies.
+ *
+ * Sobol direction numbers are built from primitive polynomials over
+ * GF(2), enumerated in order of degree, with random initial values.
+ * Each dimension is then scrambled by a random lower-triangular
+ * binary matrix and a random digital shift (Matousek's linear matrix
+ * scrambling), which keeps the sequence's stratification properties
+ * while removing the structured artifacts of unscrambled sequences.
+ *
+ * Latin hypercube samples are drawn in batches of a fixed size, where
+ * each batch places exactly one sample in each of the equal-width
+ * slices of every dimension.
+ *
+ * Strategies which perturb points with Gaussian noise draw standard
+ * normal deviates from here as well.
+ */
+
+#include "libsample.h"
+#include "session-core.h"
+#include "hspace.h"
+#include "hpoint.h"
+
+#include <stdlib.h> // For free(), realloc(), and NULL.
+#include <string.h> // For strcmp().
+#include <math.h>   // For cos(), log(), and sqrt().
+
+#define SOBOL_BITS 32
+
+const sampler_t sampler_zero = SAMPLER_INITIALIZER;
+
+/*
+ * Internal helper function prototypes.
+ */
+static void     sobol_init(sampler_t* sampler);
+static void     sobol_next(sampler_t* sampler, double* unit);
+static void     lhs_next(sampler_t* sampler, double* unit);
+static void     next_primitive(int* degree, uint32_t* poly);
+static int      primitive(uint32_t poly, int degree);
+static uint32_t poly_powmod(uint64_t exp, uint32_t poly, int degree);
+static uint32_t poly_mulmod(uint32_t a, uint32_t b, uint32_t poly,
+                            int degree);
+static uint32_t random_word(void);
+
+/*
+ * Sampler management implementation.
+ */
+int sampler_init(sampler_t* sampler, int dims, sample_method_t method,
+                 int size)
+{
+    if (dims < 1 || method <= SAMPLE_METHOD_UNKNOWN ||
+        method >= SAMPLE_METHOD_MAX)
+        return -1;
+
+    if (method == SAMPLE_METHOD_LHS && size < 1)
+        return -1;
+
+    sampler_fini(sampler);
+    sampler->method = method;
+    sampler->dims = dims;
+    sampler->index = 0;
+    sampler->size = size;
+
+    sampler->unit = malloc(dims * sizeof(*sampler->unit));
+    if (!sampler->unit)
+        return -1;
+
+    switch (method) {
+    case SAMPLE_METHOD_SOBOL:
+        sampler->dir = malloc(dims * SOBOL_BITS * sizeof(*sampler->dir));
+        sampler->state = malloc(dims * sizeof(*sampler->state));
+        if (!sampler->dir || !sampler->state)
+            return -1;
+
+        sobol_init(sampler);
+        break;
+
+    case SAMPLE_METHOD_LHS:
+        sampler->perm = malloc(dims * size * sizeof(*sampler->perm));
+        if (!sampler->perm)
+            return -1;
+        break;
+
+    default:
+        break;
+    }
+    return 0;
+}
+
+void sampler_fini(sampler_t* sampler)
+{
+    free(sampler->dir);
+    free(sampler->state);
+    free(sampler->perm);
+    free(sampler->unit);
+    *sampler = sampler_zero;
+}
+
+/*
+ * Convert a method name into its sample_method_t value.  Returns
+ * SAMPLE_METHOD_UNKNOWN if the name is not recognized.
+ */
+sample_method_t sample_method(const char* name)
+{
+    if (strcmp(name, "uniform") == 0) return SAMPLE_METHOD_UNIFORM;
+    if (strcmp(name, "sobol") == 0)   return SAMPLE_METHOD_SOBOL;
+    if (strcmp(name, "lhs") == 0)     return SAMPLE_METHOD_LHS;
+    return SAMPLE_METHOD_UNKNOWN;
+}
+
+/*
+ * Sample generation implementation.
+ */
+
+/*
+ * Write the next sample into unit, an array of sampler->dims values
+ * in the range [0, 1).
+ */
+void sampler_next(sampler_t* sampler, double* unit)
+{
+    switch (sampler->method) {
+    case SAMPLE_METHOD_SOBOL:
+        sobol_next(sampler, unit);
+        break;
+
+    case SAMPLE_METHOD_LHS:
+        lhs_next(sampler, unit);
+        break;
+
+    default:
+        for (int i = 0; i < sampler->dims; ++i)
+            unit[i] = search_drand48();
+        break;
+    }
+    ++sampler->index;
+}
+
+/*
+ * Map the next sample onto the search space, and store it in point.
+ */
+int sampler_point(sampler_t* sampler, const hspace_t* space,
+                  hpoint_t* point)
+{
+    if (sampler->dims != space->len)
+        return -1;
+
+    if (hpoint_init(point, space->len) != 0)
+        return -1;
+    point->len = space->len;
+
+    sampler_next(sampler, sampler->unit);
+    for (int i = 0; i < space->len; ++i)
+        point->term[i] = hrange_random(&space->dim[i], sampler->unit[i]);
+
+    return 0;
+}
+
+/*
+ * Standard normal deviate, by the Box-Muller transform.
+ */
+double sample_normal(void)
+{
+    double u = 1.0 - search_drand48();
+    double v = search_drand48();
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+void sobol_init(sampler_t* sampler)
+{
+    int degree = 0;
+    uint32_t poly = 0;
+
+    for (int i = 0; i < sampler->dims; ++i) {
+        uint32_t* v = &sampler->dir[i * SOBOL_BITS];
+
+        if (i == 0) {
+            // The first dimension is the van der Corput sequence.
+            for (int k = 0; k < SOBOL_BITS; ++k)
+                v[k] = 1u << (SOBOL_BITS - 1 - k);
+        }
+        else {
+            next_primitive(&degree, &poly);
+
+            // Initial direction numbers m_k must be odd, and less
+            // than 2^k.
+            //
+            for (int k = 0; k < degree && k < SOBOL_BITS; ++k) {
+                uint32_t m = 2 * (uint32_t) (search_drand48() * (1u << k));
+                v[k] = (m | 1) << (SOBOL_BITS - 1 - k);
+            }
+
+            // The remainder follow from the polynomial's recurrence.
+            for (int k = degree; k < SOBOL_BITS; ++k) {
+                v[k] = v[k - degree] ^ (v[k - degree] >> degree);
+                for (int j = 1; j < degree; ++j) {
+                    if ((poly >> (degree - j)) & 1)
+                        v[k] ^= v[k - j];
+                }
+            }
+        }
+
+        // Scramble the direction numbers.  Each column of the
+        // lower-triangular matrix holds its diagonal bit, and random
+        // bits of lesser significance.
+        //
+        uint32_t col[SOBOL_BITS];
+        for (int b = 0; b < SOBOL_BITS; ++b) {
+            uint32_t bit = 1u << b;
+            col[b] = bit | (random_word() & (bit - 1));
+        }
+
+        for (int k = 0; k < SOBOL_BITS; ++k) {
+            uint32_t val = 0;
+            for (int b = 0; b < SOBOL_BITS; ++b) {
+                if ((v[k] >> b) & 1)
+                    val ^= col[b];
+            }
+            v[k] = val;
+        }
+
+        // The digital shift is the (scrambled) first point.
+        sampler->state[i] = random_word();
+    }
+}
+
+/*
+ * Generate Sobol points in Gray code order, where each point differs
+ * from the last by a single direction number.
+ */
+void sobol_next(sampler_t* sampler, double* unit)
+{
+    if (sampler->index > 0) {
+        unsigned n = sampler->index - 1;
+        int k = 0;
+
+        while (n & 1) {
+            n >>= 1;
+            ++k;
+        }
+
+        if (k < SOBOL_BITS) {
+            for (int i = 0; i < sampler->dims; ++i)
+                sampler->state[i] ^= sampler->dir[i * SOBOL_BITS + k];
+        }
+    }
+
+    for (int i = 0; i < sampler->dims; ++i)
+        unit[i] = sampler->state[i] / 4294967296.0;
+}
+
+void lhs_next(sampler_t* sampler, double* unit)
+{
+    int size = sampler->size;
+    int idx = sampler->index % size;
+
+    if (idx == 0) {
+        // Start a new batch with a fresh permutation of the slices of
+        // each dimension.
+        //
+        for (int i = 0; i < sampler->dims; ++i) {
+            int* perm = &sampler->perm[i * size];
+
+            for (int j = 0; j < size; ++j)
+                perm[j] = j;
+
+            for (int j = size - 1; j > 0; --j) {
+                int r = (int) (search_drand48() * (j + 1));
+                int tmp = perm[j];
+                perm[j] = perm[r];
+                perm[r] = tmp;
+            }
+        }
+    }
+
+    for (int i = 0; i < sampler->dims; ++i) {
+        int slice = sampler->perm[i * size + idx];
+        unit[i] = (slice + search_drand48()) / size;
+    }
+}
+
+/*
+ * Advance to the next primitive polynomial over GF(2), in order of
+ * degree and then coefficients.  Polynomials are encoded with bit i
+ * holding the coefficient of x^i.
+ */
+void next_primitive(int* degree, uint32_t* poly)
+{
+    if (*degree == 0) {
+        *degree = 1;
+        *poly = 0x3; // x + 1
+        return;
+    }
+
+    do {
+        *poly += 2;
+        if (*poly >> (*degree + 1)) {
+            ++(*degree);
+            *poly = (1u << *degree) | 1;
+        }
+    } while (!primitive(*poly, *degree));
+}
+
+/*
+ * A polynomial of degree d is primitive if x has multiplicative order
+ * 2^d - 1 modulo the polynomial.
+ */
+int primitive(uint32_t poly, int degree)
+{
+    uint64_t order = (UINT64_C(1) << degree) - 1;
+
+    if (poly_powmod(order, poly, degree) != 1)
+        return 0;
+
+    // Check that no proper divisor of the order also yields 1.
+    uint64_t n = order;
+    for (uint64_t q = 3; n > 1; q += 2) {
+        if (q * q > n)
+            q = n;
+
+        if (n % q == 0) {
+            if (poly_powmod(order / q, poly, degree) == 1)
+                return 0;
+
+            while (n % q == 0)
+                n /= q;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Compute x^exp modulo poly.
+ */
+uint32_t poly_powmod(uint64_t exp, uint32_t poly, int degree)
+{
+    uint32_t result = 1;
+    uint32_t base = (degree > 1) ? 0x2 : poly_mulmod(0x2, 1, poly, degree);
+
+    for (; exp; exp >>= 1) {
+        if (exp & 1)
+            result = poly_mulmod(result, base, poly, degree);
+        base = poly_mulmod(base, base, poly, degree);
+    }
+    return result;
+}
+
+uint32_t poly_mulmod(uint32_t a, uint32_t b, uint32_t poly, int degree)
+{
+    uint64_t result = 0;
+
+    for (int i = degree; i >= 0; --i) {
+        result <<= 1;
+        if ((result >> degree) & 1)
+            result ^= poly;
+        if ((b >> i) & 1)
+            result ^= a;
+    }
+    if ((result >> degree) & 1)
+        result ^= poly;
+
+    return (uint32_t) result;
+}
+
+uint32_t random_word(void)
+{
+    return (uint32_t) (search_drand48() * 4294967296.0);
+}
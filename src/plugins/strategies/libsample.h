@@ -0,0 +1,84 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIBSAMPLE_H__
+#define __LIBSAMPLE_H__
+
+#include "hspace.h"
+#include "hpoint.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum sample_method {
+    SAMPLE_METHOD_UNKNOWN = 0,
+    SAMPLE_METHOD_UNIFORM, // Independent pseudo-random values.
+    SAMPLE_METHOD_SOBOL,   // Scrambled Sobol sequence.
+    SAMPLE_METHOD_LHS,     // Latin hypercube batches.
+
+    SAMPLE_METHOD_MAX
+} sample_method_t;
+
+/*
+ * Sampler structure for space-filling designs over a search space.
+ */
+typedef struct sampler {
+    sample_method_t method;
+    int       dims;
+    unsigned  index; // Number of samples drawn thus far.
+
+    // Sobol sequence state.
+    uint32_t* dir;   // Scrambled direction numbers, 32 per dimension.
+    uint32_t* state;
+
+    // Latin hypercube state.
+    int       size;
+    int*      perm;
+
+    double*   unit;  // Scratch space for sampler_point().
+} sampler_t;
+
+#define SAMPLER_INITIALIZER {0}
+extern const sampler_t sampler_zero;
+
+/*
+ * Sampler management interface.
+ */
+int  sampler_init(sampler_t* sampler, int dims, sample_method_t method,
+                  int size);
+void sampler_fini(sampler_t* sampler);
+
+sample_method_t sample_method(const char* name);
+
+/*
+ * Sample generation interface.
+ */
+void sampler_next(sampler_t* sampler, double* unit);
+int  sampler_point(sampler_t* sampler, const hspace_t* space,
+                   hpoint_t* point);
+double sample_normal(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
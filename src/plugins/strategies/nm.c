@@ -28,9 +28,18 @@
  * simplex centroid.  In some cases, the entire simplex may also be
  * shrunken.
  *
- * \note Due to the nature of the underlying algorithm, this strategy
- * is best suited for serial tuning tasks.  It often waits on a single
- * performance report before a new point may be generated.
+ * \note Due to the nature of the underlying algorithm, a single
+ * simplex is best suited for serial tuning tasks.  It often waits on
+ * a single performance report before a new point may be generated.
+ *
+ * To make use of parallel clients, NM_STARTS independent simplices
+ * may be run at once, and their points are handed out in turn.  The
+ * first simplex is centered on INIT_POINT (if defined), while the
+ * rest are centered on a Latin hypercube sample of the search space
+ * (see SAMPLE_METHOD).  Each simplex may also be restarted around
+ * the best point found thus far once it converges, up to a total of
+ * NM_RESTARTS times.  The search converges when every simplex has
+ * converged, and no restarts remain.
  *
  * For details of the algorithm, see:
  * > Nelder, John A.; R. Mead (1965). "A simplex method for function
@@ -45,6 +54,7 @@
 #include "hperf.h"
 #include "hutil.h"
 #include "libvertex.h"
+#include "libsample.h"
 
 #include <string.h> // For strcmp().
 #include <math.h>   // For isnan().
@@ -87,6 +97,16 @@ const hcfg_info_t hplugin_keyinfo[] = {
       "than this percentage of the total search space.  Simplex radius "
       "is measured from centroid to furthest vertex.  Total search space "
       "is measured from minimum to maximum point." },
+    { CFGKEY_NM_STARTS, "1",
+      "Number of simplices searched concurrently.  A value of 0 selects "
+      "one simplex per client, as given by " CFGKEY_CLIENT_COUNT "." },
+    { CFGKEY_NM_RESTARTS, "0",
+      "Number of times a converged simplex may be restarted around the "
+      "best point found thus far.  Negative values allow an unlimited "
+      "number of restarts." },
+    { CFGKEY_SAMPLE_METHOD, NULL,
+      "Method used to center all but the first simplex.  Valid values "
+      "are uniform, sobol, and lhs (default)." },
     { NULL }
 };
 
@@ -110,6 +130,24 @@ typedef enum simplex_state {
     SIMPLEX_STATE_MAX
 } simplex_state_t;
 
+/*
+ * Search state of an individual simplex.
+ */
+typedef struct run {
+    vertex_t        centroid;
+    vertex_t        reflect;
+    vertex_t        expand;
+    vertex_t        contract;
+    simplex_t       simplex;
+    simplex_state_t state;
+
+    vertex_t* next;
+    unsigned  pending_id; // Identifier of next, while it is out for test.
+    int index_best;
+    int index_worst;
+    int index_curr; // For INIT or SHRINK.
+} run_t;
+
 /*
  * Structure to hold data for an individual Nelder-Mead search instance.
  */
@@ -122,6 +160,7 @@ struct hplugin_data {
     vertex_t        init_point;
     double          init_radius;
     reject_method_t reject_type;
+    int             perf_n;
 
     double reflect_val;
     double expand_val;
@@ -129,31 +168,33 @@ struct hplugin_data {
     double shrink_val;
     double fval_tol;
     double size_tol;
+    int    starts;
+    int    restarts;
 
     // Search state.
-    vertex_t        centroid;
-    vertex_t        reflect;
-    vertex_t        expand;
-    vertex_t        contract;
-    simplex_t       simplex;
-    simplex_state_t state;
-
-    vertex_t* next;
-    int index_best;
-    int index_worst;
-    int index_curr; // For INIT or SHRINK.
-    int next_id;
+    run_t*    run;
+    int       run_cap;
+    int       run_next; // Next simplex to test a point from.
+    unsigned  next_id;
+    sampler_t sampler;
+    hpoint_t  point;
+    vertex_t  base;
+    vertex_t  bound;
 };
 
 /*
  * Internal helper function prototypes.
  */
-static void check_convergence(hplugin_data_t* data);
+static void check_convergence(hplugin_data_t* data, run_t* run);
 static int  config_strategy(hplugin_data_t* data);
-static int  nm_algorithm(hplugin_data_t* data);
-static int  nm_state_transition(hplugin_data_t* data);
-static int  nm_next_vertex(hplugin_data_t* data);
-static int  update_centroid(hplugin_data_t* data);
+static int  start_run(hplugin_data_t* data, run_t* run,
+                      const vertex_t* base);
+static int  finish_run(hplugin_data_t* data, run_t* run);
+static run_t* find_run(hplugin_data_t* data, unsigned id);
+static int  nm_algorithm(hplugin_data_t* data, run_t* run);
+static int  nm_state_transition(hplugin_data_t* data, run_t* run);
+static int  nm_next_vertex(hplugin_data_t* data, run_t* run);
+static int  update_centroid(run_t* run);
 
 /*
  * Allocate memory for a new search task.
@@ -178,11 +219,13 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
     if (config_strategy(data) != 0)
         return -1;
 
-    if (simplex_set(&data->simplex, space,
-                    &data->init_point, data->init_radius) != 0)
-    {
-        search_error("Could not generate initial simplex");
-        return -1;
+    while (data->run_cap < data->starts) {
+        if (array_grow(&data->run, &data->run_cap,
+                       sizeof(*data->run)) != 0)
+        {
+            search_error("Could not allocate simplex list");
+            return -1;
+        }
     }
 
     if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
@@ -190,12 +233,28 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
         return -1;
     }
 
-    data->index_curr = 0;
-    data->state = SIMPLEX_STATE_INIT;
-    if (nm_next_vertex(data) != 0) {
-        search_error("Could not initiate test vertex");
-        return -1;
+    for (int i = 0; i < data->starts; ++i) {
+        const vertex_t* base = &data->init_point;
+
+        // Simplices after the first are spread across the space,
+        // as is the first if no initial point was given.
+        //
+        if (i > 0 || (data->starts > 1 &&
+                      !hcfg_get(search_cfg, CFGKEY_INIT_POINT)))
+        {
+            if (sampler_point(&data->sampler, space, &data->point) != 0 ||
+                vertex_set(&data->base, space, &data->point) != 0)
+            {
+                search_error("Could not sample initial simplex center");
+                return -1;
+            }
+            base = &data->base;
+        }
+
+        if (start_run(data, &data->run[i], base) != 0)
+            return -1;
     }
+    data->run_next = 0;
 
     return 0;
 }
@@ -205,18 +264,26 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
  */
 int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
 {
-    if (data->next->id == data->next_id) {
-        flow->status = HFLOW_WAIT;
-        return 0;
-    }
+    // Take the next point from each simplex in turn.
+    for (int i = 0; i < data->starts; ++i) {
+        run_t* run = &data->run[(data->run_next + i) % data->starts];
 
-    data->next->id = data->next_id;
-    if (vertex_point(data->next, data->space, point) != 0) {
-        search_error("Could not make point from vertex during generate");
-        return -1;
+        if (run->pending_id || run->state == SIMPLEX_STATE_CONVERGED)
+            continue;
+
+        run->next->id = data->next_id++;
+        if (vertex_point(run->next, data->space, point) != 0) {
+            search_error("Could not make point from vertex during generate");
+            return -1;
+        }
+        run->pending_id = run->next->id;
+        data->run_next = (run - data->run + 1) % data->starts;
+
+        flow->status = HFLOW_ACCEPT;
+        return 0;
     }
 
-    flow->status = HFLOW_ACCEPT;
+    flow->status = HFLOW_WAIT;
     return 0;
 }
 
@@ -227,10 +294,16 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
 {
     hpoint_t* hint = &flow->point;
 
+    run_t* run = find_run(data, point->id);
+    if (!run) {
+        search_error("Could not find simplex of rejected point");
+        return -1;
+    }
+
     if (hint->id) {
         // Update our state to include the hint point.
         hint->id = point->id;
-        if (vertex_set(data->next, data->space, hint) != 0) {
+        if (vertex_set(run->next, data->space, hint) != 0) {
             search_error("Could not copy hint into simplex during reject");
             return -1;
         }
@@ -244,27 +317,33 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
         // Apply an infinite penalty to the invalid point and
         // allow the algorithm to determine the next point to try.
         //
-        hperf_reset(&data->next->perf);
-        if (nm_algorithm(data) != 0) {
+        // Vertices which were never tested have no objectives yet.
+        if (hperf_init(&run->next->perf, data->perf_n) != 0) {
+            search_error("Could not allocate penalty performance");
+            return -1;
+        }
+        run->next->perf.len = data->perf_n;
+        hperf_reset(&run->next->perf);
+        if (nm_algorithm(data, run) != 0) {
             search_error("Nelder-Mead algorithm failure");
             return -1;
         }
 
-        data->next->id = data->next_id;
-        if (vertex_point(data->next, data->space, point) != 0) {
+        run->next->id = run->pending_id;
+        if (vertex_point(run->next, data->space, point) != 0) {
             search_error("Could not copy next point during reject");
             return -1;
         }
     }
     else if (data->reject_type == REJECT_METHOD_RANDOM) {
         // Replace the rejected point with a random point.
-        if (vertex_random(data->next, data->space, 1.0) != 0) {
+        if (vertex_random(run->next, data->space, 1.0) != 0) {
             search_error("Could not randomize point during reject");
             return -1;
         }
 
-        data->next->id = data->next_id;
-        if (vertex_point(data->next, data->space, point) != 0) {
+        run->next->id = run->pending_id;
+        if (vertex_point(run->next, data->space, point) != 0) {
             search_error("Could not copy random point during reject");
             return -1;
         }
@@ -279,15 +358,17 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
  */
 int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
 {
-    if (trial->point.id != data->next->id)
+    run_t* run = find_run(data, trial->point.id);
+    if (!run)
         return 0;
 
-    if (hperf_copy(&data->next->perf, &trial->perf) != 0) {
+    if (hperf_copy(&run->next->perf, &trial->perf) != 0) {
         search_error("Could not copy performance to vertex");
         return -1;
     }
 
-    if (nm_algorithm(data) != 0) {
+    run->pending_id = 0;
+    if (nm_algorithm(data, run) != 0) {
         search_error("Nelder-Mead algorithm failure");
         return -1;
     }
@@ -305,8 +386,8 @@ int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
         }
     }
 
-    if (data->state != SIMPLEX_STATE_CONVERGED)
-        ++data->next_id;
+    if (run->state == SIMPLEX_STATE_CONVERGED)
+        return finish_run(data, run);
 
     return 0;
 }
@@ -328,11 +409,21 @@ int strategy_best(hplugin_data_t* data, hpoint_t* point)
  */
 int strategy_fini(hplugin_data_t* data)
 {
-    simplex_fini(&data->simplex);
-    vertex_fini(&data->contract);
-    vertex_fini(&data->expand);
-    vertex_fini(&data->reflect);
-    vertex_fini(&data->centroid);
+    for (int i = 0; i < data->run_cap; ++i) {
+        run_t* run = &data->run[i];
+
+        simplex_fini(&run->simplex);
+        vertex_fini(&run->contract);
+        vertex_fini(&run->expand);
+        vertex_fini(&run->reflect);
+        vertex_fini(&run->centroid);
+    }
+    free(data->run);
+
+    sampler_fini(&data->sampler);
+    hpoint_fini(&data->point);
+    vertex_fini(&data->bound);
+    vertex_fini(&data->base);
     vertex_fini(&data->init_point);
     hperf_fini(&data->best_perf);
     hpoint_fini(&data->best);
@@ -345,24 +436,24 @@ int strategy_fini(hplugin_data_t* data)
  * Internal helper function implementations.
  */
 
-void check_convergence(hplugin_data_t* data)
+void check_convergence(hplugin_data_t* data, run_t* run)
 {
     double fval_err, size_max;
-    double avg_perf = hperf_unify(&data->centroid.perf);
+    double avg_perf = hperf_unify(&run->centroid.perf);
 
-    if (simplex_collapsed(&data->simplex, data->space))
+    if (simplex_collapsed(&run->simplex, data->space))
         goto converged;
 
     fval_err = 0.0;
-    for (int i = 0; i < data->simplex.len; ++i) {
-        double point_perf = hperf_unify(&data->simplex.vertex[i].perf);
+    for (int i = 0; i < run->simplex.len; ++i) {
+        double point_perf = hperf_unify(&run->simplex.vertex[i].perf);
         fval_err += ((point_perf - avg_perf) * (point_perf - avg_perf));
     }
-    fval_err /= data->simplex.len;
+    fval_err /= run->simplex.len;
 
     size_max = 0.0;
-    for (int i = 0; i < data->simplex.len; ++i) {
-        double dist = vertex_norm(&data->simplex.vertex[i], &data->centroid,
+    for (int i = 0; i < run->simplex.len; ++i) {
+        double dist = vertex_norm(&run->simplex.vertex[i], &run->centroid,
                                   VERTEX_NORM_L2);
         if (size_max < dist)
             size_max = dist;
@@ -374,8 +465,7 @@ void check_convergence(hplugin_data_t* data)
     return;
 
   converged:
-    data->state = SIMPLEX_STATE_CONVERGED;
-    search_setcfg(CFGKEY_CONVERGED, "1");
+    run->state = SIMPLEX_STATE_CONVERGED;
 }
 
 int config_strategy(hplugin_data_t* data)
@@ -420,6 +510,13 @@ int config_strategy(hplugin_data_t* data)
         }
     }
 
+    data->perf_n = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
+    if (data->perf_n < 1) {
+        search_error("Invalid value for " CFGKEY_PERF_COUNT
+                     " configuration key");
+        return -1;
+    }
+
     cfgval = hcfg_real(search_cfg, CFGKEY_REFLECT);
     if (isnan(cfgval) || cfgval <= 0.0) {
         search_error("Configuration key " CFGKEY_REFLECT
@@ -467,88 +564,182 @@ int config_strategy(hplugin_data_t* data)
     }
     data->size_tol = cfgval;
 
-    // Use the expand and reflect vertex variables as temporaries to
+    // Use the base and bound vertex variables as temporaries to
     // calculate the size tolerance.
-    if (vertex_minimum(&data->expand, data->space) != 0 ||
-        vertex_maximum(&data->reflect, data->space) != 0)
+    if (vertex_minimum(&data->base, data->space) != 0 ||
+        vertex_maximum(&data->bound, data->space) != 0)
         return -1;
 
-    data->size_tol *= vertex_norm(&data->expand, &data->reflect,
+    data->size_tol *= vertex_norm(&data->base, &data->bound,
                                   VERTEX_NORM_L2);
+
+    data->restarts = hcfg_int(search_cfg, CFGKEY_NM_RESTARTS);
+
+    data->starts = hcfg_int(search_cfg, CFGKEY_NM_STARTS);
+    if (data->starts == 0)
+        data->starts = hcfg_int(search_cfg, CFGKEY_CLIENT_COUNT);
+
+    if (data->starts < 1) {
+        search_error("Configuration key " CFGKEY_NM_STARTS
+                     " must be non-negative");
+        return -1;
+    }
+
+    if (data->starts > 1) {
+        sample_method_t method = SAMPLE_METHOD_LHS;
+
+        cfgstr = hcfg_get(search_cfg, CFGKEY_SAMPLE_METHOD);
+        if (cfgstr) {
+            method = sample_method(cfgstr);
+            if (method == SAMPLE_METHOD_UNKNOWN) {
+                search_error("Invalid value for " CFGKEY_SAMPLE_METHOD
+                             " configuration key");
+                return -1;
+            }
+        }
+
+        if (sampler_init(&data->sampler, data->space->len, method,
+                         data->starts) != 0)
+        {
+            search_error("Could not initialize point sampler");
+            return -1;
+        }
+    }
     return 0;
 }
 
-int nm_algorithm(hplugin_data_t* data)
+/*
+ * Begin searching with a new simplex around the given vertex.
+ */
+int start_run(hplugin_data_t* data, run_t* run, const vertex_t* base)
+{
+    if (simplex_set(&run->simplex, data->space,
+                    base, data->init_radius) != 0)
+    {
+        search_error("Could not generate initial simplex");
+        return -1;
+    }
+
+    run->pending_id = 0;
+    run->index_curr = 0;
+    run->state = SIMPLEX_STATE_INIT;
+    if (nm_next_vertex(data, run) != 0) {
+        search_error("Could not initiate test vertex");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Restart a converged simplex around the best known point, if any
+ * restarts remain.  Otherwise, declare the search converged once all
+ * simplices have converged.
+ */
+int finish_run(hplugin_data_t* data, run_t* run)
+{
+    if (data->restarts != 0) {
+        if (data->restarts > 0)
+            --data->restarts;
+
+        if (vertex_set(&data->base, data->space, &data->best) != 0) {
+            search_error("Could not center restarted simplex");
+            return -1;
+        }
+        return start_run(data, run, &data->base);
+    }
+
+    for (int i = 0; i < data->starts; ++i) {
+        if (data->run[i].state != SIMPLEX_STATE_CONVERGED)
+            return 0;
+    }
+
+    if (search_setcfg(CFGKEY_CONVERGED, "1") != 0) {
+        search_error("Could not set convergence status");
+        return -1;
+    }
+    return 0;
+}
+
+run_t* find_run(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->starts; ++i) {
+        if (id && data->run[i].pending_id == id)
+            return &data->run[i];
+    }
+    return NULL;
+}
+
+int nm_algorithm(hplugin_data_t* data, run_t* run)
 {
     do {
-        if (data->state == SIMPLEX_STATE_CONVERGED)
+        if (run->state == SIMPLEX_STATE_CONVERGED)
             break;
 
-        if (nm_state_transition(data) != 0)
+        if (nm_state_transition(data, run) != 0)
             return -1;
 
-        if (data->state == SIMPLEX_STATE_REFLECT) {
-            if (update_centroid(data) != 0)
+        if (run->state == SIMPLEX_STATE_REFLECT) {
+            if (update_centroid(run) != 0)
                 return -1;
 
-            check_convergence(data);
+            check_convergence(data, run);
         }
 
-        if (nm_next_vertex(data) != 0)
+        if (nm_next_vertex(data, run) != 0)
             return -1;
 
-    } while (!vertex_inbounds(data->next, data->space));
+    } while (!vertex_inbounds(run->next, data->space));
 
     return 0;
 }
 
-int nm_state_transition(hplugin_data_t* data)
+int nm_state_transition(hplugin_data_t* data, run_t* run)
 {
-    switch (data->state) {
+    switch (run->state) {
     case SIMPLEX_STATE_INIT:
     case SIMPLEX_STATE_SHRINK:
         // Simplex vertex performance value.
-        if (++data->index_curr == data->space->len + 1)
-            data->state = SIMPLEX_STATE_REFLECT;
+        if (++run->index_curr == data->space->len + 1)
+            run->state = SIMPLEX_STATE_REFLECT;
 
         break;
 
     case SIMPLEX_STATE_REFLECT:
-        if (hperf_cmp(&data->reflect.perf,
-                      &data->simplex.vertex[data->index_best].perf) < 0)
+        if (hperf_cmp(&run->reflect.perf,
+                      &run->simplex.vertex[run->index_best].perf) < 0)
         {
             // Reflected point performs better than all simplex points.
             // Attempt expansion.
             //
-            data->state = SIMPLEX_STATE_EXPAND;
+            run->state = SIMPLEX_STATE_EXPAND;
         }
-        else if (hperf_cmp(&data->reflect.perf,
-                           &data->simplex.vertex[data->index_worst].perf) < 0)
+        else if (hperf_cmp(&run->reflect.perf,
+                           &run->simplex.vertex[run->index_worst].perf) < 0)
         {
             // Reflected point performs better than worst simplex point.
             // Replace the worst simplex point with reflected point
             // and attempt reflection again.
             //
-            if (vertex_copy(&data->simplex.vertex[data->index_worst],
-                            &data->reflect) != 0)
+            if (vertex_copy(&run->simplex.vertex[run->index_worst],
+                            &run->reflect) != 0)
                 return -1;
         }
         else {
             // Reflected point does not improve the current simplex.
             // Attempt contraction.
             //
-            data->state = SIMPLEX_STATE_CONTRACT;
+            run->state = SIMPLEX_STATE_CONTRACT;
         }
         break;
 
     case SIMPLEX_STATE_EXPAND:
-        if (hperf_cmp(&data->expand.perf, &data->reflect.perf) < 0) {
+        if (hperf_cmp(&run->expand.perf, &run->reflect.perf) < 0) {
             // Expanded point performs even better than reflected point.
             // Replace the worst simplex point with the expanded point
             // and attempt reflection again.
             //
-            if (vertex_copy(&data->simplex.vertex[data->index_worst],
-                            &data->expand) != 0)
+            if (vertex_copy(&run->simplex.vertex[run->index_worst],
+                            &run->expand) != 0)
                 return -1;
         }
         else {
@@ -556,34 +747,34 @@ int nm_state_transition(hplugin_data_t* data)
             // Replace the worst simplex point with the original
             // reflected point and attempt reflection again.
             //
-            if (vertex_copy(&data->simplex.vertex[data->index_worst],
-                            &data->reflect) != 0)
+            if (vertex_copy(&run->simplex.vertex[run->index_worst],
+                            &run->reflect) != 0)
                 return -1;
         }
-        data->state = SIMPLEX_STATE_REFLECT;
+        run->state = SIMPLEX_STATE_REFLECT;
         break;
 
     case SIMPLEX_STATE_CONTRACT:
-        if (hperf_cmp(&data->contract.perf,
-                      &data->simplex.vertex[data->index_worst].perf) < 0)
+        if (hperf_cmp(&run->contract.perf,
+                      &run->simplex.vertex[run->index_worst].perf) < 0)
         {
             // Contracted point performs better than the worst simplex point.
             //
             // Replace the worst simplex point with contracted point
             // and attempt reflection.
             //
-            if (vertex_copy(&data->simplex.vertex[data->index_worst],
-                            &data->contract) != 0)
+            if (vertex_copy(&run->simplex.vertex[run->index_worst],
+                            &run->contract) != 0)
                 return -1;
 
-            data->state = SIMPLEX_STATE_REFLECT;
+            run->state = SIMPLEX_STATE_REFLECT;
         }
         else {
             // Contracted test vertex has worst known performance.
             // Shrink the entire simplex towards the best point.
             //
-            data->index_curr = -1; // Indicates the beginning of SHRINK.
-            data->state = SIMPLEX_STATE_SHRINK;
+            run->index_curr = -1; // Indicates the beginning of SHRINK.
+            run->state = SIMPLEX_STATE_SHRINK;
         }
         break;
 
@@ -593,102 +784,102 @@ int nm_state_transition(hplugin_data_t* data)
     return 0;
 }
 
-int nm_next_vertex(hplugin_data_t* data)
+int nm_next_vertex(hplugin_data_t* data, run_t* run)
 {
-    switch (data->state) {
+    switch (run->state) {
     case SIMPLEX_STATE_INIT:
         // Test individual vertices of the initial simplex.
-        data->next = &data->simplex.vertex[data->index_curr];
+        run->next = &run->simplex.vertex[run->index_curr];
         break;
 
     case SIMPLEX_STATE_REFLECT:
         // Test a vertex reflected from the worst performing vertex
         // through the centroid point.
         //
-        if (vertex_transform(&data->centroid,
-                             &data->simplex.vertex[data->index_worst],
-                             data->reflect_val, &data->reflect) != 0)
+        if (vertex_transform(&run->centroid,
+                             &run->simplex.vertex[run->index_worst],
+                             data->reflect_val, &run->reflect) != 0)
             return -1;
 
-        data->next = &data->reflect;
+        run->next = &run->reflect;
         break;
 
     case SIMPLEX_STATE_EXPAND:
         // Test a vertex that expands the reflected vertex even
         // further from the the centroid point.
         //
-        if (vertex_transform(&data->centroid,
-                             &data->simplex.vertex[data->index_worst],
-                             data->expand_val, &data->expand) != 0)
+        if (vertex_transform(&run->centroid,
+                             &run->simplex.vertex[run->index_worst],
+                             data->expand_val, &run->expand) != 0)
             return -1;
 
-        data->next = &data->expand;
+        run->next = &run->expand;
         break;
 
     case SIMPLEX_STATE_CONTRACT:
         // Test a vertex contracted from the worst performing vertex
         // towards the centroid point.
         //
-        if (vertex_transform(&data->simplex.vertex[data->index_worst],
-                             &data->centroid,
-                             -data->contract_val, &data->contract) != 0)
+        if (vertex_transform(&run->simplex.vertex[run->index_worst],
+                             &run->centroid,
+                             -data->contract_val, &run->contract) != 0)
             return -1;
 
-        data->next = &data->contract;
+        run->next = &run->contract;
         break;
 
     case SIMPLEX_STATE_SHRINK:
-        if (data->index_curr == -1) {
+        if (run->index_curr == -1) {
             // Shrink the entire simplex towards the best known vertex
             // thus far.
             //
-            if (simplex_transform(&data->simplex,
-                                  &data->simplex.vertex[data->index_best],
-                                  -data->shrink_val, &data->simplex) != 0)
+            if (simplex_transform(&run->simplex,
+                                  &run->simplex.vertex[run->index_best],
+                                  -data->shrink_val, &run->simplex) != 0)
                 return -1;
 
-            data->index_curr = 0;
+            run->index_curr = 0;
         }
 
         // Test individual vertices of the initial simplex.
-        data->next = &data->simplex.vertex[data->index_curr];
+        run->next = &run->simplex.vertex[run->index_curr];
         break;
 
     case SIMPLEX_STATE_CONVERGED:
         // Simplex has converged.  Nothing to do.
         // In the future, we may consider new search at this point.
         //
-        data->next = &data->simplex.vertex[data->index_best];
+        run->next = &run->simplex.vertex[run->index_best];
         break;
 
     default:
         return -1;
     }
 
-    hperf_reset(&data->next->perf);
+    hperf_reset(&run->next->perf);
     return 0;
 }
 
-int update_centroid(hplugin_data_t* data)
+int update_centroid(run_t* run)
 {
-    data->index_best = 0;
-    data->index_worst = 0;
+    run->index_best = 0;
+    run->index_worst = 0;
 
-    for (int i = 1; i < data->simplex.len; ++i) {
-        if (hperf_cmp(&data->simplex.vertex[i].perf,
-                      &data->simplex.vertex[data->index_best].perf) < 0)
-            data->index_best = i;
+    for (int i = 1; i < run->simplex.len; ++i) {
+        if (hperf_cmp(&run->simplex.vertex[i].perf,
+                      &run->simplex.vertex[run->index_best].perf) < 0)
+            run->index_best = i;
 
-        if (hperf_cmp(&data->simplex.vertex[i].perf,
-                      &data->simplex.vertex[data->index_worst].perf) > 0)
-            data->index_worst = i;
+        if (hperf_cmp(&run->simplex.vertex[i].perf,
+                      &run->simplex.vertex[run->index_worst].perf) > 0)
+            run->index_worst = i;
     }
 
-    unsigned stashed_id = data->simplex.vertex[data->index_worst].id;
-    data->simplex.vertex[data->index_worst].id = 0;
-    if (simplex_centroid(&data->simplex, &data->centroid) != 0)
+    unsigned stashed_id = run->simplex.vertex[run->index_worst].id;
+    run->simplex.vertex[run->index_worst].id = 0;
+    if (simplex_centroid(&run->simplex, &run->centroid) != 0)
         return -1;
 
-    data->simplex.vertex[data->index_worst].id = stashed_id;
+    run->simplex.vertex[run->index_worst].id = stashed_id;
     return 0;
 }
@@ -0,0 +1,692 @@
+/*
+ * Copyright 2003-2016 Jeffrey K. Hollingsworth
+ *
+ * This file is part of Active Harmony.
+ *
+ * Active Harmony is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Active Harmony is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Active Harmony.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \page portfolio Portfolio (portfolio.so)
+ *
+ * This search strategy runs several other search strategies side by
+ * side, and decides which of them generates each new point.  The
+ * strategies to run are listed in the PORTFOLIO_LIST configuration
+ * key.
+ *
+ * Each point is requested from the strategy with the highest upper
+ * confidence bound on its recent rate of improvement, where a result
+ * counts as an improvement if it is better than every full-budget
+ * result reported before it.  Older results are discounted by a
+ * factor of PORTFOLIO_DISCOUNT for each new result, so the portfolio
+ * shifts its allocation as the relative merit of its strategies
+ * changes over the course of a search.
+ *
+ * Choices are deferred until a client can use the point, so no more
+ * than GEN_COUNT points per client are outstanding at once.  Points
+ * which are outstanding shrink the exploration bonus of their
+ * strategy, which spreads parallel fetches across the portfolio.
+ * Strategies which cannot generate another point until earlier
+ * results arrive are skipped in favor of the next best choice.
+ *
+ * Every strategy receives every full-budget result.  Results for
+ * points generated by other strategies carry a point identifier the
+ * receiving strategy never issued.  Strategies such as random.so,
+ * de.so and gps.so still use them to update their best known point,
+ * while nm.so and pro.so discard them.  The portfolio tracks the best
+ * point across all strategies on its own.
+ *
+ * A strategy which converges is no longer asked for points.  The
+ * portfolio converges once all of its strategies have converged.
+ * Until then, the convergence of individual strategies is hidden from
+ * the rest of the search, so layers such as group.so only react to
+ * the portfolio as a whole.
+ */
+
+#include "hstrategy.h"
+#include "session-core.h"
+#include "hplugin.h"
+#include "hcfg.h"
+#include "hspace.h"
+#include "hpoint.h"
+#include "hperf.h"
+#include "hutil.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h> // For UINT_MAX.
+#include <math.h>
+
+/*
+ * Configuration variables used in this plugin.
+ * These will automatically be registered by session-core upon load.
+ */
+const hcfg_info_t hplugin_keyinfo[] = {
+    { CFGKEY_PORTFOLIO_LIST, "nm.so,pro.so,random.so",
+      "Comma separated list of search strategy plug-ins to run." },
+    { CFGKEY_PORTFOLIO_DISCOUNT, "0.95",
+      "Weight retained by past results each time a new result is "
+      "reported." },
+    { CFGKEY_PORTFOLIO_EXPLORE, "0.5",
+      "Scale of the exploration bonus given to strategies with few "
+      "recent results." },
+    { NULL }
+};
+
+/*
+ * Point identifier used when reporting the results of one strategy's
+ * points to another.
+ */
+#define FOREIGN_ID UINT_MAX
+
+/*
+ * Search strategy run by the portfolio, along with its discounted
+ * result counts.
+ */
+typedef struct arm {
+    hplugin_t plugin;
+    double    best_perf;
+    double    count;
+    double    gain;
+    int       pending;
+    int       converged;
+    int       tried;
+} arm_t;
+
+/*
+ * Map from a point identifier issued by this strategy to the
+ * identifier issued by the strategy which generated it.
+ */
+typedef struct ticket {
+    unsigned id;
+    unsigned local;
+    int      arm;
+} ticket_t;
+
+/*
+ * Structure to hold data for an individual portfolio search instance.
+ */
+struct hplugin_data {
+    hspace_t* space;
+    hpoint_t  best;
+    double    best_perf;
+
+    arm_t*    arm;
+    int       arm_len, arm_cap;
+    int       active;
+    int       dirty;
+    int       converged;
+    int       clients;
+
+    ticket_t* ticket;
+    int       ticket_len, ticket_cap;
+    unsigned  next_id;
+
+    double    discount;
+    double    explore;
+    char*     buf;
+    int       buf_len;
+};
+
+/*
+ * Internal helper function prototypes.
+ */
+static int  config_strategy(hplugin_data_t* data);
+static int  open_arms(hplugin_data_t* data);
+static int  select_arm(hplugin_data_t* data);
+static int  filter_setcfg(void* data, const char* key, const char* val);
+static int  finish_call(hplugin_data_t* data);
+static int  add_ticket(hplugin_data_t* data, unsigned local, int arm);
+static int  find_ticket(hplugin_data_t* data, unsigned id);
+static int  report(hplugin_data_t* data, int idx, htrial_t* trial,
+                   unsigned id);
+
+/*
+ * Allocate memory for a new search task.
+ */
+hplugin_data_t* strategy_alloc(void)
+{
+    hplugin_data_t* retval = calloc(1, sizeof(*retval));
+    if (!retval)
+        return NULL;
+
+    retval->best_perf = HUGE_VAL;
+    retval->next_id = 1;
+    retval->active = -1;
+
+    return retval;
+}
+
+/*
+ * Initialize (or re-initialize) data for this search task.
+ */
+int strategy_init(hplugin_data_t* data, hspace_t* space)
+{
+    data->space = space;
+
+    if (config_strategy(data) != 0)
+        return -1;
+
+    if (!data->arm_len && open_arms(data) != 0)
+        return -1;
+
+    if (search_setcfg_filter(data, filter_setcfg) != 0) {
+        search_error("Could not install configuration filter");
+        return -1;
+    }
+
+    for (int i = 0; i < data->arm_len; ++i) {
+        arm_t* arm = &data->arm[i];
+
+        arm->best_perf = HUGE_VAL;
+        arm->count = 0.0;
+        arm->gain = 0.0;
+        arm->pending = 0;
+        arm->converged = 0;
+
+        data->active = i;
+        if (hplugin_init(&arm->plugin, space) != 0)
+            return -1;
+    }
+    data->active = -1;
+    data->dirty = 0;
+    data->converged = 0;
+    data->ticket_len = 0;
+
+    if (search_setcfg(CFGKEY_CONVERGED, "0") != 0) {
+        search_error("Could not set " CFGKEY_CONVERGED " config variable");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Forward client join events to each strategy.
+ */
+int strategy_join(hplugin_data_t* data, const char* client)
+{
+    ++data->clients;
+    for (int i = 0; i < data->arm_len; ++i) {
+        if (hplugin_join(&data->arm[i].plugin, client) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*
+ * Generate a new candidate configuration.
+ */
+int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int clients = hcfg_int(search_cfg, CFGKEY_CLIENT_COUNT);
+    if (clients < data->clients)
+        clients = data->clients;
+
+    if (data->ticket_len >= clients * hcfg_int(search_cfg,
+                                               CFGKEY_GEN_COUNT))
+    {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    for (int i = 0; i < data->arm_len; ++i)
+        data->arm[i].tried = 0;
+
+    while (!data->converged) {
+        int idx = select_arm(data);
+        if (idx < 0)
+            break;
+
+        hplugin_t* plugin = &data->arm[idx].plugin;
+        data->active = idx;
+        if (plugin->strategy.generate(plugin->data, flow, point) != 0)
+            return -1;
+
+        if (finish_call(data) != 0)
+            return -1;
+
+        if (flow->status == HFLOW_ACCEPT) {
+            if (add_ticket(data, point->id, idx) != 0)
+                return -1;
+
+            point->id = data->ticket[data->ticket_len - 1].id;
+            ++data->arm[idx].pending;
+            return 0;
+        }
+        data->arm[idx].tried = 1;
+    }
+
+    if (data->converged && data->best.id) {
+        // All strategies have converged.  Continue testing the best
+        // known point.
+        //
+        if (hpoint_copy(point, &data->best) != 0) {
+            search_error("Could not copy best point during generation");
+            return -1;
+        }
+
+        if (add_ticket(data, point->id, -1) != 0)
+            return -1;
+
+        point->id = data->ticket[data->ticket_len - 1].id;
+        flow->status = HFLOW_ACCEPT;
+        return 0;
+    }
+
+    flow->status = HFLOW_WAIT;
+    return 0;
+}
+
+/*
+ * Regenerate a point deemed invalid by a later plug-in.
+ */
+int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = find_ticket(data, point->id);
+    if (idx < 0) {
+        // Points issued before a restart have no ticket.  Drop them.
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    ticket_t* ticket = &data->ticket[idx];
+    if (ticket->arm < 0) {
+        // Only the best known point is left to test.  Without a hint,
+        // sending it again would only be rejected again.
+        //
+        if (!flow->point.id) {
+            data->ticket[idx] = data->ticket[--data->ticket_len];
+            flow->status = HFLOW_WAIT;
+            return 0;
+        }
+
+        if (hpoint_copy(point, &flow->point) != 0) {
+            search_error("Could not copy hint during reject");
+            return -1;
+        }
+        flow->status = HFLOW_ACCEPT;
+    }
+    else {
+        hplugin_t* plugin = &data->arm[ticket->arm].plugin;
+        unsigned id = ticket->id;
+
+        point->id = ticket->local;
+        data->active = ticket->arm;
+        flow->status = HFLOW_ACCEPT;
+        if (plugin->strategy.rejected(plugin->data, flow, point) != 0)
+            return -1;
+
+        if (finish_call(data) != 0)
+            return -1;
+
+        // The search may have restarted, which discards all tickets.
+        idx = find_ticket(data, id);
+        if (idx < 0) {
+            flow->status = HFLOW_WAIT;
+            return 0;
+        }
+        ticket = &data->ticket[idx];
+
+        if (flow->status == HFLOW_WAIT) {
+            // The strategy has no replacement for the rejected point.
+            --data->arm[ticket->arm].pending;
+            data->ticket[idx] = data->ticket[--data->ticket_len];
+            return 0;
+        }
+        ticket->local = point->id;
+    }
+    point->id = ticket->id;
+    return 0;
+}
+
+/*
+ * Analyze the observed performance for this configuration point.
+ */
+int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    double perf = hperf_unify(&trial->perf);
+    double budget = trial->point.budget;
+    int full = (budget <= 0.0 || budget >= 1.0);
+
+    // Partial-budget results are not comparable with the others.
+    if (full && data->best_perf > perf) {
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point during analyze");
+            return -1;
+        }
+        data->best_perf = perf;
+    }
+
+    // Retire the ticket first, since a report may restart the search.
+    int idx = find_ticket(data, trial->point.id);
+    int owner = -1;
+    unsigned local = 0;
+
+    if (idx >= 0) {
+        owner = data->ticket[idx].arm;
+        local = data->ticket[idx].local;
+        data->ticket[idx] = data->ticket[--data->ticket_len];
+    }
+
+    if (owner >= 0) {
+        arm_t* arm = &data->arm[owner];
+
+        --arm->pending;
+        if (full) {
+            for (int i = 0; i < data->arm_len; ++i) {
+                data->arm[i].count *= data->discount;
+                data->arm[i].gain *= data->discount;
+            }
+            arm->count += 1.0;
+            if (arm->best_perf > perf) {
+                arm->best_perf = perf;
+                arm->gain += 1.0;
+            }
+        }
+    }
+
+    for (int i = 0; i < data->arm_len; ++i) {
+        if (i == owner) {
+            if (report(data, i, trial, local) != 0)
+                return -1;
+        }
+        else if (full) {
+            if (report(data, i, trial, FOREIGN_ID) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Return the best performing point thus far in the search.
+ */
+int strategy_best(hplugin_data_t* data, hpoint_t* point)
+{
+    if (hpoint_copy(point, &data->best) != 0) {
+        search_error("Could not copy best point during request for best");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Forward configuration changes to each strategy.  The convergence
+ * status of the portfolio does not apply to its strategies.
+ */
+int strategy_setcfg(hplugin_data_t* data, const char* key, const char* val)
+{
+    if (strcmp(key, CFGKEY_CONVERGED) == 0)
+        return 0;
+
+    int active = data->active;
+    for (int i = 0; i < data->arm_len; ++i) {
+        data->active = i;
+        if (hplugin_setcfg(&data->arm[i].plugin, key, val) != 0)
+            return -1;
+    }
+    data->active = active;
+
+    return 0;
+}
+
+/*
+ * Free memory associated with this search task.
+ */
+int strategy_fini(hplugin_data_t* data)
+{
+    int retval = 0;
+
+    for (int i = data->arm_len - 1; i >= 0; --i) {
+        const char* errstr;
+
+        if (hplugin_fini(&data->arm[i].plugin) != 0)
+            retval = -1;
+
+        if (hplugin_close(&data->arm[i].plugin, &errstr) != 0) {
+            search_error(errstr);
+            retval = -1;
+        }
+    }
+
+    free(data->buf);
+    free(data->ticket);
+    free(data->arm);
+    hpoint_fini(&data->best);
+
+    free(data);
+    return retval;
+}
+
+/*
+ * Internal helper function implementation.
+ */
+
+int config_strategy(hplugin_data_t* data)
+{
+    data->discount = hcfg_real(search_cfg, CFGKEY_PORTFOLIO_DISCOUNT);
+    if (!(data->discount > 0.0 && data->discount <= 1.0)) {
+        search_error("Configuration key " CFGKEY_PORTFOLIO_DISCOUNT
+                     " must be within the range (0, 1]");
+        return -1;
+    }
+
+    data->explore = hcfg_real(search_cfg, CFGKEY_PORTFOLIO_EXPLORE);
+    if (!(data->explore >= 0.0)) {
+        search_error("Configuration key " CFGKEY_PORTFOLIO_EXPLORE
+                     " must be non-negative");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Load each strategy listed in the PORTFOLIO_LIST configuration key,
+ * and register their configuration defaults.
+ */
+int open_arms(hplugin_data_t* data)
+{
+    const char* home = hcfg_get(search_cfg, CFGKEY_HARMONY_HOME);
+    int len = hcfg_arr_len(search_cfg, CFGKEY_PORTFOLIO_LIST);
+    char name[128];
+
+    if (len < 1) {
+        search_error("Configuration key " CFGKEY_PORTFOLIO_LIST
+                     " is empty");
+        return -1;
+    }
+
+    for (int i = 0; i < len; ++i) {
+        int count = hcfg_arr_get(search_cfg, CFGKEY_PORTFOLIO_LIST, i,
+                                 name, sizeof(name));
+        if (count < 1 || count >= (int) sizeof(name)) {
+            search_error("Invalid entry in " CFGKEY_PORTFOLIO_LIST);
+            return -1;
+        }
+
+        if (strcmp(name, "portfolio.so") == 0) {
+            search_error("Portfolio strategies may not be nested");
+            return -1;
+        }
+
+        if (snprintf_grow(&data->buf, &data->buf_len,
+                          "%s/libexec/%s", home, name) < 0)
+        {
+            search_error("Could not allocate full pathname for plug-in");
+            return -1;
+        }
+
+        if (data->arm_len == data->arm_cap) {
+            if (array_grow(&data->arm, &data->arm_cap,
+                           sizeof(*data->arm)) != 0)
+            {
+                search_error("Could not grow strategy list");
+                return -1;
+            }
+        }
+
+        const char* errstr;
+        hplugin_t* plugin = &data->arm[data->arm_len].plugin;
+        if (hplugin_open(plugin, data->buf, &errstr) != 0) {
+            search_error(errstr);
+            return -1;
+        }
+        ++data->arm_len;
+
+        if (plugin->type != HPLUGIN_STRATEGY) {
+            search_error("Portfolio entry is not a search strategy");
+            return -1;
+        }
+
+        // Keys set by the user, or by earlier plug-ins, take
+        // precedence over these defaults.
+        //
+        if (plugin->keyinfo &&
+            hcfg_reginfo((hcfg_t*) search_cfg, plugin->keyinfo) != 0)
+        {
+            search_error("Could not register default configuration");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Choose the untried and unconverged strategy with the highest upper
+ * confidence bound on its improvement rate.  Returns -1 if no such
+ * strategy exists.
+ */
+int select_arm(hplugin_data_t* data)
+{
+    double total = 0.0;
+    for (int i = 0; i < data->arm_len; ++i)
+        total += data->arm[i].count + data->arm[i].pending;
+
+    int choice = -1;
+    double choice_score = -HUGE_VAL;
+    for (int i = 0; i < data->arm_len; ++i) {
+        arm_t* arm = &data->arm[i];
+        double score;
+
+        if (arm->tried || arm->converged)
+            continue;
+
+        // Strategies start with an optimistic improvement rate.
+        // Pending points shrink the bonus, but not the rate.
+        //
+        double count = arm->count + arm->pending;
+        if (count > 0.0) {
+            score = (arm->count > 0.0) ? arm->gain / arm->count : 1.0;
+            score += data->explore * sqrt(log(1.0 + total) / count);
+        }
+        else {
+            score = HUGE_VAL;
+        }
+
+        if (choice_score < score) {
+            choice_score = score;
+            choice = i;
+        }
+    }
+    return choice;
+}
+
+/*
+ * Record the convergence status reported by the active strategy, and
+ * keep it out of the shared configuration.  Otherwise, layers would
+ * see the search converge as soon as any one strategy does.  All
+ * other changes take effect as usual.
+ */
+int filter_setcfg(void* data, const char* key, const char* val)
+{
+    hplugin_data_t* self = data;
+
+    if (self->active < 0 || strcmp(key, CFGKEY_CONVERGED) != 0)
+        return 0;
+
+    self->arm[self->active].converged = hcfg_parse_bool(val);
+    self->dirty = 1;
+    return 1;
+}
+
+/*
+ * Conclude a call into a strategy.  If it changed its convergence
+ * status, update the status of the portfolio as a whole.
+ */
+int finish_call(hplugin_data_t* data)
+{
+    data->active = -1;
+    if (!data->dirty)
+        return 0;
+
+    data->dirty = 0;
+    data->converged = 1;
+    for (int i = 0; i < data->arm_len; ++i) {
+        if (!data->arm[i].converged)
+            data->converged = 0;
+    }
+
+    if (search_setcfg(CFGKEY_CONVERGED, data->converged ? "1" : "0") != 0) {
+        search_error("Could not set convergence status");
+        return -1;
+    }
+    return 0;
+}
+
+int add_ticket(hplugin_data_t* data, unsigned local, int arm)
+{
+    if (data->ticket_len == data->ticket_cap) {
+        if (array_grow(&data->ticket, &data->ticket_cap,
+                       sizeof(*data->ticket)) != 0)
+        {
+            search_error("Could not grow pending point list");
+            return -1;
+        }
+    }
+
+    ticket_t* ticket = &data->ticket[data->ticket_len++];
+    ticket->id = data->next_id++;
+    ticket->local = local;
+    ticket->arm = arm;
+
+    return 0;
+}
+
+int find_ticket(hplugin_data_t* data, unsigned id)
+{
+    for (int i = 0; i < data->ticket_len; ++i) {
+        if (data->ticket[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Report a result to a single strategy, using the given point
+ * identifier in place of our own.
+ */
+int report(hplugin_data_t* data, int idx, htrial_t* trial, unsigned id)
+{
+    hpoint_t point = trial->point;
+    point.id = id;
+
+    htrial_t view = { point, trial->perf };
+    hplugin_t* plugin = &data->arm[idx].plugin;
+
+    data->active = idx;
+    if (plugin->strategy.analyze(plugin->data, &view) != 0)
+        return -1;
+
+    return finish_call(data);
+}
@@ -26,6 +26,25 @@
  * step of the algorithm.  As such, it is ideal for a parallel search
  * utilizing multiple nodes, for instance when integrated in OpenMP or
  * MPI programs.
+ *
+ * Setting PRO_ASYNC to a positive value enables an asynchronous
+ * variant which removes the barrier between simplex steps.  Whenever
+ * a client requests a point, the worst ranked idle vertex is
+ * reflected through the centroid of the remaining vertices, and the
+ * simplex is updated as soon as that candidate's performance arrives.
+ * A reflection which beats the best vertex is followed by an
+ * expansion, and one which fails to improve upon its own vertex is
+ * followed by a contraction.  If the contraction also fails, every
+ * idle vertex is shrunk toward the best vertex.  Slow clients
+ * therefore only delay their own vertex.
+ *
+ * PRO_ASYNC bounds the number of candidates under evaluation at once.
+ * Each vertex other than the best may have at most one, so the bound
+ * is effectively capped at N for an N-dimensional search space.
+ * Larger values keep more clients busy, but more decisions are made
+ * with a partially updated simplex, which tends to stall the search
+ * further from the optimum.  A value of 1 behaves much like the
+ * Nelder-Mead algorithm, and a value of 2 or 3 is a good compromise.
  */
 
 #include "hstrategy.h"
@@ -68,6 +87,9 @@ const hcfg_info_t hplugin_keyinfo[] = {
       "Multiplicative coefficient for simplex expansion step." },
     { CFGKEY_SHRINK, "0.5",
       "Multiplicative coefficient for simplex shrink step." },
+    { CFGKEY_CONTRACT, "0.5",
+      "Multiplicative coefficient for vertex contraction step.  Only "
+      "used in asynchronous mode." },
     { CFGKEY_FVAL_TOL, "0.0001",
       "Convergence test succeeds if difference between all vertex "
       "performance values fall below this value." },
@@ -76,6 +98,12 @@ const hcfg_info_t hplugin_keyinfo[] = {
       "than this percentage of the total search space.  Simplex radius "
       "is measured from centroid to furthest vertex.  Total search space "
       "is measured from minimum to maximum point." },
+    { CFGKEY_PRO_ASYNC, "0",
+      "Maximum number of points under evaluation at once in asynchronous "
+      "mode, where the simplex is updated as each result arrives instead "
+      "of after every vertex of a step has been evaluated.  The value is "
+      "capped at the number of search space dimensions.  Zero selects "
+      "the synchronous algorithm." },
     { NULL }
 };
 
@@ -93,6 +121,7 @@ typedef enum simplex_state {
     SIMPLEX_STATE_REFLECT,
     SIMPLEX_STATE_EXPAND_ONE,
     SIMPLEX_STATE_EXPAND_ALL,
+    SIMPLEX_STATE_CONTRACT, // Only used in asynchronous mode.
     SIMPLEX_STATE_SHRINK,
     SIMPLEX_STATE_CONVERGED,
 
@@ -111,10 +140,13 @@ struct hplugin_data {
     vertex_t        init_point;
     double          init_radius;
     reject_method_t reject_type;
+    int             perf_n;
+    int             async;
 
     double reflect_val;
     double expand_val;
     double shrink_val;
+    double contract_val;
     double fval_tol;
     double size_tol;
 
@@ -132,6 +164,14 @@ struct hplugin_data {
     int        next_id;
     int        send_idx;
     int        reported;
+
+    // Asynchronous mode state.  Vertex i has a candidate under
+    // evaluation whenever pending.vertex[i] has a non-zero ID, and
+    // origin.vertex[i] holds the centroid it was moved through.
+    simplex_t        pending;
+    simplex_t        origin;
+    simplex_state_t* action;
+    hperf_t          penalty;
 };
 
 /*
@@ -142,6 +182,17 @@ static int pro_algorithm(hplugin_data_t* data);
 static int pro_next_state(hplugin_data_t* data);
 static int pro_next_simplex(hplugin_data_t* data);
 static int check_convergence(hplugin_data_t* data);
+static int update_best(hplugin_data_t* data, htrial_t* trial);
+static int async_init(hplugin_data_t* data);
+static int async_generate(hplugin_data_t* data, hflow_t* flow,
+                          hpoint_t* point);
+static int async_rejected(hplugin_data_t* data, hflow_t* flow,
+                          hpoint_t* point);
+static int async_analyze(hplugin_data_t* data, htrial_t* trial);
+static int async_select(hplugin_data_t* data);
+static int async_candidate(hplugin_data_t* data, int idx);
+static int async_report(hplugin_data_t* data, int idx, const hperf_t* perf);
+static int async_find(hplugin_data_t* data, int id);
 
 /*
  * Allocate memory for a new search task.
@@ -177,6 +228,21 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
             search_error("Could not initialize expansion simplex");
             return -1;
         }
+
+        if (simplex_init(&data->pending, space->len) != 0 ||
+            simplex_init(&data->origin, space->len) != 0)
+        {
+            search_error("Could not initialize asynchronous simplexes");
+            return -1;
+        }
+
+        simplex_state_t* action = realloc(data->action, (space->len + 1) *
+                                          sizeof(*action));
+        if (!action) {
+            search_error("Could not allocate asynchronous vertex states");
+            return -1;
+        }
+        data->action = action;
         data->space = space;
     }
 
@@ -197,6 +263,9 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
 
     data->send_idx = 0;
     data->state = SIMPLEX_STATE_INIT;
+    if (data->async)
+        return async_init(data);
+
     if (pro_next_simplex(data) != 0) {
         search_error("Could not initiate the simplex");
         return -1;
@@ -211,6 +280,9 @@ int strategy_init(hplugin_data_t* data, hspace_t* space)
  */
 int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
 {
+    if (data->async)
+        return async_generate(data, flow, point);
+
     if (data->send_idx > data->space->len ||
         data->state == SIMPLEX_STATE_CONVERGED)
     {
@@ -240,6 +312,9 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
     int reject_idx;
     hpoint_t* hint = &flow->point;
 
+    if (data->async)
+        return async_rejected(data, flow, point);
+
     // Find the rejected vertex.
     for (reject_idx = 0; reject_idx <= data->space->len; ++reject_idx) {
         if (data->next->vertex[reject_idx].id == point->id)
@@ -270,7 +345,15 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
             // Apply an infinite penalty to the invalid point and
             // allow the algorithm to determine the next point to try.
             //
-            hperf_reset(&data->next->vertex[reject_idx].perf);
+            hperf_t* perf = &data->next->vertex[reject_idx].perf;
+
+            // Vertices which were never tested have no objectives yet.
+            if (hperf_init(perf, data->perf_n) != 0) {
+                search_error("Could not allocate penalty performance");
+                return -1;
+            }
+            perf->len = data->perf_n;
+            hperf_reset(perf);
             ++data->reported;
 
             if (data->reported > data->space->len) {
@@ -325,6 +408,10 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
 int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
 {
     int report_idx;
+
+    if (data->async)
+        return async_analyze(data, trial);
+
     for (report_idx = 0; report_idx <= data->space->len; ++report_idx) {
         if (data->next->vertex[report_idx].id == trial->point.id)
             break;
@@ -348,20 +435,7 @@ int strategy_analyze(hplugin_data_t* data, htrial_t* trial)
         data->reported = 0;
         data->send_idx = 0;
     }
-
-    // Update the best performing point, if necessary.
-    if (!data->best.id || hperf_cmp(&data->best_perf, &trial->perf) > 0) {
-        if (hperf_copy(&data->best_perf, &trial->perf) != 0) {
-            search_error("Could not store best performance during analyze");
-            return -1;
-        }
-
-        if (hpoint_copy(&data->best, &trial->point) != 0) {
-            search_error("Could not copy best point during analyze");
-            return -1;
-        }
-    }
-    return 0;
+    return update_best(data, trial);
 }
 
 /*
@@ -381,6 +455,10 @@ int strategy_best(hplugin_data_t* data, hpoint_t* point)
  */
 int strategy_fini(hplugin_data_t* data)
 {
+    hperf_fini(&data->penalty);
+    free(data->action);
+    simplex_fini(&data->origin);
+    simplex_fini(&data->pending);
     vertex_fini(&data->centroid);
     simplex_fini(&data->expand);
     simplex_fini(&data->reflect);
@@ -439,6 +517,20 @@ int config_strategy(hplugin_data_t* data)
         }
     }
 
+    data->async = hcfg_int(search_cfg, CFGKEY_PRO_ASYNC);
+    if (data->async < 0) {
+        search_error("Configuration key " CFGKEY_PRO_ASYNC
+                     " must be non-negative");
+        return -1;
+    }
+
+    data->perf_n = hcfg_int(search_cfg, CFGKEY_PERF_COUNT);
+    if (data->perf_n < 1) {
+        search_error("Invalid value for " CFGKEY_PERF_COUNT
+                     " configuration key");
+        return -1;
+    }
+
     cfgval = hcfg_real(search_cfg, CFGKEY_REFLECT);
     if (isnan(cfgval) || cfgval <= 0.0) {
         search_error("Configuration key " CFGKEY_REFLECT
@@ -463,6 +555,14 @@ int config_strategy(hplugin_data_t* data)
     }
     data->shrink_val = cfgval;
 
+    cfgval = hcfg_real(search_cfg, CFGKEY_CONTRACT);
+    if (isnan(cfgval) || cfgval <= 0.0 || cfgval >= 1.0) {
+        search_error("Configuration key " CFGKEY_CONTRACT
+                     " must be between 0.0 and 1.0 (exclusive)");
+        return -1;
+    }
+    data->contract_val = cfgval;
+
     cfgval = hcfg_real(search_cfg, CFGKEY_FVAL_TOL);
     if (isnan(cfgval)) {
         search_error("Configuration key " CFGKEY_FVAL_TOL " is invalid");
@@ -701,3 +801,356 @@ int check_convergence(hplugin_data_t* data)
     search_setcfg(CFGKEY_CONVERGED, "1");
     return 0;
 }
+
+/*
+ * Update the best performing point, if necessary.
+ */
+int update_best(hplugin_data_t* data, htrial_t* trial)
+{
+    if (!data->best.id || hperf_cmp(&data->best_perf, &trial->perf) > 0) {
+        if (hperf_copy(&data->best_perf, &trial->perf) != 0) {
+            search_error("Could not store best performance during analyze");
+            return -1;
+        }
+
+        if (hpoint_copy(&data->best, &trial->point) != 0) {
+            search_error("Could not copy best point during analyze");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Prepare the asynchronous variant.  Every vertex of the initial
+ * simplex is tested before any vertex is moved.
+ */
+int async_init(hplugin_data_t* data)
+{
+    for (int i = 0; i < data->simplex.len; ++i) {
+        data->pending.vertex[i].id = 0;
+        data->action[i] = SIMPLEX_STATE_INIT;
+    }
+
+    if (hperf_init(&data->penalty, data->perf_n) != 0) {
+        search_error("Could not allocate penalty performance");
+        return -1;
+    }
+    data->penalty.len = data->perf_n;
+    hperf_reset(&data->penalty);
+
+    data->best_base = 0;
+    data->reported = 0;
+    return 0;
+}
+
+/*
+ * Issue a candidate for the next vertex to be moved, unless the limit
+ * of candidates under evaluation has been reached.
+ */
+int async_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    int idx = -1;
+    int busy = 0;
+
+    for (int i = 0; i < data->simplex.len; ++i) {
+        if (data->pending.vertex[i].id)
+            ++busy;
+    }
+
+    if (busy >= data->async || data->state == SIMPLEX_STATE_CONVERGED) {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    if (data->state == SIMPLEX_STATE_INIT) {
+        for (int i = 0; i < data->simplex.len; ++i) {
+            if (data->action[i] == SIMPLEX_STATE_INIT &&
+                !data->pending.vertex[i].id)
+            {
+                if (vertex_copy(&data->pending.vertex[i],
+                                &data->simplex.vertex[i]) != 0)
+                {
+                    search_error("Could not copy initial simplex vertex");
+                    return -1;
+                }
+                idx = i;
+                break;
+            }
+        }
+    }
+    else {
+        while ((idx = async_select(data)) >= 0) {
+            int retval = async_candidate(data, idx);
+            if (retval < 0)
+                return -1;
+            if (retval == 0)
+                break;
+        }
+    }
+
+    if (idx < 0) {
+        flow->status = HFLOW_WAIT;
+        return 0;
+    }
+
+    vertex_t* cand = &data->pending.vertex[idx];
+    cand->id = data->next_id;
+    if (vertex_point(cand, data->space, point) != 0) {
+        search_error("Could not copy point during generate");
+        return -1;
+    }
+    ++data->next_id;
+
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+/*
+ * Regenerate a candidate deemed invalid by a later plug-in.
+ */
+int async_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
+{
+    hpoint_t* hint = &flow->point;
+
+    int idx = async_find(data, point->id);
+    if (idx < 0) {
+        search_error("Could not find rejected point");
+        return -1;
+    }
+    vertex_t* cand = &data->pending.vertex[idx];
+
+    if (hint && hint->id) {
+        // Replace the candidate with the hint point, but keep the
+        // original ID so the vertex may still be found by analyze.
+        //
+        hint->id = point->id;
+        if (vertex_set(cand, data->space, hint) != 0) {
+            search_error("Could not copy hint into simplex during reject");
+            return -1;
+        }
+
+        if (hpoint_copy(point, hint) != 0) {
+            search_error("Could not return hint during reject");
+            return -1;
+        }
+    }
+    else if (data->reject_type == REJECT_METHOD_PENALTY) {
+        // Report an infinite penalty for the invalid point, and
+        // offer the next candidate in its place.
+        //
+        if (async_report(data, idx, &data->penalty) != 0)
+            return -1;
+
+        return async_generate(data, flow, point);
+    }
+    else if (data->reject_type == REJECT_METHOD_RANDOM) {
+        // Replace the rejected point with a random point.
+        if (vertex_random(cand, data->space, 1.0) != 0) {
+            search_error("Could not make random point during reject");
+            return -1;
+        }
+        cand->id = point->id;
+
+        if (vertex_point(cand, data->space, point) != 0) {
+            search_error("Could not convert vertex during reject");
+            return -1;
+        }
+    }
+    flow->status = HFLOW_ACCEPT;
+    return 0;
+}
+
+int async_analyze(hplugin_data_t* data, htrial_t* trial)
+{
+    int idx = async_find(data, trial->point.id);
+    if (idx >= 0) {
+        if (async_report(data, idx, &trial->perf) != 0)
+            return -1;
+    }
+    return update_best(data, trial);
+}
+
+/*
+ * Choose the next vertex to move.  Pending expansions and shrinks
+ * are tested first, since they complete an earlier step.  Otherwise,
+ * the worst ranked idle vertex is chosen.  Returns -1 if every
+ * vertex is busy.
+ */
+int async_select(hplugin_data_t* data)
+{
+    int idx = -1;
+
+    for (int i = 0; i < data->simplex.len; ++i) {
+        if (data->pending.vertex[i].id)
+            continue;
+
+        if (data->action[i] == SIMPLEX_STATE_EXPAND_ONE ||
+            data->action[i] == SIMPLEX_STATE_SHRINK)
+            return i;
+
+        if (i == data->best_base)
+            continue;
+
+        if (idx < 0 || hperf_cmp(&data->simplex.vertex[i].perf,
+                                 &data->simplex.vertex[idx].perf) > 0)
+            idx = i;
+    }
+    return idx;
+}
+
+/*
+ * Build the candidate for vertex idx from its next action.
+ * Out-of-bounds reflections fall back to a contraction, which remains
+ * in bounds, and out-of-bounds expansions are abandoned.  Returns 1
+ * if the vertex has no candidate to offer.
+ */
+int async_candidate(hplugin_data_t* data, int idx)
+{
+    vertex_t* vertex = &data->simplex.vertex[idx];
+    vertex_t* cand = &data->pending.vertex[idx];
+    vertex_t* origin = &data->origin.vertex[idx];
+
+    switch (data->action[idx]) {
+    case SIMPLEX_STATE_EXPAND_ONE:
+        // The vertex holds the accepted reflection.  Extend it
+        // further from the centroid it was reflected through.
+        //
+        vertex_transform(vertex, origin,
+                         data->expand_val / data->reflect_val - 1.0, cand);
+        if (vertex_inbounds(cand, data->space))
+            break;
+
+        data->action[idx] = SIMPLEX_STATE_REFLECT;
+        if (idx == data->best_base)
+            return 1; // The best vertex is not reflected.
+
+        // fall through
+    case SIMPLEX_STATE_REFLECT: {
+        // Reflect the vertex through the centroid of the others.
+        unsigned stashed_id = vertex->id;
+        vertex->id = 0;
+        if (simplex_centroid(&data->simplex, origin) != 0) {
+            search_error("Could not calculate simplex centroid");
+            return -1;
+        }
+        vertex->id = stashed_id;
+
+        vertex_transform(origin, vertex, data->reflect_val, cand);
+        if (vertex_inbounds(cand, data->space))
+            break;
+
+        data->action[idx] = SIMPLEX_STATE_CONTRACT;
+    }
+        // fall through
+    case SIMPLEX_STATE_CONTRACT:
+        vertex_transform(vertex, origin, -data->contract_val, cand);
+        break;
+
+    case SIMPLEX_STATE_SHRINK:
+        vertex_transform(vertex, &data->simplex.vertex[data->best_base],
+                         -data->shrink_val, cand);
+        break;
+
+    default:
+        search_error("Invalid asynchronous PRO vertex state");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Fold the performance of a candidate into the simplex, and choose
+ * the next action for its vertex.
+ */
+int async_report(hplugin_data_t* data, int idx, const hperf_t* perf)
+{
+    vertex_t* vertex = &data->simplex.vertex[idx];
+    vertex_t* cand = &data->pending.vertex[idx];
+    int accept = 0;
+
+    if (hperf_copy(&cand->perf, perf) != 0) {
+        search_error("Could not store candidate performance");
+        return -1;
+    }
+
+    switch (data->action[idx]) {
+    case SIMPLEX_STATE_INIT:
+        accept = 1;
+        data->action[idx] = SIMPLEX_STATE_REFLECT;
+        ++data->reported;
+        break;
+
+    case SIMPLEX_STATE_REFLECT:
+        accept = hperf_cmp(&cand->perf, &vertex->perf) < 0;
+        if (hperf_cmp(&cand->perf,
+                      &data->simplex.vertex[data->best_base].perf) < 0)
+            data->action[idx] = SIMPLEX_STATE_EXPAND_ONE;
+        else if (!accept)
+            data->action[idx] = SIMPLEX_STATE_CONTRACT;
+        break;
+
+    case SIMPLEX_STATE_EXPAND_ONE:
+        accept = hperf_cmp(&cand->perf, &vertex->perf) < 0;
+        data->action[idx] = SIMPLEX_STATE_REFLECT;
+        break;
+
+    case SIMPLEX_STATE_CONTRACT:
+        accept = hperf_cmp(&cand->perf, &vertex->perf) < 0;
+        if (accept) {
+            data->action[idx] = SIMPLEX_STATE_REFLECT;
+        }
+        else {
+            // Shrink every vertex not currently under evaluation.
+            for (int i = 0; i < data->simplex.len; ++i) {
+                if (i != data->best_base &&
+                    (!data->pending.vertex[i].id || i == idx))
+                    data->action[i] = SIMPLEX_STATE_SHRINK;
+            }
+        }
+        break;
+
+    case SIMPLEX_STATE_SHRINK:
+        accept = 1;
+        data->action[idx] = SIMPLEX_STATE_REFLECT;
+        break;
+
+    default:
+        search_error("Invalid asynchronous PRO vertex state");
+        return -1;
+    }
+
+    if (accept && vertex_copy(vertex, cand) != 0) {
+        search_error("Could not update simplex vertex");
+        return -1;
+    }
+    cand->id = 0;
+
+    if (data->state == SIMPLEX_STATE_INIT) {
+        if (data->reported < data->simplex.len)
+            return 0;
+        data->state = SIMPLEX_STATE_REFLECT;
+    }
+
+    for (int i = 0; i < data->simplex.len; ++i) {
+        if (hperf_cmp(&data->simplex.vertex[i].perf,
+                      &data->simplex.vertex[data->best_base].perf) < 0)
+            data->best_base = i;
+    }
+
+    // A vertex awaiting a shrink may have become the best vertex.
+    if (data->action[data->best_base] == SIMPLEX_STATE_SHRINK &&
+        !data->pending.vertex[data->best_base].id)
+        data->action[data->best_base] = SIMPLEX_STATE_REFLECT;
+
+    return check_convergence(data);
+}
+
+int async_find(hplugin_data_t* data, int id)
+{
+    for (int i = 0; i < data->pending.len; ++i) {
+        if (data->pending.vertex[i].id == id)
+            return i;
+    }
+    return -1;
+}
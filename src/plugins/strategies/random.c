@@ -27,6 +27,20 @@
  *
  * It is mainly used as a basis of comparison for more intelligent
  * search strategies.
+ *
+ * Independent random values tend to clump together, leaving other
+ * regions of the search space unexplored.  For screening runs, the
+ * SAMPLE_METHOD configuration key selects a space-filling design
+ * instead:
+ *
+ * - **uniform** - Independent pseudo-random values (default).
+ * - **sobol** - A scrambled Sobol sequence.  Every prefix of the
+ *   sequence covers the search space evenly, so it suits searches
+ *   of unknown length.
+ * - **lhs** - Latin hypercube batches of SAMPLE_SIZE points.  Each
+ *   batch places exactly one point in each of SAMPLE_SIZE equal
+ *   slices of every dimension, so it suits searches with a fixed
+ *   budget.
  */
 
 #include "hstrategy.h"
@@ -36,6 +50,7 @@
 #include "hpoint.h"
 #include "hperf.h"
 #include "hutil.h"
+#include "libsample.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -49,6 +64,12 @@
  */
 const hcfg_info_t hplugin_keyinfo[] = {
     { CFGKEY_INIT_POINT, NULL, "Initial point begin testing from." },
+    { CFGKEY_SAMPLE_METHOD, NULL,
+      "Method used to generate points.  Valid values are uniform "
+      "(default), sobol, and lhs." },
+    { CFGKEY_SAMPLE_SIZE, "0",
+      "Number of points in each Latin hypercube batch.  A value of 0 "
+      "selects 10 times the number of search space dimensions." },
     { NULL }
 };
 
@@ -62,13 +83,14 @@ struct hplugin_data {
     double    best_perf;
 
     hpoint_t  next;
+    sampler_t sampler;
 };
 
 /*
  * Internal helper function prototypes.
  */
 static int  config_strategy(hplugin_data_t* data);
-static void randomize(hplugin_data_t* data, hpoint_t* point);
+static int  randomize(hplugin_data_t* data, hpoint_t* point);
 
 /*
  * Allocate memory for a new search task.
@@ -120,7 +142,8 @@ int strategy_generate(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
     }
 
     // Prepare a new random vertex for the next call to strategy_generate.
-    randomize(data, &data->next);
+    if (randomize(data, &data->next) != 0)
+        return -1;
     ++data->next.id;
 
     flow->status = HFLOW_ACCEPT;
@@ -142,7 +165,8 @@ int strategy_rejected(hplugin_data_t* data, hflow_t* flow, hpoint_t* point)
         }
     }
     else {
-        randomize(data, point);
+        if (randomize(data, point) != 0)
+            return -1;
     }
 
     flow->status = HFLOW_ACCEPT;
@@ -183,6 +207,7 @@ int strategy_best(hplugin_data_t* data, hpoint_t* point)
  */
 int strategy_fini(hplugin_data_t* data)
 {
+    sampler_fini(&data->sampler);
     hpoint_fini(&data->next);
     hpoint_fini(&data->best);
 
@@ -196,7 +221,32 @@ int strategy_fini(hplugin_data_t* data)
 
 int config_strategy(hplugin_data_t* data)
 {
-    const char* cfgval = hcfg_get(search_cfg, CFGKEY_INIT_POINT);
+    sample_method_t method = SAMPLE_METHOD_UNIFORM;
+    const char* cfgval = hcfg_get(search_cfg, CFGKEY_SAMPLE_METHOD);
+    if (cfgval) {
+        method = sample_method(cfgval);
+        if (method == SAMPLE_METHOD_UNKNOWN) {
+            search_error("Invalid value for " CFGKEY_SAMPLE_METHOD
+                         " configuration key");
+            return -1;
+        }
+    }
+
+    int size = hcfg_int(search_cfg, CFGKEY_SAMPLE_SIZE);
+    if (size < 0) {
+        search_error("Configuration key " CFGKEY_SAMPLE_SIZE
+                     " must not be negative");
+        return -1;
+    }
+    if (size == 0)
+        size = 10 * data->space->len;
+
+    if (sampler_init(&data->sampler, data->space->len, method, size) != 0) {
+        search_error("Could not initialize point sampler");
+        return -1;
+    }
+
+    cfgval = hcfg_get(search_cfg, CFGKEY_INIT_POINT);
     if (cfgval) {
         if (hpoint_parse(&data->next, cfgval, data->space) != 0) {
             search_error("Error parsing point from " CFGKEY_INIT_POINT);
@@ -209,13 +259,17 @@ int config_strategy(hplugin_data_t* data)
         }
     }
     else {
-        randomize(data, &data->next);
+        if (randomize(data, &data->next) != 0)
+            return -1;
     }
     return 0;
 }
 
-void randomize(hplugin_data_t* data, hpoint_t* point)
+int randomize(hplugin_data_t* data, hpoint_t* point)
 {
-    for (int i = 0; i < data->space->len; ++i)
-        point->term[i] = hrange_random(&data->space->dim[i], search_drand48());
+    if (sampler_point(&data->sampler, data->space, point) != 0) {
+        search_error("Could not generate random point");
+        return -1;
+    }
+    return 0;
 }
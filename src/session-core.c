@@ -23,6 +23,7 @@
 #include "hcfg.h"
 #include "hmesg.h"
 #include "hplugin.h"
+#include "harena.h"
 #include "hutil.h"
 #include "hsockutil.h"
 
@@ -39,7 +40,15 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+
+#if defined(__linux__)
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#else
 #include <sys/select.h>
+#endif
 
 /*
  * Structure to encapsulate a Harmony plug-in and its run-time state.
@@ -79,6 +88,7 @@ typedef struct hsearch {
     hflow_t flow;
     int     curr_layer;
     int     paused_id;
+    int     idle;       // Generation is blocked until the next event.
 
     // List of all points generated, but not yet returned to the strategy.
     htrial_t* pending;
@@ -89,12 +99,19 @@ typedef struct hsearch {
     int clients;
     int per_client;
 
+    // Memory for trial data, released in bulk when the search closes.
+    harena_t arena;
+
     // List of all trials (point/performance pairs) waiting for client fetch.
     int* ready;
     int  ready_head;
     int  ready_tail;
     int  ready_cap;
 
+    // Optional filter applied to plug-in configuration changes.
+    setcfg_func_t setcfg_filter;
+    void*         setcfg_data;
+
     char* buf;
     int   buf_len;
     const char* errmsg;
@@ -104,24 +121,38 @@ typedef struct hsearch {
  * Callback registration system.
  */
 typedef struct callback {
+    int        id;        // Unique identifier for this callback.
     int        fd;        // Listen on this file descriptor for incoming data.
+    int        timer;     // Non-zero for one-shot timer callbacks.
     int        layer_idx; // Return to this layer index when data is ready.
     cb_func_t  func;      // Call this function to process incoming data.
     void*      data;      // Instance-specific data pointer.
     hsearch_t* search;    // Search this callback is associated with.
+
+    struct timeval deadline; // Timer expiration for select() builds.
 } callback_t;
 
 callback_t* cbs; // List of callbacks.
 int         cbs_len;
 int         cbs_cap;
+int         cbs_next_id = 1; // Identifier 0 is reserved for STDIN_FILENO.
+
+/*
+ * Event loop state.  Linux builds multiplex file descriptors and
+ * timers with epoll and timerfd.  Other platforms fall back to
+ * select(), and track timer deadlines in user space.
+ */
+#define EVENT_MAX 64
 
 /*
- * Variables used for select().
+ * Maximum number of trials generated between checks for new events.
+ * Bounds the time spent in the generation loop when trials complete
+ * without client involvement (e.g., cache hits).
  */
-struct timeval  polltime;
-struct timeval* pollstate;
-fd_set fds;
-int maxfd;
+#define GENERATE_MAX 1024
+#if defined(__linux__)
+static int epoll_fd = -1;
+#endif
 
 /*
  * Other global variables.
@@ -155,6 +186,7 @@ static int        generate_trial(hsearch_t* search);
 static int        plugin_workflow(hsearch_t* search, int trial_idx);
 static int        workflow_transition(hsearch_t* search, int trial_idx);
 static hsearch_t* find_search(hmesg_t* mesg);
+static int        handle_event(int id);
 static int        handle_callback(callback_t* cb);
 static int        handle_session(hsearch_t* search, hmesg_t* mesg);
 static int        handle_join(hsearch_t* search, hmesg_t* mesg);
@@ -167,18 +199,30 @@ static int        handle_reject(hsearch_t* search, int trial_idx);
 static int        handle_command(hsearch_t* search, hmesg_t* mesg);
 static int        handle_wait(hsearch_t* search, int trial_idx);
 static int        extend_lists(hsearch_t* search, int target_cap);
+static void       reset_trials(hsearch_t* search);
 static void       reverse_array(void* ptr, int head, int tail);
 static int        update_state(hmesg_t* mesg, hsearch_t* search);
 static void       set_current(hsearch_t* search);
 
+/*
+ * Event loop helper function prototypes.
+ */
+static int  event_init(void);
+static void event_fini(void);
+static int  event_wait(int* ready, int cap, int block);
+static int  add_callback(int fd, int timer, long ms, int layer_idx,
+                         void* data, cb_func_t func);
+static int  find_callback(int id);
+static int  shared_fd(int fd, int skip);
+static void remove_callback(int idx);
+
 /*
  * Core session routines begin here.
  */
 int main(int argc, char* argv[])
 {
     struct stat sb;
-    int retval;
-    fd_set ready_fds;
+    int retval, ready[EVENT_MAX];
     hmesg_t mesg = HMESG_INITIALIZER;
 
     if (argc < 2) {
@@ -213,27 +257,35 @@ int main(int argc, char* argv[])
     }
 
     // Initialize global data structures.
-    pollstate = &polltime;
-    FD_ZERO(&fds);
-    FD_SET(STDIN_FILENO, &fds);
-    maxfd = STDIN_FILENO;
+    if (event_init() != 0) {
+        perror("Could not initialize session-core event loop");
+        return -1;
+    }
 
+    int busy = 0;
     while (1) {
-        ready_fds = fds;
-        retval = select(maxfd + 1, &ready_fds, NULL, NULL, pollstate);
-        if (retval < 0) {
-            perror("Error during main select loop of session-core");
+        int count, mesg_ready = 0;
+
+        // Block until a message, callback, or timer is ready.  Only
+        // poll if generation was cut short during the last iteration.
+        //
+        count = event_wait(ready, EVENT_MAX, !busy);
+        if (count < 0) {
+            perror("Error during main event loop of session-core");
+            retval = -1;
             break;
         }
 
         // Launch callbacks, if needed.
-        for (int i = 0; i < cbs_len; ++i) {
-            if (FD_ISSET(cbs[i].fd, &ready_fds))
-                handle_callback(&cbs[i]);
+        for (int i = 0; i < count; ++i) {
+            if (ready[i] == 0)
+                mesg_ready = 1;
+            else
+                handle_event(ready[i]);
         }
 
         // Handle hmesg_t, if needed.
-        if (FD_ISSET(STDIN_FILENO, &ready_fds)) {
+        if (mesg_ready) {
             retval = mesg_recv(STDIN_FILENO, &mesg);
             if (retval == 0) break;
             if (retval <  0) {
@@ -247,6 +299,7 @@ int main(int argc, char* argv[])
 
             set_current(search);
             search->flow.status = HFLOW_ACCEPT;
+            search->idle = 0;
 
             if (search->open) {
                 hcfg_set(&search->cfg, CFGKEY_CURRENT_CLIENT,
@@ -299,27 +352,43 @@ int main(int argc, char* argv[])
             search_cfg = NULL;
         }
 
-        // Generate more points to test.
+        // Generate more points to test.  A search that cannot make
+        // progress is left idle until an event arrives for it, so
+        // the event loop may block indefinitely.
+        //
+        int more, budget = GENERATE_MAX;
         do {
-            pollstate = NULL;
-            for (int i = 0; i < slist_cap; ++i) {
+            more = 0;
+            for (int i = 0; i < slist_cap && budget > 0; ++i) {
                 hsearch_t* search = slist[i];
 
-                if (!search || !search->open)
+                if (!search || !search->open || search->idle)
                     continue;
 
-                // Generate a single trial for this search.
-                set_current(search);
-                generate_trial(search);
-                set_current(NULL);
-
-                if (!pollstate && search->flow.status != HFLOW_WAIT &&
-                    search->pending_len < search->pending_cap)
-                {
-                    pollstate = &polltime;
+                if (search->pending_len < search->pending_cap) {
+                    int prev_len = search->pending_len;
+
+                    // Generate a single trial for this search.
+                    set_current(search);
+                    retval = generate_trial(search);
+                    set_current(NULL);
+                    --budget;
+
+                    // Keep generating if the strategy produced a trial,
+                    // even if a layer is holding it for now.
+                    if (retval == 0 &&
+                        (search->flow.status != HFLOW_WAIT ||
+                         search->pending_len > prev_len) &&
+                        search->pending_len < search->pending_cap)
+                    {
+                        more = 1;
+                        continue;
+                    }
                 }
+                search->idle = 1;
             }
-        } while (pollstate);
+        } while (more && budget > 0);
+        busy = (budget == 0);
     }
 
     for (int i = 0; i < slist_cap; ++i) {
@@ -331,6 +400,7 @@ int main(int argc, char* argv[])
     }
     free(slist);
     free(cbs);
+    event_fini();
     hmesg_fini(&mesg);
 
     return retval;
@@ -394,6 +464,10 @@ int open_search(hsearch_t* search, hmesg_t* mesg)
         return -1;
     }
 
+    // Trial data is allocated from the search arena.
+    search->best.arena = &search->arena;
+    search->flow.point.arena = &search->arena;
+
     if (extend_lists(search, expected * search->per_client) != 0)
         return -1;
 
@@ -439,12 +513,16 @@ int open_search(hsearch_t* search, hmesg_t* mesg)
     search->best.id = 0;
     search->paused_id = 0;
     search->clients = 1;
+    search->idle = 0;
     search->open = 1;
 
     set_current(search);
     for (int i = 0; i < search->pstack_len; ++i) {
         hplugin_t* plugin = &search->pstack[i].plugin;
 
+        // Callbacks registered during initialization belong to the
+        // generation side of this layer.
+        search->curr_layer = i;
         if (hplugin_init(plugin, &search->space) != 0)
             return -1;
     }
@@ -455,6 +533,12 @@ int open_search(hsearch_t* search, hmesg_t* mesg)
 
 void close_search(hsearch_t* search)
 {
+    // Release any callbacks or timers still registered by this search.
+    for (int i = cbs_len - 1; i >= 0; --i) {
+        if (cbs[i].search == search)
+            remove_callback(i);
+    }
+
     for (int i = search->pstack_len - 1; i >= 0; --i) {
         hplugin_t* plugin = &search->pstack[i].plugin;
 
@@ -464,6 +548,13 @@ void close_search(hsearch_t* search)
         if (hplugin_close(plugin, &search->errmsg) != 0)
             fprintf(stderr, "Error closing plug-in: %s\n", search->errmsg);
     }
+
+    // Release all trial data in bulk.
+    reset_trials(search);
+    harena_fini(&search->arena);
+
+    search->setcfg_filter = NULL;
+    search->setcfg_data = NULL;
     search->open = 0;
 }
 
@@ -479,6 +570,7 @@ void free_search(hsearch_t* search)
 
     hpoint_fini(&search->flow.point);
     hpoint_fini(&search->best);
+    harena_fini(&search->arena);
     hcfg_fini(&search->cfg);
     hspace_fini(&search->space);
 
@@ -596,8 +688,9 @@ int generate_trial(hsearch_t* search)
         return -1;
     }
 
-    // Reset the performance for this trial.
+    // Reset the performance and evaluation budget for this trial.
     hperf_reset(&trial->perf);
+    ((hpoint_t*) &trial->point)->budget = 0.0;
 
     // Call strategy generation routine.
     hplugin_t* strategy = &search->pstack[0].plugin;
@@ -651,7 +744,7 @@ int plugin_workflow(hsearch_t* search, int trial_idx)
         --search->pending_len;
 
         // Point generation attempts may begin again.
-        pollstate = &polltime;
+        search->idle = 0;
     }
     else if (search->curr_layer == search->pstack_len) {
         // Completed generation layers.  Enqueue trial in ready queue.
@@ -694,8 +787,12 @@ int workflow_transition(hsearch_t* search, int trial_idx)
         if (handle_reject(search, trial_idx) != 0)
             return -1;
 
-        if (search->flow.status == HFLOW_WAIT)
+        if (search->flow.status == HFLOW_WAIT) {
+            // The strategy has no replacement.  Release the trial.
+            ((hpoint_t*) &search->pending[trial_idx].point)->id = 0;
+            --search->pending_len;
             return 1;
+        }
 
         search->curr_layer = 1;
         break;
@@ -799,6 +896,40 @@ hsearch_t* find_search(hmesg_t* mesg)
     return NULL;
 }
 
+int handle_event(int id)
+{
+    int idx = find_callback(id);
+    if (idx < 0)
+        return 0; // Callback was removed after the event was collected.
+
+    // Operate on a copy, since the callback list may be modified
+    // during the callback.
+    callback_t cb = cbs[idx];
+    if (cb.timer) {
+#if defined(__linux__)
+        uint64_t expired;
+        if (read(cb.fd, &expired, sizeof(expired)) < 0 && errno != EAGAIN)
+            return -1;
+#endif
+        // Timers are one-shot.  Unregister before the callback runs
+        // so that it may safely re-arm itself.
+        remove_callback(idx);
+    }
+
+    if (!cb.search->open)
+        return 0;
+
+    set_current(cb.search);
+    int retval = handle_callback(&cb);
+    set_current(NULL);
+
+    if (retval != 0) {
+        fprintf(stderr, "Error in session-core callback: %s\n",
+                cb.search->errmsg);
+    }
+    return retval;
+}
+
 int handle_callback(callback_t* cb)
 {
     hsearch_t* search = cb->search;
@@ -808,8 +939,10 @@ int handle_callback(callback_t* cb)
     int  trial_idx, retval;
 
     search->curr_layer = cb->layer_idx;
+    search->idle = 0;
     int        idx    = abs(search->curr_layer);
     pstack_t*  pstack = &search->pstack[idx];
+    int        fd     = cb->timer ? cb->id : cb->fd;
 
     // The idx variable represents layer plug-in index for now.
     if (search->curr_layer < 0) {
@@ -822,19 +955,42 @@ int handle_callback(callback_t* cb)
     }
 
     if (*len < 1) {
+        if (cb->timer) {
+            // Timers may fire without any trials waiting in the layer.
+            cb->func(fd, cb->data, &search->flow, 0, NULL);
+            return 0;
+        }
         search->errmsg = "Callback on layer with empty waitlist";
         return -1;
     }
 
     // Prepare a list of htrial_t pointers.
     trial_list = malloc(*len * sizeof(htrial_t*));
+    if (!trial_list) {
+        search->errmsg = "Could not allocate callback trial list";
+        return -1;
+    }
     for (int i = 0; i < *len; ++i)
         trial_list[i] = &search->pending[ list[i] ];
 
     // Reusing idx to represent waitlist index.  (Shame on me.)
-    idx = cb->func(cb->fd, cb->data, &search->flow, *len, trial_list);
+    search->flow.status = HFLOW_ACCEPT;
+    idx = cb->func(fd, cb->data, &search->flow, *len, trial_list);
     free(trial_list);
 
+    // A negative index indicates that no trial should be released.
+    if (idx < 0)
+        return 0;
+
+    if (idx >= *len) {
+        search->errmsg = "Invalid waitlist index returned by callback";
+        return -1;
+    }
+
+    // Trials that must keep waiting are already on the wait list.
+    if (search->flow.status == HFLOW_WAIT)
+        return 0;
+
     trial_idx = list[idx];
     retval = workflow_transition(search, trial_idx);
     if (retval < 0) return -1;
@@ -1112,12 +1268,41 @@ int extend_lists(hsearch_t* search, int target_cap)
         return -1;
     }
 
-    for (int i = orig_cap; i < search->pending_cap; ++i)
+    for (int i = orig_cap; i < search->pending_cap; ++i) {
         search->ready[i] = -1;
-
+        ((hpoint_t*) &search->pending[i].point)->arena = &search->arena;
+        search->pending[i].perf.arena = &search->arena;
+    }
     return 0;
 }
 
+/*
+ * Detach all trial data from the search arena, so the arena may be
+ * released in bulk.
+ */
+void reset_trials(hsearch_t* search)
+{
+    for (int i = 0; i < search->pending_cap; ++i) {
+        hpoint_t* point = (hpoint_t*) &search->pending[i].point;
+
+        for (int j = 0; j < point->cap; ++j)
+            hval_fini(&point->term[j]);
+        *point = hpoint_zero;
+        point->arena = &search->arena;
+
+        search->pending[i].perf = hperf_zero;
+        search->pending[i].perf.arena = &search->arena;
+    }
+
+    for (int i = 0; i < search->flow.point.cap; ++i)
+        hval_fini(&search->flow.point.term[i]);
+    search->flow.point = hpoint_zero;
+
+    for (int i = 0; i < search->best.cap; ++i)
+        hval_fini(&search->best.term[i]);
+    search->best = hpoint_zero;
+}
+
 void reverse_array(void* ptr, int head, int tail)
 {
     unsigned long* arr = (unsigned long*) ptr;
@@ -1137,6 +1322,256 @@ void set_current(hsearch_t* search)
     search_cfg     = &search->cfg;
 }
 
+/*
+ * Event loop helper function implementation.
+ */
+int event_init(void)
+{
+#if defined(__linux__)
+    struct epoll_event ev;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+        return -1;
+
+    ev.events  = EPOLLIN;
+    ev.data.fd = STDIN_FILENO;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &ev) != 0)
+        return -1;
+#endif
+    return 0;
+}
+
+void event_fini(void)
+{
+#if defined(__linux__)
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+    epoll_fd = -1;
+#endif
+}
+
+/*
+ * Wait until at least one event is ready, or only poll if block is
+ * zero.  Fill the ready array with the callback identifiers of ready
+ * events (0 for STDIN_FILENO), and return the number of entries
+ * filled.
+ */
+int event_wait(int* ready, int cap, int block)
+{
+    int count = 0;
+
+#if defined(__linux__)
+    struct epoll_event ev[EVENT_MAX];
+
+    if (cap > EVENT_MAX)
+        cap = EVENT_MAX;
+
+    int n = epoll_wait(epoll_fd, ev, cap, block ? -1 : 0);
+    if (n < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    // Each descriptor holds a single epoll registration, so report
+    // every callback that shares a ready descriptor.  Callbacks that
+    // do not fit are reported by the next (level-triggered) wait.
+    //
+    for (int i = 0; i < n; ++i) {
+        if (ev[i].data.fd == STDIN_FILENO) {
+            if (count < cap)
+                ready[count++] = 0;
+            continue;
+        }
+        for (int j = 0; j < cbs_len && count < cap; ++j) {
+            if (cbs[j].fd == ev[i].data.fd)
+                ready[count++] = cbs[j].id;
+        }
+    }
+#else
+    struct timeval now, timeout, *tptr = NULL;
+    fd_set fds;
+    int maxfd = STDIN_FILENO;
+
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+
+    // Find the nearest timer deadline, and collect callback descriptors.
+    if (!block) {
+        timeout.tv_sec  = 0;
+        timeout.tv_usec = 0;
+        tptr = &timeout;
+    }
+
+    gettimeofday(&now, NULL);
+    for (int i = 0; i < cbs_len; ++i) {
+        if (cbs[i].timer) {
+            long sec  = cbs[i].deadline.tv_sec  - now.tv_sec;
+            long usec = cbs[i].deadline.tv_usec - now.tv_usec;
+
+            if (usec < 0) {
+                usec += 1000000;
+                sec  -= 1;
+            }
+            if (sec < 0) {
+                sec  = 0;
+                usec = 0;
+            }
+
+            if (!tptr || sec < timeout.tv_sec ||
+                (sec == timeout.tv_sec && usec < timeout.tv_usec))
+            {
+                timeout.tv_sec  = sec;
+                timeout.tv_usec = usec;
+                tptr = &timeout;
+            }
+        }
+        else {
+            FD_SET(cbs[i].fd, &fds);
+            if (maxfd < cbs[i].fd)
+                maxfd = cbs[i].fd;
+        }
+    }
+
+    if (select(maxfd + 1, &fds, NULL, NULL, tptr) < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    gettimeofday(&now, NULL);
+    if (FD_ISSET(STDIN_FILENO, &fds))
+        ready[count++] = 0;
+
+    for (int i = 0; i < cbs_len && count < cap; ++i) {
+        if (cbs[i].timer) {
+            if (  cbs[i].deadline.tv_sec <  now.tv_sec
+                || (cbs[i].deadline.tv_sec == now.tv_sec &&
+                    cbs[i].deadline.tv_usec <= now.tv_usec))
+            {
+                ready[count++] = cbs[i].id;
+            }
+        }
+        else if (FD_ISSET(cbs[i].fd, &fds)) {
+            ready[count++] = cbs[i].id;
+        }
+    }
+#endif
+    return count;
+}
+
+/*
+ * Append a callback to the global list, and register it with the
+ * event loop.  Returns the new callback identifier, or -1 on error.
+ */
+int add_callback(int fd, int timer, long ms, int layer_idx,
+                 void* data, cb_func_t func)
+{
+    if (cbs_len >= cbs_cap) {
+        if (array_grow(&cbs, &cbs_cap, sizeof(*cbs)) != 0)
+            return -1;
+    }
+
+    callback_t* cb = &cbs[cbs_len];
+    cb->id        = cbs_next_id;
+    cb->fd        = fd;
+    cb->timer     = timer;
+    cb->search    = current_search;
+    cb->layer_idx = layer_idx;
+    cb->data      = data;
+    cb->func      = func;
+
+#if defined(__linux__)
+    struct epoll_event ev;
+
+    if (timer) {
+        struct itimerspec its;
+
+        cb->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (cb->fd < 0)
+            return -1;
+
+        // An all-zero it_value would disarm the timer, so expire
+        // zero-length timers after one nanosecond instead.
+        memset(&its, 0, sizeof(its));
+        its.it_value.tv_sec  = ms / 1000;
+        its.it_value.tv_nsec = (ms % 1000) * 1000000L;
+        if (ms == 0)
+            its.it_value.tv_nsec = 1;
+
+        if (timerfd_settime(cb->fd, 0, &its, NULL) != 0) {
+            close(cb->fd);
+            return -1;
+        }
+    }
+
+    // Descriptors shared by several callbacks keep the registration
+    // made by the first, since epoll refuses a second EPOLL_CTL_ADD.
+    ev.events  = EPOLLIN;
+    ev.data.fd = cb->fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, cb->fd, &ev) != 0 &&
+        (errno != EEXIST || shared_fd(cb->fd, cbs_len) < 0))
+    {
+        if (timer)
+            close(cb->fd);
+        return -1;
+    }
+#else
+    if (timer) {
+        gettimeofday(&cb->deadline, NULL);
+        cb->deadline.tv_sec  += ms / 1000;
+        cb->deadline.tv_usec += (ms % 1000) * 1000;
+        if (cb->deadline.tv_usec >= 1000000) {
+            cb->deadline.tv_usec -= 1000000;
+            cb->deadline.tv_sec  += 1;
+        }
+    }
+#endif
+
+    // Skip identifier 0 (STDIN_FILENO) if the counter wraps.
+    if (++cbs_next_id <= 0)
+        cbs_next_id = 1;
+
+    ++cbs_len;
+    return cb->id;
+}
+
+int find_callback(int id)
+{
+    for (int i = 0; i < cbs_len; ++i) {
+        if (cbs[i].id == id)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Find another file descriptor callback (other than the one at index
+ * skip) that watches the given descriptor.  Returns its index, or -1
+ * if no such callback exists.
+ */
+int shared_fd(int fd, int skip)
+{
+    for (int i = 0; i < cbs_len; ++i) {
+        if (i != skip && !cbs[i].timer && cbs[i].fd == fd)
+            return i;
+    }
+    return -1;
+}
+
+void remove_callback(int idx)
+{
+#if defined(__linux__)
+    if (cbs[idx].timer) {
+        close(cbs[idx].fd); // Closing a timerfd removes it from epoll.
+    }
+    else if (shared_fd(cbs[idx].fd, idx) < 0) {
+        // The descriptor may already be closed by its plug-in.
+        struct epoll_event ev;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, cbs[idx].fd, &ev);
+    }
+#endif
+
+    --cbs_len;
+    if (idx < cbs_len)
+        memmove(&cbs[idx], &cbs[idx + 1], (cbs_len - idx) * sizeof(*cbs));
+}
+
 /*
  * Exported functions for pluggable modules.
  *
@@ -1160,21 +1595,9 @@ int search_best(hpoint_t* pt)
  */
 int search_callback_analyze(int fd, void* data, cb_func_t func)
 {
-    if (cbs_len >= cbs_cap) {
-        if (array_grow(&cbs, &cbs_cap, sizeof(*cbs)) != 0)
-            return -1;
-    }
-
-    cbs[ cbs_len ].fd        = fd;
-    cbs[ cbs_len ].search    = current_search;
-    cbs[ cbs_len ].layer_idx = -current_search->curr_layer;
-    cbs[ cbs_len ].data      = data;
-    cbs[ cbs_len ].func      = func;
-    ++cbs_len;
-
-    FD_SET(fd, &fds);
-    if (maxfd < fd)
-        maxfd = fd;
+    if (add_callback(fd, 0, 0, -current_search->curr_layer,
+                     data, func) < 0)
+        return -1;
 
     return 0;
 }
@@ -1184,22 +1607,44 @@ int search_callback_analyze(int fd, void* data, cb_func_t func)
  */
 int search_callback_generate(int fd, void* data, cb_func_t func)
 {
-    if (cbs_len >= cbs_cap) {
-        if (array_grow(&cbs, &cbs_cap, sizeof(*cbs)) != 0)
-            return -1;
+    if (add_callback(fd, 0, 0, current_search->curr_layer,
+                     data, func) < 0)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Register a one-shot timer that expires after the given number of
+ * milliseconds.  The callback is associated with the workflow side
+ * (generate or analyze) of the layer active at registration time, and
+ * receives the timer identifier in place of a file descriptor.
+ *
+ * Returns a positive timer identifier, or -1 on error.
+ */
+int search_timer(long ms, void* data, cb_func_t func)
+{
+    if (ms < 0) {
+        search_error("Invalid timer duration");
+        return -1;
     }
 
-    cbs[ cbs_len ].fd        = fd;
-    cbs[ cbs_len ].search    = current_search;
-    cbs[ cbs_len ].layer_idx = current_search->curr_layer;
-    cbs[ cbs_len ].data      = data;
-    cbs[ cbs_len ].func      = func;
-    ++cbs_len;
+    int id = add_callback(-1, 1, ms, current_search->curr_layer, data, func);
+    if (id < 0)
+        search_error("Could not register timer");
+    return id;
+}
 
-    FD_SET(fd, &fds);
-    if (maxfd < fd)
-        maxfd = fd;
+/*
+ * Cancel a pending timer registered by search_timer().
+ */
+int search_timer_cancel(int id)
+{
+    int idx = find_callback(id);
+    if (idx < 0 || !cbs[idx].timer || cbs[idx].search != current_search)
+        return -1;
 
+    remove_callback(idx);
     return 0;
 }
 
@@ -1216,13 +1661,17 @@ void search_error(const char* msg)
  */
 int search_restart(void)
 {
+    int curr_layer = current_search->curr_layer;
+
     // Re-initialize all plug-ins associated with this search.
     for (int i = 0; i < current_search->pstack_len; ++i) {
         hplugin_t* plugin = &current_search->pstack[i].plugin;
 
+        current_search->curr_layer = i;
         if (hplugin_init(plugin, &current_search->space) != 0)
             return -1;
     }
+    current_search->curr_layer = curr_layer;
 
     return 0;
 }
@@ -1232,6 +1681,13 @@ int search_restart(void)
  */
 int search_setcfg(const char* key, const char* val)
 {
+    if (current_search->setcfg_filter) {
+        int retval = current_search->setcfg_filter(
+            current_search->setcfg_data, key, val);
+        if (retval != 0)
+            return (retval < 0) ? -1 : 0;
+    }
+
     if (hcfg_set(&current_search->cfg, key, val) != 0)
         return -1;
 
@@ -1250,6 +1706,21 @@ int search_setcfg(const char* key, const char* val)
     return 0;
 }
 
+/*
+ * Install a filter which sees every configuration change requested
+ * through search_setcfg() before it takes effect.  The filter returns
+ * 0 to let the change proceed, 1 to discard it, or -1 on error.  This
+ * allows a strategy which drives other strategies to keep their
+ * changes out of the shared configuration.  Passing a NULL function
+ * removes the filter.
+ */
+int search_setcfg_filter(void* data, setcfg_func_t func)
+{
+    current_search->setcfg_filter = func;
+    current_search->setcfg_data = data;
+    return 0;
+}
+
 /*
  * Return a session-specific pseudo-random double value.
  */
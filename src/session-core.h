@@ -53,6 +53,7 @@ typedef struct htrial {
 // Callback function signatures.
 typedef int (*cb_func_t)(int fd, void* data,
                          hflow_t* flow, int n, htrial_t** trial);
+typedef int (*setcfg_func_t)(void* data, const char* key, const char* val);
 
 /*
  * Interface for plug-in modules to access their associated search.
@@ -63,6 +64,9 @@ int      search_callback_analyze(int fd, void* data, cb_func_t func);
 void     search_error(const char* msg);
 int      search_restart(void);
 int      search_setcfg(const char* key, const char* val);
+int      search_setcfg_filter(void* data, setcfg_func_t func);
+int      search_timer(long ms, void* data, cb_func_t func);
+int      search_timer_cancel(int id);
 double   search_drand48(void);
 long int search_lrand48(void);
 